@@ -0,0 +1,223 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "banana.h"
+#include "backend.h"
+#include "config.h"
+#include "log.h"
+
+#define CLIENTS	   32
+#define ITERATIONS 20000
+#define WIDTH	   1920
+#define HEIGHT	   1080
+
+/* requests per iteration an action must stay within, ended by BACKEND_OPS */
+typedef struct {
+	EBackendOp op;
+	double	   min, max;
+} SExpect;
+
+static SClient	    *benchClients[CLIENTS];
+static int	     benchIndex = 0;
+static int	     failures	= 0;
+
+static const SExpect arrangeExpect[] = {
+    {BACKEND_MOVE_RESIZE_WINDOW, CLIENTS / 2, CLIENTS / 2},
+    {BACKEND_CONFIGURE_WINDOW, CLIENTS / 2, CLIENTS / 2},
+    {BACKEND_SET_WINDOW_BORDER, 0, 0},
+    {BACKEND_RESTACK_WINDOWS, 0, 1},
+    {BACKEND_OPS, 0, 0}};
+
+static const SExpect focusExpect[] = {{BACKEND_SET_WINDOW_BORDER, 2, 2},
+				      {BACKEND_SET_INPUT_FOCUS, 1, 1},
+				      {BACKEND_RESTACK_WINDOWS, 0, 1},
+				      {BACKEND_OPS, 0, 0}};
+
+static const SExpect switchExpect[] = {
+    {BACKEND_MAP_WINDOW, CLIENTS / 2, CLIENTS / 2},
+    {BACKEND_UNMAP_WINDOW, CLIENTS / 2, CLIENTS / 2},
+    {BACKEND_SET_INPUT_FOCUS, 1, 1},
+    {BACKEND_GRAB_SERVER, 0, 0},
+    {BACKEND_RESTACK_WINDOWS, 0, 1},
+    {BACKEND_OPS, 0, 0}};
+
+static const SExpect switchGrabExpect[] = {{BACKEND_GRAB_SERVER, 1, 1},
+					   {BACKEND_UNGRAB_SERVER, 1, 1},
+					   {BACKEND_SET_INPUT_FOCUS, 1, 1},
+					   {BACKEND_OPS, 0, 0}};
+
+/* one move out for the old workspace and one back for the new one */
+static const SExpect switchOffscreenExpect[] = {
+    {BACKEND_MOVE_WINDOW, CLIENTS, CLIENTS},
+    {BACKEND_MAP_WINDOW, CLIENTS / 2, CLIENTS / 2},
+    {BACKEND_UNMAP_WINDOW, 0, 0},
+    {BACKEND_SET_INPUT_FOCUS, 1, 1},
+    {BACKEND_OPS, 0, 0}};
+
+static double now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/* the state updateMonitors leaves behind for a single screen */
+static void setupMonitor(void)
+{
+	numMonitors = 1;
+	monitors    = calloc(1, sizeof(SMonitor));
+	if (!monitors) {
+		exit(1);
+	}
+
+	monitors[0].width	     = WIDTH;
+	monitors[0].height	     = HEIGHT;
+	monitors[0].currentLayout    = LAYOUT_TILED;
+	monitors[0].masterCount	     = 1;
+	monitors[0].masterFactors    = malloc(workspaceCount * sizeof(float));
+	monitors[0].workspaceLayouts = malloc(workspaceCount * sizeof(ELayout));
+	monitors[0].lastTiledClient  = calloc(workspaceCount, sizeof(Window));
+	if (!monitors[0].masterFactors || !monitors[0].workspaceLayouts ||
+	    !monitors[0].lastTiledClient) {
+		exit(1);
+	}
+
+	for (int ws = 0; ws < workspaceCount; ws++) {
+		monitors[0].masterFactors[ws]	 = defaultMasterFactor;
+		monitors[0].workspaceLayouts[ws] = LAYOUT_TILED;
+	}
+}
+
+/*
+ * half the clients on workspace 0 and half on 1, mapped and stacked like
+ * manageClient
+ */
+static void setupClients(void)
+{
+	SClient **tail = &clients;
+
+	for (int i = 0; i < CLIENTS; i++) {
+		SClient *client = calloc(1, sizeof(SClient));
+		if (!client) {
+			exit(1);
+		}
+
+		client->window	  = 0x200000 + i;
+		client->workspace = i % 2;
+		client->width	  = WIDTH / 2;
+		client->height	  = HEIGHT / 2;
+		snprintf(client->className, sizeof(client->className), "bench");
+
+		backend->moveResizeWindow(display, client->window, 0, 0,
+					  client->width, client->height);
+		if (client->workspace == 0) {
+			backend->mapWindow(display, client->window);
+		}
+
+		*tail		= client;
+		tail		= &client->next;
+		benchClients[i] = client;
+		raiseClient(client);
+	}
+}
+
+static void arrange(void)
+{
+	arrangeClients(&monitors[0]);
+}
+
+static void focus(void)
+{
+	benchIndex = (benchIndex + 2) % CLIENTS;
+	focusClient(benchClients[benchIndex]);
+}
+
+static void focusNext(void)
+{
+	focusWindowInStack("down");
+}
+
+static void switchWorkspace(void)
+{
+	switchToWorkspace(monitors[0].currentWorkspace ? "0" : "1");
+}
+
+/*
+ * every action runs against the fake backend so the time is the core alone
+ * and the counts are the requests the xlib backend would have sent, root
+ * properties are flushed after each one like the event loop does
+ */
+static void measure(const char	  *name, void (*action)(void),
+		    const SExpect *expect)
+{
+	/* the first run settles one-off state like borders and stacking */
+	action();
+	flushRootProperties();
+	resetFakeBackendCounts();
+
+	double start = now();
+	for (int i = 0; i < ITERATIONS; i++) {
+		action();
+		flushRootProperties();
+	}
+	double elapsed = now() - start;
+
+	printf("core %s: %.2f us, %.1f requests", name,
+	       elapsed / ITERATIONS / 1e3,
+	       (double)fakeBackendRequests() / ITERATIONS);
+
+	for (int op = 0; op < BACKEND_OPS; op++) {
+		uint64_t count = fakeBackendCount(op);
+		if (count) {
+			printf(", %s %.1f", backendOpName(op),
+			       (double)count / ITERATIONS);
+		}
+	}
+	printf("\n");
+
+	for (; expect->op != BACKEND_OPS; expect++) {
+		double count =
+		    (double)fakeBackendCount(expect->op) / ITERATIONS;
+		if (count < expect->min || count > expect->max) {
+			printf("core %s: %s %.1f outside %.1f to %.1f\n", name,
+			       backendOpName(expect->op), count, expect->min,
+			       expect->max);
+			failures++;
+		}
+	}
+}
+
+int main(void)
+{
+	logLevel = LOG_LEVEL_ERROR;
+	initDefaults();
+
+	/* the default colors match, which would hide the border requests */
+	free(inactiveBorderColor);
+	inactiveBorderColor = safeStrdup("#222222");
+
+	backend = &fakeBackend;
+	display = NULL;
+	root	= 1;
+	allocBorderColors();
+
+	setupMonitor();
+	setupClients();
+
+	printf("core: %d clients, %d iterations per action\n", CLIENTS,
+	       ITERATIONS);
+	measure("arrange", arrange, arrangeExpect);
+	measure("focus", focus, focusExpect);
+	measure("focus_next", focusNext, focusExpect);
+	measure("switch_workspace", switchWorkspace, switchExpect);
+
+	workspaceSwitch = WORKSPACE_SWITCH_GRAB;
+	measure("switch_workspace_grab", switchWorkspace, switchGrabExpect);
+	workspaceSwitch = WORKSPACE_SWITCH_OFFSCREEN;
+	measure("switch_workspace_offscreen", switchWorkspace,
+		switchOffscreenExpect);
+
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,137 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <signal.h>
+#include <fcntl.h>
+#include <time.h>
+#include <sys/stat.h>
+
+#include "launch.h"
+
+#define ITERATIONS 200
+#define RESIDENT   (128 * 1024 * 1024)
+
+static double now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/* what spawnProgram did before, kept to compare against */
+static void forkSpawn(const char *program)
+{
+	pid_t pid = fork();
+	if (pid == 0) {
+		setsid();
+
+		int devnull = open("/dev/null", O_RDWR);
+		if (devnull != -1) {
+			dup2(devnull, STDIN_FILENO);
+			dup2(devnull, STDOUT_FILENO);
+			dup2(devnull, STDERR_FILENO);
+			if (devnull > 2) {
+				close(devnull);
+			}
+		}
+
+		execl("/bin/sh", "sh", "-c", program, NULL);
+		_exit(EXIT_FAILURE);
+	}
+}
+
+static void launch(const char *program)
+{
+	spawnCommand(program);
+}
+
+/*
+ * the launched program stands in for the terminal binding, it reports when
+ * its main runs so the latency covers everything from the keypress handler
+ * calling spawn up to the new program executing
+ */
+static void run(const char *name, void (*spawn)(const char *),
+		const char *command, int fifo)
+{
+	double total = 0;
+	double worst = 0;
+
+	for (int i = 0; i < ITERATIONS; i++) {
+		double start = now();
+		double exec;
+
+		spawn(command);
+		if (read(fifo, &exec, sizeof(exec)) != sizeof(exec)) {
+			perror("read");
+			exit(1);
+		}
+
+		double latency = exec - start;
+		total += latency;
+		if (latency > worst) {
+			worst = latency;
+		}
+	}
+
+	printf("spawn %s: %.1f us average, %.1f us worst\n", name,
+	       total / ITERATIONS / 1e3, worst / 1e3);
+}
+
+int main(int argc, char **argv)
+{
+	if (argc == 3 && strcmp(argv[1], "--exec") == 0) {
+		double exec = now();
+		int    fd   = open(argv[2], O_WRONLY);
+		if (fd == -1 ||
+		    write(fd, &exec, sizeof(exec)) != sizeof(exec)) {
+			return 1;
+		}
+		return 0;
+	}
+
+	char self[4096];
+	char dir[] = "/tmp/banana-bench-XXXXXX";
+	char fifoPath[4200];
+	char command[8400];
+
+	ssize_t len = readlink("/proc/self/exe", self, sizeof(self) - 1);
+	if (len == -1 || !mkdtemp(dir)) {
+		perror("banana-bench");
+		return 1;
+	}
+	self[len] = '\0';
+
+	snprintf(fifoPath, sizeof(fifoPath), "%s/exec", dir);
+	snprintf(command, sizeof(command), "%s --exec %s", self, fifoPath);
+
+	if (mkfifo(fifoPath, 0600) == -1) {
+		perror("mkfifo");
+		return 1;
+	}
+
+	int fifo = open(fifoPath, O_RDWR);
+	if (fifo == -1) {
+		perror("open");
+		return 1;
+	}
+
+	signal(SIGCHLD, SIG_IGN);
+
+	/* a window manager with pango, cairo and glib mapped is not small */
+	char *resident = malloc(RESIDENT);
+	if (resident) {
+		memset(resident, 1, RESIDENT);
+	}
+
+	printf("spawn: %d launches, %d MiB resident\n", ITERATIONS,
+	       RESIDENT / 1024 / 1024);
+	run("fork+sh", forkSpawn, command, fifo);
+	run("posix_spawn", launch, command, fifo);
+
+	close(fifo);
+	unlink(fifoPath);
+	rmdir(dir);
+	free(resident);
+	return 0;
+}
@@ -0,0 +1,130 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <signal.h>
+#include <time.h>
+#include <sys/wait.h>
+
+#include "proc.h"
+
+#define CHAIN_DEPTH 10
+#define TERMINALS   50
+#define ITERATIONS  1000
+
+static pid_t spawnIdle(void)
+{
+	pid_t pid = fork();
+	if (pid == 0) {
+		pause();
+		_exit(0);
+	}
+	return pid;
+}
+
+/* terminal -> shell, the shell being what swallowing windows spawn from */
+static pid_t spawnTerminal(void)
+{
+	pid_t pid = fork();
+	if (pid == 0) {
+		spawnIdle();
+		pause();
+		_exit(0);
+	}
+	return pid;
+}
+
+/* writes the pid of the deepest process to fd once the chain is built */
+static pid_t spawnChain(int depth, int fd)
+{
+	pid_t pid = fork();
+	if (pid == 0) {
+		if (depth > 1) {
+			spawnChain(depth - 1, fd);
+		} else {
+			pid_t self = getpid();
+			if (write(fd, &self, sizeof(self)) != sizeof(self)) {
+				_exit(1);
+			}
+		}
+		pause();
+		_exit(0);
+	}
+	return pid;
+}
+
+static double now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/*
+ * one iteration is one map: the new window's pid is checked against every
+ * swallowing terminal, only the chain root matches
+ */
+static int run(const char *name, pid_t *terminals, pid_t leaf)
+{
+	int    matches = 0;
+	double start   = now();
+
+	for (int i = 0; i < ITERATIONS; i++) {
+		resetProcessCache();
+		for (int t = 0; t <= TERMINALS; t++) {
+			matches += isChildProcess(terminals[t], leaf);
+		}
+	}
+
+	double elapsed = now() - start;
+	printf("swallow %s: %.2f us per map, %.2f us per check, %d matches\n",
+	       name, elapsed / ITERATIONS / 1e3,
+	       elapsed / ITERATIONS / (TERMINALS + 1) / 1e3, matches);
+
+	return matches == ITERATIONS;
+}
+
+int main(void)
+{
+	pid_t terminals[TERMINALS + 1];
+	int   fds[2];
+
+	setpgid(0, 0);
+
+	for (int i = 0; i < TERMINALS; i++) {
+		terminals[i] = spawnTerminal();
+	}
+
+	if (pipe(fds) == -1) {
+		perror("pipe");
+		return 1;
+	}
+
+	terminals[TERMINALS] = spawnChain(CHAIN_DEPTH, fds[1]);
+
+	pid_t leaf = 0;
+	if (read(fds[0], &leaf, sizeof(leaf)) != sizeof(leaf)) {
+		perror("read");
+		signal(SIGTERM, SIG_IGN);
+		kill(0, SIGTERM);
+		return 1;
+	}
+
+	printf("swallow: %d terminals, %d level chain, %d maps\n", TERMINALS,
+	       CHAIN_DEPTH, ITERATIONS);
+
+	int ok = run("proc", terminals, leaf);
+
+	if (initProcessTracker() == 0) {
+		for (int t = 0; t <= TERMINALS; t++) {
+			trackProcess(terminals[t]);
+		}
+		handleProcessEvents();
+		ok &= run("tracker", terminals, leaf);
+		cleanupProcessTracker();
+	}
+
+	signal(SIGTERM, SIG_IGN);
+	kill(0, SIGTERM);
+	return ok ? 0 : 1;
+}
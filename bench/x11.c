@@ -0,0 +1,558 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <X11/Xlib.h>
+#include <X11/Xatom.h>
+#include <X11/Xutil.h>
+#include <X11/extensions/Xrandr.h>
+
+#include "ipc.h"
+
+#define DEFAULT_WINDOWS	 50
+#define DEFAULT_SWITCHES 20
+#define TIMEOUT_MS	 1000
+#define ADOPT_RUNS	 5
+#define ADOPT_TIMEOUT_MS 10000
+
+typedef struct {
+	const char *name;
+	double	   *samples;
+	int	    count;
+	int	    timeouts;
+} SSeries;
+
+static Display *display;
+static Window  *windows;
+static int	windowCount = DEFAULT_WINDOWS;
+static int	switchCount = DEFAULT_SWITCHES;
+static pid_t	bananaPid   = 0;
+
+static double	now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/* nanoseconds banana spent on a cpu, schedstat is far finer than stat */
+static double cpuTime(void)
+{
+	char path[64];
+
+	if (!bananaPid) {
+		return 0;
+	}
+
+	snprintf(path, sizeof(path), "/proc/%d/schedstat", (int)bananaPid);
+	FILE *fp = fopen(path, "r");
+	if (fp) {
+		unsigned long long ns = 0;
+		int		   ok = fscanf(fp, "%llu", &ns) == 1;
+		fclose(fp);
+		if (ok) {
+			return ns;
+		}
+	}
+
+	snprintf(path, sizeof(path), "/proc/%d/stat", (int)bananaPid);
+	fp = fopen(path, "r");
+	if (!fp) {
+		return 0;
+	}
+
+	char   buffer[1024];
+	size_t length = fread(buffer, 1, sizeof(buffer) - 1, fp);
+	fclose(fp);
+	buffer[length] = '\0';
+
+	char		  *p	 = strrchr(buffer, ')');
+	unsigned long long utime = 0, stime = 0;
+	if (!p || sscanf(p + 2,
+			 "%*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u "
+			 "%llu %llu",
+			 &utime, &stime) != 2) {
+		return 0;
+	}
+	return (utime + stime) * 1e9 / sysconf(_SC_CLK_TCK);
+}
+
+static int compareSamples(const void *a, const void *b)
+{
+	double x = *(const double *)a;
+	double y = *(const double *)b;
+	return (x > y) - (x < y);
+}
+
+static void report(SSeries *series)
+{
+	if (!series->count) {
+		printf("%s: no samples, %d timeouts\n", series->name,
+		       series->timeouts);
+		return;
+	}
+
+	double total = 0;
+	for (int i = 0; i < series->count; i++) {
+		total += series->samples[i];
+	}
+	qsort(series->samples, series->count, sizeof(double), compareSamples);
+
+	int p99 = series->count * 99 / 100;
+	printf("%s: %d samples, %.1f us average, %.1f us median, %.1f us p99, "
+	       "%.1f us worst, %d timeouts\n",
+	       series->name, series->count, total / series->count / 1e3,
+	       series->samples[series->count / 2] / 1e3,
+	       series->samples[p99 < series->count ? p99 : series->count - 1] /
+		   1e3,
+	       series->samples[series->count - 1] / 1e3, series->timeouts);
+}
+
+static void addSample(SSeries *series, double start, int done)
+{
+	if (done) {
+		series->samples[series->count++] = now() - start;
+	} else {
+		series->timeouts++;
+	}
+}
+
+static int ipcConnect(void)
+{
+	struct sockaddr_un addr;
+	const char	  *runtimeDir = getenv("XDG_RUNTIME_DIR");
+	const char	  *home	      = getenv("HOME");
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	if (runtimeDir && *runtimeDir) {
+		snprintf(addr.sun_path, sizeof(addr.sun_path), "%s/banana.sock",
+			 runtimeDir);
+	} else {
+		snprintf(addr.sun_path, sizeof(addr.sun_path),
+			 "%s/.banana.sock", home ? home : "/tmp");
+	}
+
+	int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+	if (fd != -1 && connect(fd, (struct sockaddr *)&addr, sizeof(addr))) {
+		close(fd);
+		fd = -1;
+	}
+
+	return fd;
+}
+
+static int ipcRun(const char *command)
+{
+	int fd = ipcConnect();
+	if (fd == -1) {
+		perror("connect");
+		exit(1);
+	}
+
+	SIPCHeader header = {IPC_COMMAND_RUN, 0, strlen(command)};
+	if (write(fd, &header, sizeof(header)) != sizeof(header) ||
+	    write(fd, command, header.length) != (ssize_t)header.length ||
+	    read(fd, &header, sizeof(header)) != sizeof(header)) {
+		perror("ipc");
+		exit(1);
+	}
+
+	close(fd);
+	return header.status;
+}
+
+/*
+ * waits until count events of the given type have arrived, for window only
+ * unless it is None, and gives up after TIMEOUT_MS, a sample is added to
+ * series when it is not NULL and the other event type is recorded in other
+ * when it shows up on the way, so a map and its configure can be timed
+ * against the same start
+ */
+static int waitEvents(int type, Window window, int count, double start,
+		      SSeries *series, int otherType, SSeries *other)
+{
+	double deadline	 = now() + TIMEOUT_MS * 1e6;
+	int    seenOther = !other;
+
+	while (count > 0 || !seenOther) {
+		while ((count > 0 || !seenOther) && XPending(display)) {
+			XEvent event;
+			XNextEvent(display, &event);
+			if (window != None && event.xany.window != window) {
+				continue;
+			}
+
+			if (event.type == type && count > 0 && --count == 0 &&
+			    series) {
+				addSample(series, start, 1);
+			} else if (event.type == otherType && !seenOther) {
+				addSample(other, start, 1);
+				seenOther = 1;
+			}
+		}
+		if (count == 0 && seenOther) {
+			break;
+		}
+
+		double left = deadline - now();
+		if (left <= 0) {
+			if (count > 0 && series) {
+				addSample(series, start, 0);
+			}
+			if (!seenOther) {
+				addSample(other, start, 0);
+			}
+			return 0;
+		}
+
+		struct pollfd fd = {ConnectionNumber(display), POLLIN, 0};
+		poll(&fd, 1, left / 1e6 + 1);
+	}
+
+	return 1;
+}
+
+/* let banana finish whatever is queued before looking at the cpu time */
+static void settle(void)
+{
+	XSync(display, False);
+	usleep(100 * 1000);
+	XSync(display, True);
+}
+
+static void benchMap(SSeries *map, SSeries *configure)
+{
+	Atom   netWmPid = XInternAtom(display, "_NET_WM_PID", False);
+	long   pid	= getpid();
+	int    screen	= DefaultScreen(display);
+	Window rootWin	= RootWindow(display, screen);
+
+	for (int i = 0; i < windowCount; i++) {
+		windows[i] = XCreateSimpleWindow(display, rootWin, 0, 0, 200,
+						 200, 0,
+						 BlackPixel(display, screen),
+						 WhitePixel(display, screen));
+		XSelectInput(display, windows[i], StructureNotifyMask);
+		XStoreName(display, windows[i], "bench");
+		XChangeProperty(display, windows[i], netWmPid, XA_CARDINAL, 32,
+				PropModeReplace, (unsigned char *)&pid, 1);
+
+		double start = now();
+		XMapWindow(display, windows[i]);
+		XFlush(display);
+
+		waitEvents(MapNotify, windows[i], 1, start, map,
+			   ConfigureNotify, configure);
+	}
+}
+
+static void benchRename(void)
+{
+	char title[64];
+
+	for (int round = 0; round < 10; round++) {
+		for (int i = 0; i < windowCount; i++) {
+			snprintf(title, sizeof(title), "bench %d.%d", i, round);
+			XStoreName(display, windows[i], title);
+		}
+		XFlush(display);
+	}
+}
+
+static void benchResize(SSeries *resize)
+{
+	for (int i = 0; i < windowCount; i++) {
+		double start = now();
+		XResizeWindow(display, windows[i], 300 + i, 300 + i);
+		XFlush(display);
+		waitEvents(ConfigureNotify, windows[i], 1, start, resize, 0,
+			   NULL);
+	}
+}
+
+/*
+ * workspace 0 holds every window, switching away unmaps all of them and
+ * switching back maps them again, the switch is done once banana has
+ * replied and the server has told us about the last window
+ */
+static void benchSwitch(SSeries *away, SSeries *back)
+{
+	for (int i = 0; i < switchCount; i++) {
+		double start = now();
+		ipcRun("switch_workspace 1");
+		waitEvents(UnmapNotify, None, windowCount, start, away, 0,
+			   NULL);
+
+		start = now();
+		ipcRun("switch_workspace 0");
+		waitEvents(MapNotify, None, windowCount, start, back, 0, NULL);
+	}
+}
+
+static void benchUnmap(void)
+{
+	for (int i = 0; i < windowCount; i++) {
+		XDestroyWindow(display, windows[i]);
+	}
+	XFlush(display);
+}
+
+/* the windows banana has published in _NET_CLIENT_LIST */
+static long managedWindows(void)
+{
+	Atom	       type;
+	int	       format;
+	unsigned long  count = 0, after;
+	unsigned char *data  = NULL;
+
+	if (XGetWindowProperty(display, DefaultRootWindow(display),
+			       XInternAtom(display, "_NET_CLIENT_LIST", False),
+			       0, 1 << 20, False, XA_WINDOW, &type, &format,
+			       &count, &after, &data) == Success &&
+	    data) {
+		XFree(data);
+	}
+
+	return count;
+}
+
+/*
+ * maps windowCount windows with a name, class and pid before banana runs,
+ * then starts banana ADOPT_RUNS times and waits for its first ipc reply,
+ * which it only sends once every existing window has been adopted
+ */
+static int benchAdopt(const char *banana, SSeries *ready)
+{
+	Atom	   netWmPid  = XInternAtom(display, "_NET_WM_PID", False);
+	long	   pid	     = getpid();
+	int	   screen    = DefaultScreen(display);
+	Window	   rootWin   = RootWindow(display, screen);
+	XClassHint classHint = {"bench", "Bench"};
+
+	for (int i = 0; i < windowCount; i++) {
+		windows[i] = XCreateSimpleWindow(display, rootWin, 0, 0, 200,
+						 200, 0,
+						 BlackPixel(display, screen),
+						 WhitePixel(display, screen));
+		XStoreName(display, windows[i], "bench");
+		XSetClassHint(display, windows[i], &classHint);
+		XChangeProperty(display, windows[i], netWmPid, XA_CARDINAL, 32,
+				PropModeReplace, (unsigned char *)&pid, 1);
+		XMapWindow(display, windows[i]);
+	}
+	settle();
+
+	for (int run = 0; run < ADOPT_RUNS; run++) {
+		double start = now();
+		pid_t  wm    = fork();
+		if (wm == 0) {
+			execl(banana, banana, (char *)NULL);
+			_exit(127);
+		} else if (wm == -1) {
+			perror("fork");
+			return 1;
+		}
+
+		int    done	= 0;
+		double deadline = start + ADOPT_TIMEOUT_MS * 1e6;
+		while (!done && now() < deadline) {
+			int fd = ipcConnect();
+			if (fd == -1) {
+				usleep(1000);
+				continue;
+			}
+
+			SIPCHeader header = {IPC_COMMAND_GET_WORKSPACES, 0, 0};
+			done = write(fd, &header, sizeof(header)) ==
+				   sizeof(header) &&
+			       read(fd, &header, sizeof(header)) ==
+				   sizeof(header);
+			close(fd);
+		}
+		addSample(ready, start, done);
+
+		long managed = managedWindows();
+		if (done && managed < windowCount) {
+			fprintf(stderr, "banana adopted %ld of %d windows\n",
+				managed, windowCount);
+		}
+
+		kill(wm, SIGTERM);
+		waitpid(wm, NULL, 0);
+		settle();
+	}
+
+	return 0;
+}
+
+/*
+ * splits the screen into count side by side randr monitors, run before
+ * banana starts since xvfb only has a single output
+ */
+static int setupMonitors(int count)
+{
+	Window rootWin = DefaultRootWindow(display);
+	int    width   = DisplayWidth(display, DefaultScreen(display));
+	int    height  = DisplayHeight(display, DefaultScreen(display));
+	char   name[32];
+
+	if (count < 2) {
+		return 0;
+	}
+
+	for (int i = 0; i < count; i++) {
+		XRRMonitorInfo *monitor = XRRAllocateMonitor(display, 0);
+		if (!monitor) {
+			return 1;
+		}
+
+		snprintf(name, sizeof(name), "bench-%d", i);
+		monitor->name	   = XInternAtom(display, name, False);
+		monitor->x	   = width / count * i;
+		monitor->y	   = 0;
+		monitor->width	   = width / count;
+		monitor->height	   = height;
+		monitor->mwidth	   = monitor->width / 4;
+		monitor->mheight   = height / 4;
+		monitor->primary   = i == 0;
+		monitor->automatic = False;
+		XRRSetMonitor(display, rootWin, monitor);
+		XRRFreeMonitors(monitor);
+	}
+
+	XSync(display, False);
+	return 0;
+}
+
+int main(int argc, char *argv[])
+{
+	int	    monitors = 0;
+	const char *banana   = NULL;
+	int	    opt;
+
+	while ((opt = getopt(argc, argv, "n:s:p:m:a:")) != -1) {
+		switch (opt) {
+		case 'n':
+			windowCount = atoi(optarg);
+			break;
+		case 's':
+			switchCount = atoi(optarg);
+			break;
+		case 'p':
+			bananaPid = atoi(optarg);
+			break;
+		case 'm':
+			monitors = atoi(optarg);
+			break;
+		case 'a':
+			banana = optarg;
+			break;
+		default:
+			fprintf(stderr,
+				"usage: %s [-m monitors] | [-n windows] "
+				"[-s switches] [-p banana pid] | [-n windows] "
+				"-a banana\n",
+				argv[0]);
+			return 1;
+		}
+	}
+
+	display = XOpenDisplay(NULL);
+	if (!display) {
+		fprintf(stderr, "cannot open display\n");
+		return 1;
+	}
+
+	if (monitors > 0) {
+		int result = setupMonitors(monitors);
+		XCloseDisplay(display);
+		return result;
+	}
+
+	if (windowCount < 1) {
+		windowCount = 1;
+	}
+
+	windows = calloc(windowCount, sizeof(Window));
+
+	if (banana) {
+		double	samples[ADOPT_RUNS];
+		SSeries ready = {"start to ready", samples, 0, 0};
+
+		int	result = benchAdopt(banana, &ready);
+		printf("%d existing windows, %d starts\n", windowCount,
+		       ADOPT_RUNS);
+		report(&ready);
+
+		free(windows);
+		XCloseDisplay(display);
+		return result;
+	}
+
+	double *samples =
+	    calloc((size_t)windowCount * 3 + switchCount * 2, sizeof(double));
+	SSeries map	  = {"map to mapped", samples, 0, 0};
+	SSeries configure = {"map to configured", samples + windowCount, 0, 0};
+	SSeries resize = {"resize to configured", samples + windowCount * 2, 0,
+			  0};
+	SSeries away = {"switch to empty workspace", samples + windowCount * 3,
+			0, 0};
+	SSeries back = {"switch to full workspace",
+			samples + windowCount * 3 + switchCount, 0, 0};
+
+	/* windows go to the monitor under the pointer */
+	XWarpPointer(display, None, DefaultRootWindow(display), 0, 0, 0, 0, 10,
+		     10);
+	settle();
+
+	double cpu = cpuTime();
+	benchMap(&map, &configure);
+	settle();
+	double mapCpu = cpuTime() - cpu;
+
+	cpu = cpuTime();
+	benchRename();
+	settle();
+	double renameCpu = cpuTime() - cpu;
+
+	cpu = cpuTime();
+	benchResize(&resize);
+	settle();
+	double resizeCpu = cpuTime() - cpu;
+
+	cpu = cpuTime();
+	benchSwitch(&away, &back);
+	settle();
+	double switchCpu = cpuTime() - cpu;
+
+	cpu = cpuTime();
+	benchUnmap();
+	settle();
+	double unmapCpu = cpuTime() - cpu;
+
+	printf("%d windows, %d workspace switches\n", windowCount, switchCount);
+	report(&map);
+	report(&configure);
+	report(&resize);
+	report(&away);
+	report(&back);
+
+	if (bananaPid) {
+		printf("banana cpu time: map %.1f ms, rename %.1f ms, resize "
+		       "%.1f ms, switch %.1f ms, unmap %.1f ms\n",
+		       mapCpu / 1e6, renameCpu / 1e6, resizeCpu / 1e6,
+		       switchCpu / 1e6, unmapCpu / 1e6);
+	}
+
+	free(samples);
+	free(windows);
+	XCloseDisplay(display);
+	return 0;
+}
@@ -0,0 +1,70 @@
+#!/bin/sh
+# runs banana on a private xvfb server and drives it with bench-x11
+# usage: bench/x11.sh <banana> <bench-x11>
+# BENCH_WINDOWS, BENCH_SWITCHES, BENCH_MONITORS and BENCH_EXISTING override
+# the defaults
+
+banana=$1
+client=$2
+
+if ! command -v Xvfb >/dev/null 2>&1; then
+	echo "Xvfb not found, skipping x11 benchmark"
+	exit 0
+fi
+
+dir=$(mktemp -d)
+xvfb=
+wm=
+
+cleanup() {
+	[ -n "$wm" ] && kill "$wm" 2>/dev/null
+	[ -n "$xvfb" ] && kill "$xvfb" 2>/dev/null
+	wait 2>/dev/null
+	rm -rf "$dir"
+}
+trap cleanup EXIT INT TERM
+
+monitors=${BENCH_MONITORS:-2}
+
+Xvfb -displayfd 3 -screen 0 "$((1920 * monitors))x1080x24" \
+	+extension RANDR -nolisten tcp 3>"$dir/display" 2>"$dir/xvfb.log" &
+xvfb=$!
+
+for _ in $(seq 50); do
+	[ -s "$dir/display" ] && break
+	sleep 0.1
+done
+if [ ! -s "$dir/display" ]; then
+	echo "Xvfb failed to start:" >&2
+	cat "$dir/xvfb.log" >&2
+	exit 1
+fi
+
+# a clean home so banana writes and uses its default config
+export DISPLAY=":$(cat "$dir/display")"
+export HOME="$dir"
+export XDG_CONFIG_HOME="$dir/.config"
+export XDG_RUNTIME_DIR="$dir"
+
+"$client" -m "$monitors" || exit 1
+
+# startup with windows that were there before banana
+if ! "$client" -n "${BENCH_EXISTING:-500}" -a "$banana" 2>"$dir/adopt.log"; then
+	cat "$dir/adopt.log" >&2
+	exit 1
+fi
+
+"$banana" 2>"$dir/banana.log" &
+wm=$!
+
+for _ in $(seq 50); do
+	[ -S "$dir/banana.sock" ] && break
+	sleep 0.1
+done
+if [ ! -S "$dir/banana.sock" ]; then
+	echo "banana failed to start:" >&2
+	cat "$dir/banana.log" >&2
+	exit 1
+fi
+
+"$client" -p "$wm" -n "${BENCH_WINDOWS:-50}" -s "${BENCH_SWITCHES:-20}"
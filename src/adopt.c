@@ -0,0 +1,619 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <X11/Xatom.h>
+#include <X11/Xlib-xcb.h>
+#include <xcb/xcb.h>
+
+#include "adopt.h"
+#include "backend.h"
+#include "banana.h"
+#include "log.h"
+
+typedef enum {
+	ADOPT_WM_CLASS,
+	ADOPT_WM_NAME,
+	ADOPT_WM_NORMAL_HINTS,
+	ADOPT_WM_HINTS,
+	ADOPT_WM_TRANSIENT_FOR,
+	ADOPT_NET_WM_NAME,
+	ADOPT_NET_WM_PID,
+	ADOPT_NET_WM_STATE,
+	ADOPT_NET_WM_WINDOW_TYPE,
+	ADOPT_NET_WM_DESKTOP,
+	ADOPT_PROPERTIES
+} EAdoptProperty;
+
+typedef struct {
+	Window			  window;
+	int			  valid;
+	XWindowAttributes	  attributes;
+	xcb_get_property_reply_t *properties[ADOPT_PROPERTIES];
+} SAdoptWindow;
+
+typedef struct {
+	xcb_get_window_attributes_cookie_t attributes;
+	xcb_get_geometry_cookie_t	   geometry;
+	xcb_get_property_cookie_t	   properties[ADOPT_PROPERTIES];
+} SAdoptCookies;
+
+static SAdoptWindow   *adoptWindows = NULL;
+static unsigned int    adoptCount   = 0;
+static Atom	       adoptAtoms[ADOPT_PROPERTIES];
+static const SBackend *previous = NULL;
+static SBackend	       adoptBackend;
+
+/* the pointer does not move while windows are adopted, ask once */
+static Bool	    pointerValid = False;
+static Window	    pointerRoot, pointerChild;
+static int	    pointerRootX, pointerRootY, pointerX, pointerY;
+static unsigned int pointerMask;
+
+static int	    compareWindows(const void *a, const void *b)
+{
+	Window left  = ((const SAdoptWindow *)a)->window;
+	Window right = ((const SAdoptWindow *)b)->window;
+
+	return left < right ? -1 : left > right;
+}
+
+static SAdoptWindow *findAdoptWindow(Window window)
+{
+	SAdoptWindow key = {.window = window};
+
+	return bsearch(&key, adoptWindows, adoptCount, sizeof(SAdoptWindow),
+		       compareWindows);
+}
+
+static xcb_get_property_reply_t **findProperty(Window window, Atom property)
+{
+	SAdoptWindow *entry = findAdoptWindow(window);
+	if (!entry) {
+		return NULL;
+	}
+
+	for (int i = 0; i < ADOPT_PROPERTIES; i++) {
+		if (adoptAtoms[i] == property) {
+			return &entry->properties[i];
+		}
+	}
+
+	return NULL;
+}
+
+static void forgetProperty(Window window, Atom property)
+{
+	xcb_get_property_reply_t **reply = findProperty(window, property);
+
+	if (reply && *reply) {
+		free(*reply);
+		*reply = NULL;
+	}
+}
+
+static void fillAttributes(XWindowAttributes		     *wa,
+			   xcb_get_window_attributes_reply_t *attributes,
+			   xcb_get_geometry_reply_t	     *geometry)
+{
+	memset(wa, 0, sizeof(*wa));
+	wa->x			  = geometry->x;
+	wa->y			  = geometry->y;
+	wa->width		  = geometry->width;
+	wa->height		  = geometry->height;
+	wa->border_width	  = geometry->border_width;
+	wa->depth		  = geometry->depth;
+	wa->root		  = geometry->root;
+	wa->class		  = attributes->_class;
+	wa->bit_gravity		  = attributes->bit_gravity;
+	wa->win_gravity		  = attributes->win_gravity;
+	wa->backing_store	  = attributes->backing_store;
+	wa->backing_planes	  = attributes->backing_planes;
+	wa->backing_pixel	  = attributes->backing_pixel;
+	wa->save_under		  = attributes->save_under;
+	wa->colormap		  = attributes->colormap;
+	wa->map_installed	  = attributes->map_is_installed;
+	wa->map_state		  = attributes->map_state;
+	wa->all_event_masks	  = attributes->all_event_masks;
+	wa->your_event_mask	  = attributes->your_event_mask;
+	wa->do_not_propagate_mask = attributes->do_not_propagate_mask;
+	wa->override_redirect	  = attributes->override_redirect;
+	wa->screen		  = DefaultScreenOfDisplay(display);
+}
+
+static Status adoptGetWindowAttributes(Display *dpy, Window window,
+				       XWindowAttributes *attributes)
+{
+	SAdoptWindow *entry = findAdoptWindow(window);
+
+	if (!entry) {
+		return previous->getWindowAttributes(dpy, window, attributes);
+	}
+	if (!entry->valid) {
+		return 0;
+	}
+
+	*attributes = entry->attributes;
+	return 1;
+}
+
+/*
+ * answers like XGetWindowProperty from the batched reply, 32 bit items are
+ * widened to longs the way xlib does, anything the batch cannot answer
+ * exactly goes to the server
+ */
+static int adoptGetWindowProperty(Display *dpy, Window window, Atom property,
+				  long offset, long length, Bool delete,
+				  Atom requested, Atom *type, int *format,
+				  unsigned long *count, unsigned long *after,
+				  unsigned char **data)
+{
+	xcb_get_property_reply_t **cached = findProperty(window, property);
+	xcb_get_property_reply_t  *reply  = cached ? *cached : NULL;
+
+	if (!reply || delete || reply->bytes_after || offset < 0 ||
+	    length < 0) {
+		return previous->getWindowProperty(dpy, window, property,
+						   offset, length, delete,
+						   requested, type, format,
+						   count, after, data);
+	}
+
+	*type	= reply->type;
+	*format = reply->format;
+	*count	= 0;
+	*after	= 0;
+	*data	= NULL;
+
+	if (reply->type == None) {
+		return Success;
+	}
+
+	unsigned long size  = xcb_get_property_value_length(reply);
+	unsigned long start = (unsigned long)offset * 4;
+	if (requested != AnyPropertyType && requested != reply->type) {
+		*after = size;
+		return Success;
+	}
+	if (start > size) {
+		return previous->getWindowProperty(dpy, window, property,
+						   offset, length, delete,
+						   requested, type, format,
+						   count, after, data);
+	}
+
+	unsigned long bytes = size - start;
+	if (bytes > (unsigned long)length * 4) {
+		bytes = (unsigned long)length * 4;
+	}
+
+	int	      unit  = reply->format / 8;
+	unsigned long items = unit ? bytes / unit : 0;
+	const char *value = (const char *)xcb_get_property_value(reply) + start;
+
+	*count = items;
+	*after = size - start - bytes;
+
+	if (reply->format == 32) {
+		long *longs = malloc(items * sizeof(long) + 1);
+		if (!longs) {
+			return BadAlloc;
+		}
+		for (unsigned long i = 0; i < items; i++) {
+			longs[i] = ((const uint32_t *)value)[i];
+		}
+		*data = (unsigned char *)longs;
+	} else if (reply->format == 16) {
+		short *shorts = malloc(items * sizeof(short) + 1);
+		if (!shorts) {
+			return BadAlloc;
+		}
+		for (unsigned long i = 0; i < items; i++) {
+			shorts[i] = ((const uint16_t *)value)[i];
+		}
+		*data = (unsigned char *)shorts;
+	} else {
+		unsigned char *bytesCopy = malloc(items + 1);
+		if (!bytesCopy) {
+			return BadAlloc;
+		}
+		memcpy(bytesCopy, value, items);
+		bytesCopy[items] = '\0';
+		*data		 = bytesCopy;
+	}
+
+	return Success;
+}
+
+static unsigned char *adoptProperty(Window window, Atom property,
+				    Atom requested, int format,
+				    unsigned long *count)
+{
+	Atom	       type;
+	int	       actualFormat;
+	unsigned long  after;
+	unsigned char *data = NULL;
+
+	if (adoptGetWindowProperty(display, window, property, 0,
+				   ADOPT_PROPERTY_LENGTH, False, requested,
+				   &type, &actualFormat, count, &after,
+				   &data) != Success ||
+	    !data) {
+		return NULL;
+	}
+
+	if (type == None || (format && actualFormat != format)) {
+		XFree(data);
+		return NULL;
+	}
+
+	return data;
+}
+
+static XWMHints *adoptGetWMHints(Display *dpy, Window window)
+{
+	if (!findProperty(window, XA_WM_HINTS)) {
+		return previous->getWMHints(dpy, window);
+	}
+
+	unsigned long count;
+	long	     *data =
+	    (long *)adoptProperty(window, XA_WM_HINTS, XA_WM_HINTS, 32, &count);
+	if (!data) {
+		return NULL;
+	}
+
+	/* the window group was added later, older clients leave it out */
+	XWMHints *hints = count >= 8 ? XAllocWMHints() : NULL;
+	if (hints) {
+		hints->flags	     = data[0];
+		hints->input	     = data[1] ? True : False;
+		hints->initial_state = data[2];
+		hints->icon_pixmap   = data[3];
+		hints->icon_window   = data[4];
+		hints->icon_x	     = data[5];
+		hints->icon_y	     = data[6];
+		hints->icon_mask     = data[7];
+		hints->window_group  = count >= 9 ? data[8] : 0;
+	}
+
+	XFree(data);
+	return hints;
+}
+
+static int adoptSetWMHints(Display *dpy, Window window, XWMHints *hints)
+{
+	forgetProperty(window, XA_WM_HINTS);
+	return previous->setWMHints(dpy, window, hints);
+}
+
+static Status adoptGetClassHint(Display *dpy, Window window, XClassHint *hint)
+{
+	if (!findProperty(window, XA_WM_CLASS)) {
+		return previous->getClassHint(dpy, window, hint);
+	}
+
+	hint->res_name	= NULL;
+	hint->res_class = NULL;
+
+	unsigned long count;
+	char	     *data =
+	    (char *)adoptProperty(window, XA_WM_CLASS, XA_STRING, 8, &count);
+	if (!data) {
+		return 0;
+	}
+
+	/* instance and class, each null terminated */
+	size_t nameLength = strnlen(data, count);
+	hint->res_name	  = strndup(data, nameLength);
+	hint->res_class	  = nameLength < count ? strndup(data + nameLength + 1,
+							 count - nameLength - 1)
+					       : strdup("");
+
+	XFree(data);
+	return 1;
+}
+
+static Status adoptGetWMNormalHints(Display *dpy, Window window,
+				    XSizeHints *hints, long *supplied)
+{
+	if (!findProperty(window, XA_WM_NORMAL_HINTS)) {
+		return previous->getWMNormalHints(dpy, window, hints, supplied);
+	}
+
+	unsigned long count;
+	long	     *data = (long *)adoptProperty(window, XA_WM_NORMAL_HINTS,
+						   XA_WM_SIZE_HINTS, 32, &count);
+	if (!data) {
+		return 0;
+	}
+	if (count < 15) {
+		XFree(data);
+		return 0;
+	}
+
+	hints->flags	    = data[0];
+	hints->x	    = data[1];
+	hints->y	    = data[2];
+	hints->width	    = data[3];
+	hints->height	    = data[4];
+	hints->min_width    = data[5];
+	hints->min_height   = data[6];
+	hints->max_width    = data[7];
+	hints->max_height   = data[8];
+	hints->width_inc    = data[9];
+	hints->height_inc   = data[10];
+	hints->min_aspect.x = data[11];
+	hints->min_aspect.y = data[12];
+	hints->max_aspect.x = data[13];
+	hints->max_aspect.y = data[14];
+
+	*supplied = USPosition | USSize | PAllHints;
+	if (count >= 18) {
+		hints->base_width  = data[15];
+		hints->base_height = data[16];
+		hints->win_gravity = data[17];
+		*supplied |= PBaseSize | PWinGravity;
+	} else {
+		hints->flags &= ~(PBaseSize | PWinGravity);
+	}
+	hints->flags &= *supplied;
+
+	XFree(data);
+	return 1;
+}
+
+static Status adoptGetTransientForHint(Display *dpy, Window window,
+				       Window *transientFor)
+{
+	if (!findProperty(window, XA_WM_TRANSIENT_FOR)) {
+		return previous->getTransientForHint(dpy, window, transientFor);
+	}
+
+	unsigned long count;
+	long	     *data = (long *)adoptProperty(window, XA_WM_TRANSIENT_FOR,
+						   XA_WINDOW, 32, &count);
+
+	*transientFor = None;
+	if (!data) {
+		return 0;
+	}
+	if (count >= 1) {
+		*transientFor = data[0];
+	}
+
+	XFree(data);
+	return count >= 1;
+}
+
+static Status adoptGetTextProperty(Display *dpy, Window window,
+				   XTextProperty *text, Atom property)
+{
+	if (!findProperty(window, property)) {
+		return previous->getTextProperty(dpy, window, text, property);
+	}
+
+	Atom	       type;
+	int	       format;
+	unsigned long  count, after;
+	unsigned char *data = NULL;
+
+	text->value    = NULL;
+	text->encoding = None;
+	text->format   = 0;
+	text->nitems   = 0;
+
+	if (adoptGetWindowProperty(dpy, window, property, 0,
+				   ADOPT_PROPERTY_LENGTH, False,
+				   AnyPropertyType, &type, &format, &count,
+				   &after, &data) != Success ||
+	    type == None) {
+		if (data) {
+			XFree(data);
+		}
+		return 0;
+	}
+
+	text->value    = data;
+	text->encoding = type;
+	text->format   = format;
+	text->nitems   = count;
+	return 1;
+}
+
+static int adoptChangeProperty(Display *dpy, Window window, Atom property,
+			       Atom type, int format, int mode,
+			       const unsigned char *data, int count)
+{
+	forgetProperty(window, property);
+	return previous->changeProperty(dpy, window, property, type, format,
+					mode, data, count);
+}
+
+static int adoptDeleteProperty(Display *dpy, Window window, Atom property)
+{
+	forgetProperty(window, property);
+	return previous->deleteProperty(dpy, window, property);
+}
+
+static int adoptMapWindow(Display *dpy, Window window)
+{
+	SAdoptWindow *entry = findAdoptWindow(window);
+	if (entry) {
+		entry->attributes.map_state = IsViewable;
+	}
+	return previous->mapWindow(dpy, window);
+}
+
+static int adoptUnmapWindow(Display *dpy, Window window)
+{
+	SAdoptWindow *entry = findAdoptWindow(window);
+	if (entry) {
+		entry->attributes.map_state = IsUnmapped;
+	}
+	return previous->unmapWindow(dpy, window);
+}
+
+static Bool adoptQueryPointer(Display *dpy, Window window, Window *rootReturn,
+			      Window *child, int *rootX, int *rootY, int *winX,
+			      int *winY, unsigned int *mask)
+{
+	if (window != root || !pointerValid) {
+		return previous->queryPointer(dpy, window, rootReturn, child,
+					      rootX, rootY, winX, winY, mask);
+	}
+
+	*rootReturn = pointerRoot;
+	*child	    = pointerChild;
+	*rootX	    = pointerRootX;
+	*rootY	    = pointerRootY;
+	*winX	    = pointerX;
+	*winY	    = pointerY;
+	*mask	    = pointerMask;
+	return True;
+}
+
+/* errors are reported by the handler that is installed anyway */
+static int adoptSync(Display *dpy, Bool discard)
+{
+	(void)dpy;
+	(void)discard;
+	return 1;
+}
+
+void beginAdoption(const Window *windows, unsigned int count)
+{
+	if (!count) {
+		return;
+	}
+
+	adoptWindows	       = calloc(count, sizeof(SAdoptWindow));
+	SAdoptCookies *cookies = calloc(count, sizeof(SAdoptCookies));
+	if (!adoptWindows || !cookies) {
+		LOG_ERROR("Failed to allocate memory for adopting %u windows\n",
+			  count);
+		free(adoptWindows);
+		free(cookies);
+		adoptWindows = NULL;
+		return;
+	}
+
+	adoptAtoms[ADOPT_WM_CLASS]	   = XA_WM_CLASS;
+	adoptAtoms[ADOPT_WM_NAME]	   = XA_WM_NAME;
+	adoptAtoms[ADOPT_WM_NORMAL_HINTS]    = XA_WM_NORMAL_HINTS;
+	adoptAtoms[ADOPT_WM_HINTS]	     = XA_WM_HINTS;
+	adoptAtoms[ADOPT_WM_TRANSIENT_FOR]   = XA_WM_TRANSIENT_FOR;
+	adoptAtoms[ADOPT_NET_WM_NAME]	     = NET_WM_NAME;
+	adoptAtoms[ADOPT_NET_WM_PID]	     = XInternAtom(display, "_NET_WM_PID",
+						   False);
+	adoptAtoms[ADOPT_NET_WM_STATE]	     = NET_WM_STATE;
+	adoptAtoms[ADOPT_NET_WM_WINDOW_TYPE] = NET_WM_WINDOW_TYPE;
+	adoptAtoms[ADOPT_NET_WM_DESKTOP]     = NET_WM_DESKTOP;
+
+	xcb_connection_t *connection = XGetXCBConnection(display);
+
+	for (unsigned int i = 0; i < count; i++) {
+		cookies[i].attributes =
+		    xcb_get_window_attributes(connection, windows[i]);
+		cookies[i].geometry = xcb_get_geometry(connection, windows[i]);
+	}
+
+	unsigned int viewable = 0;
+	for (unsigned int i = 0; i < count; i++) {
+		xcb_generic_error_t		  *error = NULL;
+		xcb_get_window_attributes_reply_t *attributes =
+		    xcb_get_window_attributes_reply(
+			connection, cookies[i].attributes, &error);
+		free(error);
+		error = NULL;
+		xcb_get_geometry_reply_t *geometry = xcb_get_geometry_reply(
+		    connection, cookies[i].geometry, &error);
+		free(error);
+
+		adoptWindows[i].window = windows[i];
+		if (attributes && geometry) {
+			fillAttributes(&adoptWindows[i].attributes, attributes,
+				       geometry);
+			adoptWindows[i].valid = 1;
+		}
+		free(attributes);
+		free(geometry);
+
+		if (!adoptWindows[i].valid ||
+		    adoptWindows[i].attributes.override_redirect ||
+		    adoptWindows[i].attributes.map_state != IsViewable) {
+			continue;
+		}
+
+		viewable++;
+		for (int p = 0; p < ADOPT_PROPERTIES; p++) {
+			cookies[i].properties[p] = xcb_get_property(
+			    connection, 0, windows[i], adoptAtoms[p],
+			    XCB_GET_PROPERTY_TYPE_ANY, 0,
+			    ADOPT_PROPERTY_LENGTH);
+		}
+	}
+
+	for (unsigned int i = 0; i < count; i++) {
+		if (!adoptWindows[i].valid ||
+		    adoptWindows[i].attributes.override_redirect ||
+		    adoptWindows[i].attributes.map_state != IsViewable) {
+			continue;
+		}
+
+		for (int p = 0; p < ADOPT_PROPERTIES; p++) {
+			xcb_generic_error_t *error = NULL;
+			adoptWindows[i].properties[p] = xcb_get_property_reply(
+			    connection, cookies[i].properties[p], &error);
+			free(error);
+		}
+	}
+	free(cookies);
+
+	adoptCount = count;
+	qsort(adoptWindows, adoptCount, sizeof(SAdoptWindow), compareWindows);
+
+	previous     = backend;
+	pointerValid = previous->queryPointer(
+	    display, root, &pointerRoot, &pointerChild, &pointerRootX,
+	    &pointerRootY, &pointerX, &pointerY, &pointerMask);
+
+	adoptBackend			 = *previous;
+	adoptBackend.getWindowAttributes = adoptGetWindowAttributes;
+	adoptBackend.getWindowProperty	 = adoptGetWindowProperty;
+	adoptBackend.getWMHints		 = adoptGetWMHints;
+	adoptBackend.setWMHints		 = adoptSetWMHints;
+	adoptBackend.getClassHint	 = adoptGetClassHint;
+	adoptBackend.getWMNormalHints	 = adoptGetWMNormalHints;
+	adoptBackend.getTransientForHint = adoptGetTransientForHint;
+	adoptBackend.getTextProperty	 = adoptGetTextProperty;
+	adoptBackend.changeProperty	 = adoptChangeProperty;
+	adoptBackend.deleteProperty	 = adoptDeleteProperty;
+	adoptBackend.mapWindow		 = adoptMapWindow;
+	adoptBackend.unmapWindow	 = adoptUnmapWindow;
+	adoptBackend.queryPointer	 = adoptQueryPointer;
+	adoptBackend.sync		 = adoptSync;
+	backend				 = &adoptBackend;
+
+	LOG_DEBUG("Fetched %u windows for adoption, %u viewable\n", count,
+		  viewable);
+}
+
+void endAdoption(void)
+{
+	if (!adoptWindows) {
+		return;
+	}
+
+	backend = previous;
+
+	for (unsigned int i = 0; i < adoptCount; i++) {
+		for (int p = 0; p < ADOPT_PROPERTIES; p++) {
+			free(adoptWindows[i].properties[p]);
+		}
+	}
+
+	free(adoptWindows);
+	adoptWindows = NULL;
+	adoptCount   = 0;
+	pointerValid = False;
+}
@@ -0,0 +1,18 @@
+#ifndef ADOPT_H
+#define ADOPT_H
+
+#include <X11/Xlib.h>
+
+#define ADOPT_PROPERTY_LENGTH 1024
+
+/*
+ * fetches the attributes of every window, then the properties manageClient
+ * reads for the ones that are viewable, each as one pipelined batch, until
+ * endAdoption backend answers those reads from the batch instead of asking
+ * the server again for every window
+ */
+void beginAdoption(const Window *windows, unsigned int count);
+
+void endAdoption(void);
+
+#endif /* ADOPT_H */
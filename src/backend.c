@@ -0,0 +1,531 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "backend.h"
+#include "log.h"
+
+typedef struct {
+	Window	     window;
+	int	     x, y;
+	unsigned int width, height, borderWidth;
+	int	     mapped;
+} SFakeWindow;
+
+static SFakeWindow fakeWindows[BACKEND_FAKE_WINDOWS];
+static uint64_t	   fakeCounts[BACKEND_OPS];
+static int	   fakePointerX = 0;
+static int	   fakePointerY = 0;
+
+static const char *opNames[BACKEND_OPS] = {
+    [BACKEND_MOVE_RESIZE_WINDOW]      = "move_resize_window",
+    [BACKEND_MOVE_WINDOW]	      = "move_window",
+    [BACKEND_RESIZE_WINDOW]	      = "resize_window",
+    [BACKEND_CONFIGURE_WINDOW]	      = "configure_window",
+    [BACKEND_MAP_WINDOW]	      = "map_window",
+    [BACKEND_UNMAP_WINDOW]	      = "unmap_window",
+    [BACKEND_RAISE_WINDOW]	      = "raise_window",
+    [BACKEND_LOWER_WINDOW]	      = "lower_window",
+    [BACKEND_RESTACK_WINDOWS]	      = "restack_windows",
+    [BACKEND_SET_WINDOW_BORDER]	      = "set_window_border",
+    [BACKEND_SET_WINDOW_BORDER_WIDTH] = "set_window_border_width",
+    [BACKEND_SET_INPUT_FOCUS]	      = "set_input_focus",
+    [BACKEND_CHANGE_PROPERTY]	      = "change_property",
+    [BACKEND_DELETE_PROPERTY]	      = "delete_property",
+    [BACKEND_GET_WINDOW_PROPERTY]     = "get_window_property",
+    [BACKEND_GET_WM_PROTOCOLS]	      = "get_wm_protocols",
+    [BACKEND_GET_WM_HINTS]	      = "get_wm_hints",
+    [BACKEND_SET_WM_HINTS]	      = "set_wm_hints",
+    [BACKEND_GET_CLASS_HINT]	      = "get_class_hint",
+    [BACKEND_GET_WM_NORMAL_HINTS]     = "get_wm_normal_hints",
+    [BACKEND_GET_TRANSIENT_FOR_HINT]  = "get_transient_for_hint",
+    [BACKEND_GET_TEXT_PROPERTY]	      = "get_text_property",
+    [BACKEND_SEND_EVENT]	      = "send_event",
+    [BACKEND_GET_WINDOW_ATTRIBUTES]   = "get_window_attributes",
+    [BACKEND_QUERY_POINTER]	      = "query_pointer",
+    [BACKEND_WARP_POINTER]	      = "warp_pointer",
+    [BACKEND_ALLOC_COLOR]	      = "alloc_color",
+    [BACKEND_GRAB_SERVER]	      = "grab_server",
+    [BACKEND_UNGRAB_SERVER]	      = "ungrab_server",
+    [BACKEND_SYNC]		      = "sync",
+    [BACKEND_FLUSH]		      = "flush"};
+
+static unsigned long xlibAllocColor(Display *dpy, const char *name)
+{
+	XColor	 color;
+	Colormap cmap = DefaultColormap(dpy, DefaultScreen(dpy));
+
+	if (XAllocNamedColor(dpy, cmap, name, &color, &color)) {
+		return color.pixel;
+	}
+
+	return BlackPixel(dpy, DefaultScreen(dpy));
+}
+
+static SFakeWindow *fakeWindow(Window window)
+{
+	unsigned int index = (window * 2654435761u) % BACKEND_FAKE_WINDOWS;
+
+	for (int i = 0; i < BACKEND_FAKE_WINDOWS; i++) {
+		SFakeWindow *entry = &fakeWindows[index];
+		if (entry->window == window || entry->window == None) {
+			entry->window = window;
+			return entry;
+		}
+		index = (index + 1) % BACKEND_FAKE_WINDOWS;
+	}
+
+	/* sharing a slot would corrupt another window's state */
+	LOG_ERROR("Fake backend window table full (%d windows)\n",
+		  BACKEND_FAKE_WINDOWS);
+	exit(1);
+}
+
+static int fakeMoveResizeWindow(Display *dpy, Window window, int x, int y,
+				unsigned int width, unsigned int height)
+{
+	(void)dpy;
+	SFakeWindow *entry = fakeWindow(window);
+	entry->x	   = x;
+	entry->y	   = y;
+	entry->width	   = width;
+	entry->height	   = height;
+	fakeCounts[BACKEND_MOVE_RESIZE_WINDOW]++;
+	return 1;
+}
+
+static int fakeMoveWindow(Display *dpy, Window window, int x, int y)
+{
+	(void)dpy;
+	SFakeWindow *entry = fakeWindow(window);
+	entry->x	   = x;
+	entry->y	   = y;
+	fakeCounts[BACKEND_MOVE_WINDOW]++;
+	return 1;
+}
+
+static int fakeResizeWindow(Display *dpy, Window window, unsigned int width,
+			    unsigned int height)
+{
+	(void)dpy;
+	SFakeWindow *entry = fakeWindow(window);
+	entry->width	   = width;
+	entry->height	   = height;
+	fakeCounts[BACKEND_RESIZE_WINDOW]++;
+	return 1;
+}
+
+static int fakeConfigureWindow(Display *dpy, Window window, unsigned int mask,
+			       XWindowChanges *changes)
+{
+	(void)dpy;
+	SFakeWindow *entry = fakeWindow(window);
+	if (mask & CWX) {
+		entry->x = changes->x;
+	}
+	if (mask & CWY) {
+		entry->y = changes->y;
+	}
+	if (mask & CWWidth) {
+		entry->width = changes->width;
+	}
+	if (mask & CWHeight) {
+		entry->height = changes->height;
+	}
+	if (mask & CWBorderWidth) {
+		entry->borderWidth = changes->border_width;
+	}
+	fakeCounts[BACKEND_CONFIGURE_WINDOW]++;
+	return 1;
+}
+
+static int fakeMapWindow(Display *dpy, Window window)
+{
+	(void)dpy;
+	fakeWindow(window)->mapped = 1;
+	fakeCounts[BACKEND_MAP_WINDOW]++;
+	return 1;
+}
+
+static int fakeUnmapWindow(Display *dpy, Window window)
+{
+	(void)dpy;
+	fakeWindow(window)->mapped = 0;
+	fakeCounts[BACKEND_UNMAP_WINDOW]++;
+	return 1;
+}
+
+static int fakeRaiseWindow(Display *dpy, Window window)
+{
+	(void)dpy;
+	(void)window;
+	fakeCounts[BACKEND_RAISE_WINDOW]++;
+	return 1;
+}
+
+static int fakeLowerWindow(Display *dpy, Window window)
+{
+	(void)dpy;
+	(void)window;
+	fakeCounts[BACKEND_LOWER_WINDOW]++;
+	return 1;
+}
+
+static int fakeRestackWindows(Display *dpy, Window *windows, int count)
+{
+	(void)dpy;
+	(void)windows;
+	(void)count;
+	fakeCounts[BACKEND_RESTACK_WINDOWS]++;
+	return 1;
+}
+
+static int fakeSetWindowBorder(Display *dpy, Window window, unsigned long pixel)
+{
+	(void)dpy;
+	(void)window;
+	(void)pixel;
+	fakeCounts[BACKEND_SET_WINDOW_BORDER]++;
+	return 1;
+}
+
+static int fakeSetWindowBorderWidth(Display *dpy, Window window,
+				    unsigned int width)
+{
+	(void)dpy;
+	fakeWindow(window)->borderWidth = width;
+	fakeCounts[BACKEND_SET_WINDOW_BORDER_WIDTH]++;
+	return 1;
+}
+
+static int fakeSetInputFocus(Display *dpy, Window window, int revert, Time time)
+{
+	(void)dpy;
+	(void)window;
+	(void)revert;
+	(void)time;
+	fakeCounts[BACKEND_SET_INPUT_FOCUS]++;
+	return 1;
+}
+
+static int fakeChangeProperty(Display *dpy, Window window, Atom property,
+			      Atom type, int format, int mode,
+			      const unsigned char *data, int count)
+{
+	(void)dpy;
+	(void)window;
+	(void)property;
+	(void)type;
+	(void)format;
+	(void)mode;
+	(void)data;
+	(void)count;
+	fakeCounts[BACKEND_CHANGE_PROPERTY]++;
+	return 1;
+}
+
+static int fakeDeleteProperty(Display *dpy, Window window, Atom property)
+{
+	(void)dpy;
+	(void)window;
+	(void)property;
+	fakeCounts[BACKEND_DELETE_PROPERTY]++;
+	return 1;
+}
+
+static int fakeGetWindowProperty(Display *dpy, Window window, Atom property,
+				 long offset, long length, Bool delete,
+				 Atom requested, Atom *type, int *format,
+				 unsigned long *count, unsigned long *after,
+				 unsigned char **data)
+{
+	(void)dpy;
+	(void)window;
+	(void)property;
+	(void)offset;
+	(void)length;
+	(void)delete;
+	(void)requested;
+	*type	= None;
+	*format = 0;
+	*count	= 0;
+	*after	= 0;
+	*data	= NULL;
+	fakeCounts[BACKEND_GET_WINDOW_PROPERTY]++;
+	return BadAtom;
+}
+
+static Status fakeGetWMProtocols(Display *dpy, Window window, Atom **protocols,
+				 int *count)
+{
+	(void)dpy;
+	(void)window;
+	*protocols = NULL;
+	*count	   = 0;
+	fakeCounts[BACKEND_GET_WM_PROTOCOLS]++;
+	return 0;
+}
+
+static XWMHints *fakeGetWMHints(Display *dpy, Window window)
+{
+	(void)dpy;
+	(void)window;
+	fakeCounts[BACKEND_GET_WM_HINTS]++;
+	return NULL;
+}
+
+static int fakeSetWMHints(Display *dpy, Window window, XWMHints *hints)
+{
+	(void)dpy;
+	(void)window;
+	(void)hints;
+	fakeCounts[BACKEND_SET_WM_HINTS]++;
+	return 1;
+}
+
+static Status fakeGetClassHint(Display *dpy, Window window, XClassHint *hint)
+{
+	(void)dpy;
+	(void)window;
+	hint->res_name	= NULL;
+	hint->res_class = NULL;
+	fakeCounts[BACKEND_GET_CLASS_HINT]++;
+	return 0;
+}
+
+static Status fakeGetWMNormalHints(Display *dpy, Window window,
+				   XSizeHints *hints, long *supplied)
+{
+	(void)dpy;
+	(void)window;
+	(void)hints;
+	*supplied = 0;
+	fakeCounts[BACKEND_GET_WM_NORMAL_HINTS]++;
+	return 0;
+}
+
+static Status fakeGetTransientForHint(Display *dpy, Window window,
+				      Window *transientFor)
+{
+	(void)dpy;
+	(void)window;
+	*transientFor = None;
+	fakeCounts[BACKEND_GET_TRANSIENT_FOR_HINT]++;
+	return 0;
+}
+
+static Status fakeGetTextProperty(Display *dpy, Window window,
+				  XTextProperty *text, Atom property)
+{
+	(void)dpy;
+	(void)window;
+	(void)property;
+	text->value    = NULL;
+	text->encoding = None;
+	text->format   = 0;
+	text->nitems   = 0;
+	fakeCounts[BACKEND_GET_TEXT_PROPERTY]++;
+	return 0;
+}
+
+static Status fakeSendEvent(Display *dpy, Window window, Bool propagate,
+			    long mask, XEvent *event)
+{
+	(void)dpy;
+	(void)window;
+	(void)propagate;
+	(void)mask;
+	(void)event;
+	fakeCounts[BACKEND_SEND_EVENT]++;
+	return 1;
+}
+
+static Status fakeGetWindowAttributes(Display *dpy, Window window,
+				      XWindowAttributes *attributes)
+{
+	(void)dpy;
+	SFakeWindow *entry = fakeWindow(window);
+
+	memset(attributes, 0, sizeof(*attributes));
+	attributes->x		 = entry->x;
+	attributes->y		 = entry->y;
+	attributes->width	 = entry->width;
+	attributes->height	 = entry->height;
+	attributes->border_width = entry->borderWidth;
+	attributes->map_state	 = entry->mapped ? IsViewable : IsUnmapped;
+	fakeCounts[BACKEND_GET_WINDOW_ATTRIBUTES]++;
+	return 1;
+}
+
+static Bool fakeQueryPointer(Display *dpy, Window window, Window *root,
+			     Window *child, int *rootX, int *rootY, int *winX,
+			     int *winY, unsigned int *mask)
+{
+	(void)dpy;
+	*root  = window;
+	*child = None;
+	*rootX = fakePointerX;
+	*rootY = fakePointerY;
+	*winX  = fakePointerX;
+	*winY  = fakePointerY;
+	*mask  = 0;
+	fakeCounts[BACKEND_QUERY_POINTER]++;
+	return True;
+}
+
+static int fakeWarpPointer(Display *dpy, Window source, Window destination,
+			   int sourceX, int sourceY, unsigned int sourceWidth,
+			   unsigned int sourceHeight, int x, int y)
+{
+	(void)dpy;
+	(void)source;
+	(void)sourceX;
+	(void)sourceY;
+	(void)sourceWidth;
+	(void)sourceHeight;
+	if (destination != None) {
+		SFakeWindow *entry = fakeWindow(destination);
+		x += entry->x;
+		y += entry->y;
+	}
+	fakePointerX = x;
+	fakePointerY = y;
+	fakeCounts[BACKEND_WARP_POINTER]++;
+	return 1;
+}
+
+/* a pixel derived from the name, so distinct colors stay distinct */
+static unsigned long fakeAllocColor(Display *dpy, const char *name)
+{
+	(void)dpy;
+	fakeCounts[BACKEND_ALLOC_COLOR]++;
+
+	unsigned long pixel = 0;
+	for (const char *c = name; c && *c; c++) {
+		pixel = pixel * 31 + (unsigned char)*c;
+	}
+	return pixel & 0xFFFFFF;
+}
+
+static int fakeGrabServer(Display *dpy)
+{
+	(void)dpy;
+	fakeCounts[BACKEND_GRAB_SERVER]++;
+	return 1;
+}
+
+static int fakeUngrabServer(Display *dpy)
+{
+	(void)dpy;
+	fakeCounts[BACKEND_UNGRAB_SERVER]++;
+	return 1;
+}
+
+static int fakeSync(Display *dpy, Bool discard)
+{
+	(void)dpy;
+	(void)discard;
+	fakeCounts[BACKEND_SYNC]++;
+	return 1;
+}
+
+static int fakeFlush(Display *dpy)
+{
+	(void)dpy;
+	fakeCounts[BACKEND_FLUSH]++;
+	return 1;
+}
+
+const SBackend fakeBackend = {
+    .moveResizeWindow	  = fakeMoveResizeWindow,
+    .moveWindow		  = fakeMoveWindow,
+    .resizeWindow	  = fakeResizeWindow,
+    .configureWindow	  = fakeConfigureWindow,
+    .mapWindow		  = fakeMapWindow,
+    .unmapWindow	  = fakeUnmapWindow,
+    .raiseWindow	  = fakeRaiseWindow,
+    .lowerWindow	  = fakeLowerWindow,
+    .restackWindows	  = fakeRestackWindows,
+    .setWindowBorder	  = fakeSetWindowBorder,
+    .setWindowBorderWidth = fakeSetWindowBorderWidth,
+    .setInputFocus	  = fakeSetInputFocus,
+    .changeProperty	  = fakeChangeProperty,
+    .deleteProperty	  = fakeDeleteProperty,
+    .getWindowProperty	  = fakeGetWindowProperty,
+    .getWMProtocols	  = fakeGetWMProtocols,
+    .getWMHints		  = fakeGetWMHints,
+    .setWMHints		  = fakeSetWMHints,
+    .getClassHint	  = fakeGetClassHint,
+    .getWMNormalHints	  = fakeGetWMNormalHints,
+    .getTransientForHint  = fakeGetTransientForHint,
+    .getTextProperty	  = fakeGetTextProperty,
+    .sendEvent		  = fakeSendEvent,
+    .getWindowAttributes  = fakeGetWindowAttributes,
+    .queryPointer	  = fakeQueryPointer,
+    .warpPointer	  = fakeWarpPointer,
+    .allocColor		  = fakeAllocColor,
+    .grabServer		  = fakeGrabServer,
+    .ungrabServer	  = fakeUngrabServer,
+    .sync		  = fakeSync,
+    .flush		  = fakeFlush};
+
+const SBackend xlibBackend = {
+    .moveResizeWindow	  = XMoveResizeWindow,
+    .moveWindow		  = XMoveWindow,
+    .resizeWindow	  = XResizeWindow,
+    .configureWindow	  = XConfigureWindow,
+    .mapWindow		  = XMapWindow,
+    .unmapWindow	  = XUnmapWindow,
+    .raiseWindow	  = XRaiseWindow,
+    .lowerWindow	  = XLowerWindow,
+    .restackWindows	  = XRestackWindows,
+    .setWindowBorder	  = XSetWindowBorder,
+    .setWindowBorderWidth = XSetWindowBorderWidth,
+    .setInputFocus	  = XSetInputFocus,
+    .changeProperty	  = XChangeProperty,
+    .deleteProperty	  = XDeleteProperty,
+    .getWindowProperty	  = XGetWindowProperty,
+    .getWMProtocols	  = XGetWMProtocols,
+    .getWMHints		  = XGetWMHints,
+    .setWMHints		  = XSetWMHints,
+    .getClassHint	  = XGetClassHint,
+    .getWMNormalHints	  = XGetWMNormalHints,
+    .getTransientForHint  = XGetTransientForHint,
+    .getTextProperty	  = XGetTextProperty,
+    .sendEvent		  = XSendEvent,
+    .getWindowAttributes  = XGetWindowAttributes,
+    .queryPointer	  = XQueryPointer,
+    .warpPointer	  = XWarpPointer,
+    .allocColor		  = xlibAllocColor,
+    .grabServer		  = XGrabServer,
+    .ungrabServer	  = XUngrabServer,
+    .sync		  = XSync,
+    .flush		  = XFlush};
+
+const SBackend *backend = &xlibBackend;
+
+const char *backendOpName(EBackendOp op)
+{
+	return op < BACKEND_OPS ? opNames[op] : "unknown";
+}
+
+uint64_t fakeBackendCount(EBackendOp op)
+{
+	return op < BACKEND_OPS ? fakeCounts[op] : 0;
+}
+
+uint64_t fakeBackendRequests(void)
+{
+	uint64_t total = 0;
+
+	/* flush is not a request, sync is one round trip */
+	for (int i = 0; i < BACKEND_FLUSH; i++) {
+		total += fakeCounts[i];
+	}
+
+	return total;
+}
+
+void resetFakeBackendCounts(void)
+{
+	memset(fakeCounts, 0, sizeof(fakeCounts));
+}
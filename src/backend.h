@@ -0,0 +1,110 @@
+#ifndef BACKEND_H
+#define BACKEND_H
+
+#include <stdint.h>
+#include <X11/Xlib.h>
+#include <X11/Xutil.h>
+
+#define BACKEND_FAKE_WINDOWS 4096
+
+typedef enum {
+	BACKEND_MOVE_RESIZE_WINDOW,
+	BACKEND_MOVE_WINDOW,
+	BACKEND_RESIZE_WINDOW,
+	BACKEND_CONFIGURE_WINDOW,
+	BACKEND_MAP_WINDOW,
+	BACKEND_UNMAP_WINDOW,
+	BACKEND_RAISE_WINDOW,
+	BACKEND_LOWER_WINDOW,
+	BACKEND_RESTACK_WINDOWS,
+	BACKEND_SET_WINDOW_BORDER,
+	BACKEND_SET_WINDOW_BORDER_WIDTH,
+	BACKEND_SET_INPUT_FOCUS,
+	BACKEND_CHANGE_PROPERTY,
+	BACKEND_DELETE_PROPERTY,
+	BACKEND_GET_WINDOW_PROPERTY,
+	BACKEND_GET_WM_PROTOCOLS,
+	BACKEND_GET_WM_HINTS,
+	BACKEND_SET_WM_HINTS,
+	BACKEND_GET_CLASS_HINT,
+	BACKEND_GET_WM_NORMAL_HINTS,
+	BACKEND_GET_TRANSIENT_FOR_HINT,
+	BACKEND_GET_TEXT_PROPERTY,
+	BACKEND_SEND_EVENT,
+	BACKEND_GET_WINDOW_ATTRIBUTES,
+	BACKEND_QUERY_POINTER,
+	BACKEND_WARP_POINTER,
+	BACKEND_ALLOC_COLOR,
+	BACKEND_GRAB_SERVER,
+	BACKEND_UNGRAB_SERVER,
+	BACKEND_SYNC,
+	BACKEND_FLUSH,
+	BACKEND_OPS
+} EBackendOp;
+
+/*
+ * the x operations the window management core goes through, they take the
+ * same arguments as their xlib counterparts so the xlib backend is a table
+ * of xlib functions, allocColor returns the pixel for a named color or black
+ * when it cannot be allocated, setup, input grabs, cursors, randr and xsync
+ * alarms still call xlib directly
+ */
+typedef struct {
+	int (*moveResizeWindow)(Display *, Window, int, int, unsigned int,
+				unsigned int);
+	int (*moveWindow)(Display *, Window, int, int);
+	int (*resizeWindow)(Display *, Window, unsigned int, unsigned int);
+	int (*configureWindow)(Display *, Window, unsigned int,
+			       XWindowChanges *);
+	int (*mapWindow)(Display *, Window);
+	int (*unmapWindow)(Display *, Window);
+	int (*raiseWindow)(Display *, Window);
+	int (*lowerWindow)(Display *, Window);
+	int (*restackWindows)(Display *, Window *, int);
+	int (*setWindowBorder)(Display *, Window, unsigned long);
+	int (*setWindowBorderWidth)(Display *, Window, unsigned int);
+	int (*setInputFocus)(Display *, Window, int, Time);
+	int (*changeProperty)(Display *, Window, Atom, Atom, int, int,
+			      const unsigned char *, int);
+	int (*deleteProperty)(Display *, Window, Atom);
+	int (*getWindowProperty)(Display *, Window, Atom, long, long, Bool,
+				 Atom, Atom *, int *, unsigned long *,
+				 unsigned long *, unsigned char **);
+	Status (*getWMProtocols)(Display *, Window, Atom **, int *);
+	XWMHints *(*getWMHints)(Display *, Window);
+	int (*setWMHints)(Display *, Window, XWMHints *);
+	Status (*getClassHint)(Display *, Window, XClassHint *);
+	Status (*getWMNormalHints)(Display *, Window, XSizeHints *, long *);
+	Status (*getTransientForHint)(Display *, Window, Window *);
+	Status (*getTextProperty)(Display *, Window, XTextProperty *, Atom);
+	Status (*sendEvent)(Display *, Window, Bool, long, XEvent *);
+	Status (*getWindowAttributes)(Display *, Window, XWindowAttributes *);
+	Bool (*queryPointer)(Display *, Window, Window *, Window *, int *,
+			     int *, int *, int *, unsigned int *);
+	int (*warpPointer)(Display *, Window, Window, int, int, unsigned int,
+			   unsigned int, int, int);
+	unsigned long (*allocColor)(Display *, const char *);
+	int (*grabServer)(Display *);
+	int (*ungrabServer)(Display *);
+	int (*sync)(Display *, Bool);
+	int (*flush)(Display *);
+} SBackend;
+
+extern const SBackend  xlibBackend;
+extern const SBackend  fakeBackend;
+extern const SBackend *backend;
+
+/*
+ * the fake keeps the geometry and map state of every window it is told
+ * about in memory and counts each call, queries are answered from that
+ * state without a server so display can be NULL while it is in use
+ */
+const char *backendOpName(EBackendOp op);
+
+uint64_t    fakeBackendCount(EBackendOp op);
+
+uint64_t    fakeBackendRequests(void);
+
+void	    resetFakeBackendCounts(void);
+
+#endif /* BACKEND_H */
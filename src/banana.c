@@ -14,18 +14,32 @@
 #include <limits.h>
 #include <fcntl.h>
 #include <errno.h>
+#include <poll.h>
 
 #include "banana.h"
 #include "config.h"
 #include "bar.h"
 #include "ipc.h"
-
-Display	       *display;
-Window		root;
-SClient	       *clients	    = NULL;
-SClient	       *focused	    = NULL;
-SMonitor       *monitors    = NULL;
-int		numMonitors = 0;
+#include "snapshot.h"
+#include "proc.h"
+#include "launch.h"
+#include "pool.h"
+#include "log.h"
+#include "stats.h"
+#include "trace.h"
+#include "record.h"
+#include "backend.h"
+#include "restart.h"
+#include "adopt.h"
+#include "outline.h"
+#include "syncrequest.h"
+
+Display		   *display;
+Window		    root;
+SClient		   *clients	= NULL;
+SClient		   *focused	= NULL;
+SMonitor	   *monitors	= NULL;
+int		    numMonitors = 0;
 Cursor		normalCursor;
 Cursor		moveCursor;
 Cursor		resizeSECursor;
@@ -40,6 +54,36 @@ struct timeval	lastWindowOperation = {0, 0};
 SClient	       *lastFocused	    = NULL;
 int		lastCursorWarp	    = 0;
 int		forcedMonitor	    = -1;
+int		updateBatchDepth    = 0;
+int		barUpdatePending    = 0;
+static unsigned int deferredArranges = 0;
+static SClient	   *deferredFocus    = NULL;
+static int	    restoredState    = 0;
+static int	    adopting	     = 0;
+
+static unsigned long activeBorderPixel	 = 0;
+static unsigned long inactiveBorderPixel = 0;
+
+/* top first, linked through stackNext */
+static SClient *stack		  = NULL;
+static Window  *appliedStack	  = NULL;
+static int	appliedStackSize  = 0;
+static int	appliedStackCount = -1;
+static int	appliedFirstBar	  = 0;
+static int	appliedBars	  = 0;
+
+/* root properties waiting for flushRootProperties */
+static unsigned int dirtyRootProperties = 0;
+static Window	   *clientListOrder	= NULL;
+static int	    clientListSize	= 0;
+static int	    clientListCount	= 0;
+static int	    clientListPublished = -1;
+static int	    pendingDesktop	= 0;
+static int	    publishedDesktop	= -1;
+
+/* the client whose dragged geometry is only in the model so far */
+static SClient *dragHeld      = NULL;
+static uint64_t lastDragApply = 0;
 
 Atom		WM_PROTOCOLS;
 Atom		WM_DELETE_WINDOW;
@@ -83,6 +127,8 @@ Atom		NET_WM_ACTION_FULLSCREEN;
 Atom		NET_WM_ACTION_CHANGE_DESKTOP;
 Atom		NET_WM_ACTION_MOVE;
 Atom		NET_WM_ACTION_RESIZE;
+Atom		NET_WM_SYNC_REQUEST;
+Atom		NET_WM_SYNC_REQUEST_COUNTER;
 
 int		xerrorHandler(Display *dpy, XErrorEvent *ee)
 {
@@ -98,8 +144,8 @@ int		xerrorHandler(Display *dpy, XErrorEvent *ee)
 
 	char errorText[256];
 	XGetErrorText(dpy, ee->error_code, errorText, sizeof(errorText));
-	fprintf(stderr, "banana: X error: %s (0x%x) request %d\n", errorText,
-		ee->error_code, ee->request_code);
+	LOG_WARN("banana: X error: %s (0x%x) request %d\n", errorText,
+		 ee->error_code, ee->request_code);
 	return 0;
 }
 
@@ -107,8 +153,8 @@ int otherWmRunningHandler(Display *dpy, XErrorEvent *ee)
 {
 	if (ee->error_code == BadAccess &&
 	    ee->request_code == X_ChangeWindowAttributes) {
-		fprintf(stderr, "banana: another window manager is already "
-				"running\n");
+		LOG_ERROR("banana: another window manager is already "
+			  "running\n");
 		exit(1);
 	}
 	return xerrorHandler(dpy, ee);
@@ -141,27 +187,75 @@ static void (*eventHandlers[LASTEvent])(XEvent *) = {
     [ClientMessage]    = handleClientMessage,
 };
 
+/*
+ * attributes and properties of every existing window are fetched in one
+ * batch, then the windows are managed without arranging or focusing each of
+ * them and every monitor is arranged once at the end
+ */
 void scanExistingWindows()
 {
 	Window	     rootReturn, parentReturn;
 	Window	    *children;
 	unsigned int numChildren;
+	SClient	    *focusTarget = NULL;
+	int	     adopted	 = 0;
 
-	if (XQueryTree(display, root, &rootReturn, &parentReturn, &children,
-		       &numChildren)) {
-		for (unsigned int i = 0; i < numChildren; i++) {
-			XWindowAttributes wa;
-			if (XGetWindowAttributes(display, children[i], &wa) &&
-			    !wa.override_redirect &&
-			    wa.map_state == IsViewable) {
-				manageClient(children[i]);
-			}
+	if (!XQueryTree(display, root, &rootReturn, &parentReturn, &children,
+			&numChildren)) {
+		return;
+	}
+
+	/* windows restored or adopted before are not fetched again */
+	unsigned int unknown = 0;
+	for (unsigned int i = 0; i < numChildren; i++) {
+		if (!findClient(children[i])) {
+			children[unknown++] = children[i];
 		}
+	}
+	numChildren = unknown;
+
+	beginAdoption(children, numChildren);
+	adopting = 1;
+
+	for (unsigned int i = 0; i < numChildren; i++) {
+		XWindowAttributes wa;
+		if (backend->getWindowAttributes(display, children[i], &wa) &&
+		    !wa.override_redirect && wa.map_state == IsViewable &&
+		    !findClient(children[i])) {
+			manageClient(children[i]);
+			adopted++;
 
-		if (children) {
-			XFree(children);
+			SClient *client = findClient(children[i]);
+			if (client && !client->isDock &&
+			    client->workspace ==
+				monitors[client->monitor].currentWorkspace) {
+				focusTarget = client;
+			}
 		}
 	}
+
+	adopting = 0;
+	endAdoption();
+
+	if (children) {
+		XFree(children);
+	}
+
+	if (!adopted) {
+		return;
+	}
+
+	for (int i = 0; i < numMonitors; i++) {
+		arrangeClients(&monitors[i]);
+	}
+	updateBorders();
+	restackClients();
+
+	if (focusTarget) {
+		focusClient(focusTarget);
+	}
+
+	updateBars();
 }
 
 void setupEWMH()
@@ -220,6 +314,10 @@ void setupEWMH()
 	NET_WM_ACTION_MOVE = XInternAtom(display, "_NET_WM_ACTION_MOVE", False);
 	NET_WM_ACTION_RESIZE =
 	    XInternAtom(display, "_NET_WM_ACTION_RESIZE", False);
+	NET_WM_SYNC_REQUEST =
+	    XInternAtom(display, "_NET_WM_SYNC_REQUEST", False);
+	NET_WM_SYNC_REQUEST_COUNTER =
+	    XInternAtom(display, "_NET_WM_SYNC_REQUEST_COUNTER", False);
 
 	wmcheckwin = XCreateSimpleWindow(display, root, 0, 0, 1, 1, 0, 0, 0);
 	XChangeProperty(display, root, NET_SUPPORTING_WM_CHECK, XA_WINDOW, 32,
@@ -254,34 +352,38 @@ void setupEWMH()
 			    NET_WM_MOVERESIZE,
 			    NET_REQUEST_FRAME_EXTENTS,
 			    NET_FRAME_EXTENTS,
-			    NET_WM_ALLOWED_ACTIONS};
+			    NET_WM_ALLOWED_ACTIONS,
+			    NET_WM_SYNC_REQUEST};
+
+	/* the sync request is last so it can be left out without xsync */
+	int supportedCount = sizeof(supported) / sizeof(Atom);
+	if (!syncRequestAvailable()) {
+		supportedCount--;
+	}
 
 	XChangeProperty(display, root, NET_SUPPORTED, XA_ATOM, 32,
 			PropModeReplace, (unsigned char *)supported,
-			sizeof(supported) / sizeof(Atom));
+			supportedCount);
 
 	long numDesktops = workspaceCount;
 	XChangeProperty(display, root, NET_NUMBER_OF_DESKTOPS, XA_CARDINAL, 32,
 			PropModeReplace, (unsigned char *)&numDesktops, 1);
 
-	long currentDesktop = currentWorkspace;
-	XChangeProperty(display, root, NET_CURRENT_DESKTOP, XA_CARDINAL, 32,
-			PropModeReplace, (unsigned char *)&currentDesktop, 1);
-
-	updateClientList();
-	updateClientListStacking();
-	updateDesktopViewport();
-	updateDesktopNames();
+	invalidateCurrentDesktop(currentWorkspace);
+	invalidateRootProperties(ROOT_CLIENT_LIST | ROOT_CLIENT_LIST_STACKING |
+				 ROOT_DESKTOP_VIEWPORT | ROOT_DESKTOP_NAMES);
 }
 
 void setup()
 {
 	display = XOpenDisplay(NULL);
 	if (!display) {
-		fprintf(stderr, "banana: cannot open display\n");
+		LOG_ERROR("banana: cannot open display\n");
 		exit(1);
 	}
 
+	fcntl(ConnectionNumber(display), F_SETFD, FD_CLOEXEC);
+
 	XSetErrorHandler(xerrorHandler);
 	root = DefaultRootWindow(display);
 
@@ -292,20 +394,22 @@ void setup()
 	WM_STATE	 = XInternAtom(display, "WM_STATE", False);
 	WM_TAKE_FOCUS	 = XInternAtom(display, "WM_TAKE_FOCUS", False);
 
+	initSyncRequest();
 	setupEWMH();
 
 	if (!loadConfig()) {
-		fprintf(stderr, "banana: failed to load configuration\n");
+		LOG_ERROR("banana: failed to load configuration\n");
 		exit(1);
 	}
+	allocBorderColors();
 
 	int rr_error_base;
 	if (!XRRQueryExtension(display, &rr_event_base, &rr_error_base)) {
-		fprintf(stderr, "banana: RandR extension not available\n");
+		LOG_ERROR("banana: RandR extension not available\n");
 	} else {
 		XRRSelectInput(display, root, RRScreenChangeNotifyMask);
-		fprintf(stderr, "RandR extension initialized, listening for "
-				"screen changes\n");
+		LOG_INFO("RandR extension initialized, listening for "
+			 "screen changes\n");
 	}
 
 	normalCursor   = XcursorLibraryLoadCursor(display, "left_ptr");
@@ -324,7 +428,7 @@ void setup()
 	XChangeWindowAttributes(display, root, CWEventMask, &wa);
 	XSelectInput(display, root, wa.event_mask);
 
-	fprintf(stderr, "Root window listening to events\n");
+	LOG_DEBUG("Root window listening to events\n");
 
 	updateMonitors();
 
@@ -340,25 +444,31 @@ void setup()
 
 	for (int i = 0; i < numMonitors; i++) {
 		if (hasDocksOnMonitor(i) && barVisible) {
-			fprintf(stderr,
-				"Hiding bar because docks are detected on "
-				"monitor %d\n",
-				i);
+			LOG_DEBUG("Hiding bar because docks are detected on "
+				  "monitor %d\n",
+				  i);
 			barVisible = 0;
 			showHideBars(0);
 			break;
 		}
 	}
 
+	/* windows a restart left behind keep their state, the rest are new */
+	restoredState = restoreState();
 	scanExistingWindows();
 
 	updateClientPositionsForBar();
 	updateClientVisibility();
 
 	if (ipcInitServer() != 0) {
-		fprintf(stderr, "Failed to initialize IPC server\n");
+		LOG_ERROR("Failed to initialize IPC server\n");
 	}
 
+	initProcessTracker();
+	initStats(display);
+	initTrace();
+	initRecord();
+
 	XSync(display, False);
 }
 
@@ -389,8 +499,8 @@ void checkCursorPosition(struct timeval *lastCheck, int *lastCursorX,
 	int	     root_x, root_y, win_x, win_y;
 	unsigned int mask;
 
-	if (!XQueryPointer(display, root, &root_return, &child_return, &root_x,
-			   &root_y, &win_x, &win_y, &mask)) {
+	if (!backend->queryPointer(display, root, &root_return, &child_return,
+				   &root_x, &root_y, &win_x, &win_y, &mask)) {
 		return;
 	}
 
@@ -439,10 +549,10 @@ void checkCursorPosition(struct timeval *lastCheck, int *lastCursorX,
 			return;
 		}
 
-		fprintf(stderr,
-			"Cursor over window 0x%lx (currently focused: 0x%lx)\n",
-			windowUnderCursor->window,
-			focused ? focused->window : 0);
+		LOG_DEBUG("Cursor over window 0x%lx (currently focused: "
+			  "0x%lx)\n",
+			  windowUnderCursor->window,
+			  focused ? focused->window : 0);
 		focusClient(windowUnderCursor);
 		return;
 	}
@@ -452,21 +562,51 @@ void checkCursorPosition(struct timeval *lastCheck, int *lastCursorX,
 		    currentMonitor->num, currentMonitor->currentWorkspace);
 
 		if (clientInWorkspace) {
-			fprintf(stderr, "Focusing client on monitor %d\n",
-				currentMonitor->num);
+			LOG_DEBUG("Focusing client on monitor %d\n",
+				  currentMonitor->num);
 			focusClient(clientInWorkspace);
 		} else {
-			fprintf(stderr, "Focusing root on monitor %d\n",
-				currentMonitor->num);
+			LOG_DEBUG("Focusing root on monitor %d\n",
+				  currentMonitor->num);
 			focused = NULL;
-			XSetInputFocus(display, root, RevertToPointerRoot,
-				       CurrentTime);
+			backend->setInputFocus(
+			    display, root, RevertToPointerRoot, CurrentTime);
 			updateBorders();
 			updateBars();
 		}
 	}
 }
 
+void dispatchEvent(XEvent *event)
+{
+	uint64_t start = statsNow();
+	int	 type  = event->type;
+
+	if (event->type == rr_event_base + RRScreenChangeNotify) {
+		handleScreenChange(event);
+		type = STATS_EVENT_SCREEN_CHANGE;
+	} else if (handleSyncAlarm(event)) {
+		type = STATS_EVENT_SYNC_ALARM;
+	} else if (event->type < LASTEvent && eventHandlers[event->type]) {
+		XErrorHandler oldHandler = XSetErrorHandler(xerrorHandler);
+		eventHandlers[event->type](event);
+		backend->sync(display, False);
+		XSetErrorHandler(oldHandler);
+	} else {
+		return;
+	}
+
+	uint64_t end = statsNow();
+	statsRecordEvent(type, end - start);
+	traceSpan(TRACE_X11, statsEventName(type), event->xany.window, start,
+		  end);
+}
+
+int getRandrEventBase(void)
+{
+	return rr_event_base;
+}
+
 void run()
 {
 	XEvent	       event;
@@ -475,41 +615,84 @@ void run()
 	Window	       lastWindow = None;
 	gettimeofday(&lastCheck, NULL);
 
-	XSync(display, False);
-	fprintf(stderr, "Starting main event loop\n");
+	backend->sync(display, False);
+	LOG_INFO("Starting main event loop\n");
 
 	updateClientVisibility();
 	updateBars();
 
+	struct pollfd fds[IPC_MAX_CLIENTS + 3];
+	int	      count	= 0;
+	int	      ipcOffset = 1;
+
 	while (1) {
-		if (XPending(display)) {
+		int	 handled       = 0;
+		SClient *previousFocus = focused;
+
+		if (ipcOffset > 1 && fds[1].revents) {
+			handleProcessEvents();
+		}
+		handleTraceSignal();
+
+		while (XPending(display)) {
 			XNextEvent(display, &event);
+			handled = 1;
 
-			if (event.type ==
-			    rr_event_base + RRScreenChangeNotify) {
-				handleScreenChange(&event);
-			} else if (eventHandlers[event.type]) {
-				XErrorHandler oldHandler =
-				    XSetErrorHandler(xerrorHandler);
-				eventHandlers[event.type](&event);
-				XSync(display, False);
-				XSetErrorHandler(oldHandler);
-			}
-		} else {
-			int ipc_result = ipcHandleCommands();
-			if (ipc_result > 0) {
-				reloadConfig(NULL);
-			}
+			recordEvent(&event);
+			dispatchEvent(&event);
+		}
+
+		XErrorHandler oldHandler = XSetErrorHandler(xerrorHandler);
+		if (count > ipcOffset &&
+		    ipcHandleCommands(fds + ipcOffset, count - ipcOffset) > 0) {
+			backend->sync(display, False);
+			handled = 1;
+		}
+		XSetErrorHandler(oldHandler);
+
+		checkCursorPosition(&lastCheck, &lastCursorX, &lastCursorY,
+				    &lastWindow);
+		int dragWait = applyPendingDrag();
+		flushRootProperties();
+
+		if (handled || focused != previousFocus) {
+			snapshotPublish();
+		}
+
+		backend->flush(display);
+
+		fds[0].fd      = ConnectionNumber(display);
+		fds[0].events  = POLLIN;
+		fds[0].revents = 0;
+		ipcOffset      = 1;
 
-			checkCursorPosition(&lastCheck, &lastCursorX,
-					    &lastCursorY, &lastWindow);
-			usleep(5000);
+		if (getProcessTrackerFd() != -1) {
+			fds[1].fd      = getProcessTrackerFd();
+			fds[1].events  = POLLIN;
+			fds[1].revents = 0;
+			ipcOffset      = 2;
+		}
+
+		count = ipcOffset +
+			ipcPollFds(fds + ipcOffset, IPC_MAX_CLIENTS + 1);
+
+		int timeout = dragWait >= 0 && dragWait < 50 ? dragWait : 50;
+
+		/* events read by a sync or pointer query wait in xlib */
+		if (QLength(display) > 0) {
+			timeout = 0;
+		}
+		if (poll(fds, count, timeout) == -1 && errno != EINTR) {
+			LOG_ERROR("poll failed: %s\n", strerror(errno));
 		}
 	}
 }
 
 void cleanup()
 {
+	revealHiddenClients();
+	hideOutline();
+
 	if (barWindows) {
 		for (int i = 0; i < numMonitors; i++) {
 			if (barWindows[i] != 0) {
@@ -533,6 +716,8 @@ void cleanup()
 		clients	     = clients->next;
 		free(tmp);
 	}
+	free(appliedStack);
+	free(clientListOrder);
 
 	if (wmcheckwin) {
 		XDestroyWindow(display, wmcheckwin);
@@ -545,9 +730,14 @@ void cleanup()
 	XFreeCursor(display, resizeNECursor);
 	XFreeCursor(display, resizeNWCursor);
 
+	cleanupPools();
 	freeConfig();
 
 	ipcCleanup();
+	snapshotCleanup();
+	cleanupProcessTracker();
+	cleanupTrace();
+	cleanupRecord();
 
 	XCloseDisplay(display);
 }
@@ -563,7 +753,7 @@ void handleKeyPress(XEvent *event)
 
 	for (size_t i = 0; i < keysCount; i++) {
 		if (keys[i].keysym == keysym && keys[i].mod == state) {
-			keys[i].func(keys[i].arg);
+			statsRunAction(keys[i].func, keys[i].arg);
 			break;
 		}
 	}
@@ -624,14 +814,15 @@ void handleButtonPress(XEvent *event)
 			client->width  = newWidth;
 			client->height = newHeight;
 
-			XSetWindowBorderWidth(display, client->window,
-					      borderWidth);
+			backend->setWindowBorderWidth(display, client->window,
+						      borderWidth);
 			updateBorders();
 
-			XMoveResizeWindow(display, client->window, client->x,
-					  client->y, client->width,
-					  client->height);
-			XRaiseWindow(display, client->window);
+			backend->moveResizeWindow(display, client->window,
+						  client->x, client->y,
+						  client->width,
+						  client->height);
+			raiseClient(client);
 
 			XGrabButton(display, Button3, modkey, client->window,
 				    False,
@@ -744,8 +935,8 @@ void swapWindowUnderCursor(SClient *client, int cursorX, int cursorY)
 	}
 
 	if (targetClient) {
-		fprintf(stderr, "Swapping client 0x%lx with 0x%lx\n",
-			client->window, targetClient->window);
+		LOG_DEBUG("Swapping client 0x%lx with 0x%lx\n", client->window,
+			  targetClient->window);
 		client->isFloating = 0;
 
 		XUngrabButton(display, Button3, modkey, client->window);
@@ -758,11 +949,12 @@ void swapWindowUnderCursor(SClient *client, int cursorX, int cursorY)
 
 			if (lastClient && lastClient != targetClient &&
 			    lastClient != client) {
-				fprintf(stderr,
-					"Unmapping previously visible monocle "
-					"window: 0x%lx\n",
-					lastClient->window);
-				XUnmapWindow(display, lastClient->window);
+				LOG_DEBUG("Unmapping previously visible "
+					  "monocle "
+					  "window: 0x%lx\n",
+					  lastClient->window);
+				backend->unmapWindow(display,
+						     lastClient->window);
 			}
 
 			monitor->lastTiledClient[client->workspace] =
@@ -779,7 +971,83 @@ void swapWindowUnderCursor(SClient *client, int cursorX, int cursorY)
 		arrangeClients(&monitors[client->monitor]);
 	}
 
-	restackFloatingWindows();
+	restackClients();
+}
+
+/* sends the geometry a move or resize left in the model */
+static void applyDrag(SClient *client)
+{
+	dragHeld      = NULL;
+	lastDragApply = statsNow();
+
+	if (windowMovement.active && windowMovement.client == client) {
+		moveWindow(client, client->x, client->y);
+		return;
+	}
+
+	sendSyncRequest(client);
+	backend->moveResizeWindow(display, client->window, client->x, client->y,
+				  client->width, client->height);
+	raiseClient(client);
+	configureClient(client);
+}
+
+/*
+ * whether the next geometry of a dragged client stays in the model, outline
+ * mode keeps all of it until the button is released, a resize keeps it while
+ * the client has not answered the last sync request and throttle mode keeps
+ * whatever arrives within 1/drag_rate seconds of the last one sent
+ */
+static int deferDrag(SClient *client)
+{
+	if (!client->isFloating || client->isFullscreen || client->isDock) {
+		return 0;
+	}
+
+	if (dragMode == DRAG_OUTLINE) {
+		return 1;
+	}
+
+	if (windowResize.active && syncRequestWait(client)) {
+		return 1;
+	}
+
+	if (dragMode == DRAG_LIVE) {
+		return 0;
+	}
+
+	return statsNow() - lastDragApply < 1000000000ULL / dragRate;
+}
+
+static void holdDrag(SClient *client)
+{
+	dragHeld = client;
+
+	if (dragMode == DRAG_OUTLINE) {
+		showOutline(client->x, client->y, client->width,
+			    client->height);
+	}
+}
+
+int applyPendingDrag(void)
+{
+	if (!dragHeld || dragMode == DRAG_OUTLINE) {
+		return -1;
+	}
+
+	int syncWait = windowResize.active ? syncRequestWait(dragHeld) : 0;
+	if (syncWait) {
+		return syncWait;
+	}
+
+	uint64_t elapsed  = statsNow() - lastDragApply;
+	uint64_t interval = 1000000000ULL / dragRate;
+	if (dragMode == DRAG_THROTTLE && elapsed < interval) {
+		return (int)((interval - elapsed) / 1000000) + 1;
+	}
+
+	applyDrag(dragHeld);
+	return -1;
 }
 
 void handleButtonRelease(XEvent *event)
@@ -789,11 +1057,13 @@ void handleButtonRelease(XEvent *event)
 	if (windowMovement.active && ev->button == Button1) {
 		SClient *movingClient = windowMovement.client;
 
+		hideOutline();
+		dragHeld = NULL;
+
 		if (movingClient && windowMovement.wasTiled) {
-			fprintf(stderr,
-				"Attempting to swap with window under cursor "
-				"at %d,%d\n",
-				ev->x_root, ev->y_root);
+			LOG_DEBUG("Attempting to swap with window under cursor "
+				  "at %d,%d\n",
+				  ev->x_root, ev->y_root);
 			swapWindowUnderCursor(movingClient, ev->x_root,
 					      ev->y_root);
 		} else if (movingClient) {
@@ -814,7 +1084,13 @@ void handleButtonRelease(XEvent *event)
 	if (windowResize.active && ev->button == Button3) {
 		SClient *resizingClient = windowResize.client;
 
+		hideOutline();
+		if (dragHeld) {
+			applyDrag(dragHeld);
+		}
+
 		if (resizingClient) {
+			endSyncRequest(resizingClient);
 			focusClient(resizingClient);
 		}
 
@@ -878,12 +1154,12 @@ void handleMotionNotify(XEvent *event)
 			if (clientInWorkspace) {
 				focusClient(clientInWorkspace);
 			} else {
-				XSetInputFocus(display, root,
-					       RevertToPointerRoot,
-					       CurrentTime);
+				backend->setInputFocus(display, root,
+						       RevertToPointerRoot,
+						       CurrentTime);
 				focused = NULL;
-				XDeleteProperty(display, root,
-						NET_ACTIVE_WINDOW);
+				backend->deleteProperty(display, root,
+							NET_ACTIVE_WINDOW);
 				updateBorders();
 			}
 		}
@@ -893,11 +1169,17 @@ void handleMotionNotify(XEvent *event)
 		;
 
 	if (windowMovement.active && windowMovement.client) {
-		int dx = ev->x_root - windowMovement.x;
-		int dy = ev->y_root - windowMovement.y;
-
-		moveWindow(windowMovement.client, windowMovement.client->x + dx,
-			   windowMovement.client->y + dy);
+		int	 dx	= ev->x_root - windowMovement.x;
+		int	 dy	= ev->y_root - windowMovement.y;
+		SClient *client = windowMovement.client;
+
+		if (deferDrag(client)) {
+			client->x += dx;
+			client->y += dy;
+			holdDrag(client);
+		} else {
+			moveWindow(client, client->x + dx, client->y + dy);
+		}
 
 		windowMovement.x = ev->x_root;
 		windowMovement.y = ev->y_root;
@@ -985,60 +1267,55 @@ void handleMotionNotify(XEvent *event)
 
 		case 0:
 		default:
-			resizeWindow(windowResize.client,
-				     windowResize.client->width + dx,
-				     windowResize.client->height + dy);
+			newWidth  = client->width + dx;
+			newHeight = client->height + dy;
+
+			if (newWidth >= 15) {
+				client->width = newWidth;
+			}
+			if (newHeight >= 15) {
+				client->height = newHeight;
+			}
 			break;
 		}
 
-		if (windowResize.resizeType != 0) {
-			if (client->sizeHints.valid) {
-				if (client->sizeHints.minWidth > 0 &&
-				    client->width <
-					client->sizeHints.minWidth) {
-					int oldWidth = client->width;
-					client->width =
-					    client->sizeHints.minWidth;
-					if (windowResize.resizeType == 1 ||
-					    windowResize.resizeType == 3) {
-						client->x -=
-						    (client->width - oldWidth);
-					}
+		if (client->sizeHints.valid) {
+			if (client->sizeHints.minWidth > 0 &&
+			    client->width < client->sizeHints.minWidth) {
+				int oldWidth  = client->width;
+				client->width = client->sizeHints.minWidth;
+				if (windowResize.resizeType == 1 ||
+				    windowResize.resizeType == 3) {
+					client->x -= (client->width - oldWidth);
 				}
+			}
 
-				if (client->sizeHints.minHeight > 0 &&
-				    client->height <
-					client->sizeHints.minHeight) {
-					int oldHeight = client->height;
-					client->height =
-					    client->sizeHints.minHeight;
-					if (windowResize.resizeType == 2 ||
-					    windowResize.resizeType == 3) {
-						client->y -= (client->height -
-							      oldHeight);
-					}
+			if (client->sizeHints.minHeight > 0 &&
+			    client->height < client->sizeHints.minHeight) {
+				int oldHeight  = client->height;
+				client->height = client->sizeHints.minHeight;
+				if (windowResize.resizeType == 2 ||
+				    windowResize.resizeType == 3) {
+					client->y -=
+					    (client->height - oldHeight);
 				}
+			}
 
-				if (client->sizeHints.maxWidth > 0 &&
-				    client->width >
-					client->sizeHints.maxWidth) {
-					client->width =
-					    client->sizeHints.maxWidth;
-				}
+			if (client->sizeHints.maxWidth > 0 &&
+			    client->width > client->sizeHints.maxWidth) {
+				client->width = client->sizeHints.maxWidth;
+			}
 
-				if (client->sizeHints.maxHeight > 0 &&
-				    client->height >
-					client->sizeHints.maxHeight) {
-					client->height =
-					    client->sizeHints.maxHeight;
-				}
+			if (client->sizeHints.maxHeight > 0 &&
+			    client->height > client->sizeHints.maxHeight) {
+				client->height = client->sizeHints.maxHeight;
 			}
+		}
 
-			XMoveResizeWindow(display, client->window, client->x,
-					  client->y, client->width,
-					  client->height);
-			XRaiseWindow(display, client->window);
-			configureClient(client);
+		if (deferDrag(client)) {
+			holdDrag(client);
+		} else {
+			applyDrag(client);
 		}
 
 		windowResize.x = ev->x_root;
@@ -1079,13 +1356,13 @@ void moveWindow(SClient *client, int x, int y)
 		client->workspace = monitor->currentWorkspace;
 	}
 
-	XMoveWindow(display, client->window, client->x, client->y);
+	backend->moveWindow(display, client->window, client->x, client->y);
 
 	configureClient(client);
 
 	if (prevMonitor != client->monitor) {
-		fprintf(stderr, "Window moved to a different monitor, updating "
-				"layout\n");
+		LOG_DEBUG("Window moved to a different monitor, updating "
+			  "layout\n");
 
 		focusClient(client);
 
@@ -1101,11 +1378,11 @@ void moveWindow(SClient *client, int x, int y)
 	if (windowMovement.active && windowMovement.client == client &&
 	    monitor->currentLayout == LAYOUT_MONOCLE) {
 		focusClient(client);
-		XRaiseWindow(display, client->window);
+		raiseClient(client);
 	}
 
 	if (windowMovement.active && windowMovement.client == client) {
-		XRaiseWindow(display, client->window);
+		raiseClient(client);
 	}
 }
 
@@ -1125,8 +1402,9 @@ void resizeWindow(SClient *client, int width, int height)
 		client->width	  = monitor->width;
 		client->height	  = monitor->height;
 
-		XMoveResizeWindow(display, client->window, client->x, client->y,
-				  client->width, client->height);
+		backend->moveResizeWindow(display, client->window, client->x,
+					  client->y, client->width,
+					  client->height);
 		configureClient(client);
 		return;
 	}
@@ -1165,13 +1443,15 @@ void resizeWindow(SClient *client, int width, int height)
 	client->width  = width;
 	client->height = height;
 
-	XResizeWindow(display, client->window, client->width, client->height);
+	backend->resizeWindow(display, client->window, client->width,
+			      client->height);
 
 	if (windowResize.active && windowResize.client == client) {
-		XRaiseWindow(display, client->window);
+		raiseClient(client);
 		if (!client->neverfocus) {
-			XSetInputFocus(display, client->window,
-				       RevertToPointerRoot, CurrentTime);
+			backend->setInputFocus(display, client->window,
+					       RevertToPointerRoot,
+					       CurrentTime);
 		}
 	}
 
@@ -1182,8 +1462,8 @@ void handleEnterNotify(XEvent *event)
 {
 	XCrossingEvent *ev = &event->xcrossing;
 
-	fprintf(stderr, "Enter notify event for window 0x%lx (ignored)\n",
-		ev->window);
+	LOG_DEBUG("Enter notify event for window 0x%lx (ignored)\n",
+		  ev->window);
 }
 
 void handleMapRequest(XEvent *event)
@@ -1191,6 +1471,11 @@ void handleMapRequest(XEvent *event)
 	XMapRequestEvent *ev = &event->xmaprequest;
 
 	gettimeofday(&lastWindowOperation, NULL);
+
+	if (!findClient(ev->window) && claimPooledWindow(ev->window)) {
+		return;
+	}
+
 	lastMappedWindow = ev->window;
 
 	manageClient(ev->window);
@@ -1200,8 +1485,8 @@ void handleMapRequest(XEvent *event)
 		SMonitor *monitor = &monitors[client->monitor];
 		Atom	  state	  = getAtomProperty(client, NET_WM_STATE);
 		if (state == NET_WM_STATE_FULLSCREEN) {
-			fprintf(stderr, "Detected fullscreen window during map "
-					"request, forcing proper position\n");
+			LOG_DEBUG("Detected fullscreen window during map "
+				  "request, forcing proper position\n");
 
 			client->oldx	  = client->x;
 			client->oldy	  = client->y;
@@ -1215,12 +1500,14 @@ void handleMapRequest(XEvent *event)
 			client->isFullscreen = 1;
 			client->isFloating   = 1;
 
-			XMoveResizeWindow(display, client->window, client->x,
-					  client->y, client->width,
-					  client->height);
-			XSetWindowBorderWidth(display, client->window, 0);
+			backend->moveResizeWindow(display, client->window,
+						  client->x, client->y,
+						  client->width,
+						  client->height);
+			backend->setWindowBorderWidth(display, client->window,
+						      0);
 			configureClient(client);
-			XRaiseWindow(display, client->window);
+			raiseClient(client);
 		}
 
 		int	 hasFullscreenWindow = 0;
@@ -1238,16 +1525,16 @@ void handleMapRequest(XEvent *event)
 		}
 
 		if (client->isDock || client->workspace == DOCK_WORKSPACE) {
-			XMapWindow(display, ev->window);
-			XRaiseWindow(display, ev->window);
-			fprintf(stderr, "Mapping dock window during map "
-					"request\n");
+			backend->mapWindow(display, ev->window);
+			raiseClient(client);
+			LOG_DEBUG("Mapping dock window during map "
+				  "request\n");
 		} else if (client->workspace == monitor->currentWorkspace &&
 			   !hasFullscreenWindow) {
-			XMapWindow(display, ev->window);
+			backend->mapWindow(display, ev->window);
 			focusClient(client);
 		} else {
-			XUnmapWindow(display, ev->window);
+			backend->unmapWindow(display, ev->window);
 
 			if (hasFullscreenWindow && fullscreenClient) {
 				focusClient(fullscreenClient);
@@ -1255,16 +1542,22 @@ void handleMapRequest(XEvent *event)
 		}
 
 		if (!client->isFloating && !client->isFullscreen) {
-			XSync(display, False);
+			backend->sync(display, False);
 			arrangeClients(monitor);
 		}
 
-		restackFloatingWindows();
+		restackClients();
 	} else {
-		XMapWindow(display, ev->window);
+		backend->mapWindow(display, ev->window);
 	}
 }
 
+/* where offscreen workspace switching parks a hidden window */
+static int hiddenX(SClient *client)
+{
+	return -2 * (client->width + 2 * borderWidth);
+}
+
 void handleConfigureRequest(XEvent *event)
 {
 	XConfigureRequestEvent *ev = &event->xconfigurerequest;
@@ -1280,8 +1573,8 @@ void handleConfigureRequest(XEvent *event)
 	SClient *client = findClient(ev->window);
 	if (client) {
 		if (client->isFullscreen) {
-			fprintf(stderr, "Intercepting configure request for "
-					"fullscreen window\n");
+			LOG_DEBUG("Intercepting configure request for "
+				  "fullscreen window\n");
 			SMonitor *monitor = &monitors[client->monitor];
 			wc.x		  = monitor->x;
 			wc.y		  = monitor->y;
@@ -1289,21 +1582,38 @@ void handleConfigureRequest(XEvent *event)
 			wc.height	  = monitor->height;
 			wc.border_width	  = 0;
 		} else if (!client->isFloating) {
-			fprintf(stderr, "Intercepting configure request for "
-					"tiled window\n");
+			LOG_DEBUG("Intercepting configure request for "
+				  "tiled window\n");
 			wc.x		= client->x;
 			wc.y		= client->y;
 			wc.width	= client->width;
 			wc.height	= client->height;
 			wc.border_width = borderWidth;
 		}
+
+		/* a hidden window stays parked until its workspace is shown */
+		if (client->isHidden) {
+			wc.x = hiddenX(client);
+		}
+	}
+
+	/* managed windows are stacked through the stack list instead */
+	unsigned long mask = ev->value_mask;
+	if (client) {
+		mask &= ~(CWSibling | CWStackMode);
 	}
 
-	XConfigureWindow(display, ev->window, ev->value_mask, &wc);
+	backend->configureWindow(display, ev->window, mask, &wc);
 
 	if (client) {
 		configureClient(client);
-		restackFloatingWindows();
+		if ((ev->value_mask & CWStackMode) && ev->detail == Below) {
+			lowerClient(client);
+		} else if (ev->value_mask & CWStackMode) {
+			raiseClient(client);
+		} else {
+			restackClients();
+		}
 	}
 }
 
@@ -1331,6 +1641,8 @@ void handleDestroyNotify(XEvent *event)
 
 	if (client) {
 		unmanageClient(ev->window);
+	} else {
+		forgetPooledWindow(ev->window);
 	}
 }
 
@@ -1340,36 +1652,11 @@ void spawnProgram(const char *program)
 		return;
 	}
 
-	pid_t pid = fork();
-
-	if (pid == -1) {
-		fprintf(stderr, "banana: fork failed for program '%s'\n",
-			program);
+	if (takePooledWindow(program)) {
 		return;
 	}
 
-	if (pid == 0) {
-		if (display) {
-			close(ConnectionNumber(display));
-		}
-
-		setsid();
-
-		int devnull = open("/dev/null", O_RDWR);
-		if (devnull != -1) {
-			dup2(devnull, STDIN_FILENO);
-			dup2(devnull, STDOUT_FILENO);
-			dup2(devnull, STDERR_FILENO);
-			if (devnull > 2) {
-				close(devnull);
-			}
-		}
-
-		execl("/bin/sh", "sh", "-c", program, NULL);
-		fprintf(stderr, "banana: execl failed for program '%s': %s\n",
-			program, strerror(errno));
-		exit(EXIT_FAILURE);
-	}
+	spawnCommand(program);
 }
 
 void killClient(const char *arg)
@@ -1381,21 +1668,20 @@ void killClient(const char *arg)
 	}
 
 	if (focused->swallowed) {
-		fprintf(stderr,
-			"Not killing client 0x%lx - it's swallowing another "
-			"window\n",
-			focused->window);
+		LOG_DEBUG("Not killing client 0x%lx - it's swallowing another "
+			  "window\n",
+			  focused->window);
 		return;
 	}
 
-	fprintf(stderr, "Killing client 0x%lx\n", focused->window);
+	LOG_DEBUG("Killing client 0x%lx\n", focused->window);
 
 	if (!sendEvent(focused, WM_DELETE_WINDOW)) {
 		XGrabServer(display);
 		XSetErrorHandler(xerrorHandler);
 		XSetCloseDownMode(display, DestroyAll);
 		XKillClient(display, focused->window);
-		XSync(display, False);
+		backend->sync(display, False);
 		XUngrabServer(display);
 	}
 }
@@ -1430,46 +1716,125 @@ void grabKeys()
 			 GrabModeAsync);
 	}
 
-	fprintf(stderr, "Key grabs set up on root window\n");
+	LOG_DEBUG("Key grabs set up on root window\n");
 }
 
 void updateFocus()
 {
 	if (!focused) {
-		XSetInputFocus(display, root, RevertToPointerRoot, CurrentTime);
-		XDeleteProperty(display, root, NET_ACTIVE_WINDOW);
+		backend->setInputFocus(display, root, RevertToPointerRoot,
+				       CurrentTime);
+		backend->deleteProperty(display, root, NET_ACTIVE_WINDOW);
 		return;
 	}
 
-	XSetInputFocus(display, focused->window, RevertToPointerRoot,
-		       CurrentTime);
-	XChangeProperty(display, root, NET_ACTIVE_WINDOW, XA_WINDOW, 32,
-			PropModeReplace, (unsigned char *)&focused->window, 1);
+	backend->setInputFocus(display, focused->window, RevertToPointerRoot,
+			       CurrentTime);
+	backend->changeProperty(display, root, NET_ACTIVE_WINDOW, XA_WINDOW, 32,
+				PropModeReplace,
+				(unsigned char *)&focused->window, 1);
 	updateBorders();
 }
 
+/*
+ * each workspace of a monitor keeps its clients in most recently focused
+ * order, a client stays on the list it was focused on and is dropped when a
+ * lookup finds it has moved to another monitor or workspace since
+ */
+static void unlinkFocusHistory(SClient *client)
+{
+	int monitor   = client->focusMonitor;
+	int workspace = client->focusWorkspace;
+
+	if (client->focusPrev) {
+		client->focusPrev->focusNext = client->focusNext;
+	} else if (monitor >= 0 && monitor < numMonitors && workspace >= 0 &&
+		   workspace < MAX_WORKSPACES &&
+		   monitors[monitor].focusHistory[workspace] == client) {
+		monitors[monitor].focusHistory[workspace] = client->focusNext;
+	}
+
+	if (client->focusNext) {
+		client->focusNext->focusPrev = client->focusPrev;
+	}
+
+	client->focusPrev = NULL;
+	client->focusNext = NULL;
+}
+
+static void pushFocusHistory(SClient *client)
+{
+	unlinkFocusHistory(client);
+
+	if (client->monitor < 0 || client->monitor >= numMonitors ||
+	    client->workspace < 0 || client->workspace >= MAX_WORKSPACES) {
+		return;
+	}
+
+	SClient **head =
+	    &monitors[client->monitor].focusHistory[client->workspace];
+
+	client->focusMonitor   = client->monitor;
+	client->focusWorkspace = client->workspace;
+	client->focusNext      = *head;
+	if (*head) {
+		(*head)->focusPrev = client;
+	}
+	*head = client;
+}
+
+SClient *recentClient(int monitor, int workspace, int tiled)
+{
+	if (monitor < 0 || monitor >= numMonitors || workspace < 0 ||
+	    workspace >= MAX_WORKSPACES) {
+		return NULL;
+	}
+
+	SClient *client = monitors[monitor].focusHistory[workspace];
+	while (client) {
+		SClient *next = client->focusNext;
+
+		if (client->monitor != monitor ||
+		    client->workspace != workspace) {
+			unlinkFocusHistory(client);
+		} else if (!tiled ||
+			   (!client->isFloating && !client->isFullscreen)) {
+			return client;
+		}
+
+		client = next;
+	}
+
+	return NULL;
+}
+
 void focusClient(SClient *client)
 {
 	if (!client) {
 		return;
 	}
 
-	fprintf(stderr, "Attempting to focus: 0x%lx\n", client->window);
+	LOG_DEBUG("Attempting to focus: 0x%lx\n", client->window);
 
 	XWindowAttributes wa;
-	if (!XGetWindowAttributes(display, client->window, &wa)) {
-		fprintf(stderr, "  Window no longer exists\n");
+	if (!backend->getWindowAttributes(display, client->window, &wa)) {
+		LOG_DEBUG("  Window no longer exists\n");
 		return;
 	}
 
 	if (wa.map_state != IsViewable) {
-		fprintf(stderr, "  Window not viewable (state: %d)\n",
-			wa.map_state);
+		/* batched arranges map the window once the batch ends */
+		if (updateBatchDepth > 0 &&
+		    client->workspace ==
+			monitors[client->monitor].currentWorkspace) {
+			deferredFocus = client;
+		}
+		LOG_DEBUG("  Window not viewable (state: %d)\n", wa.map_state);
 		return;
 	}
 
 	if (wa.override_redirect) {
-		fprintf(stderr, "  Window has override_redirect set\n");
+		LOG_DEBUG("  Window has override_redirect set\n");
 		return;
 	}
 
@@ -1477,7 +1842,9 @@ void focusClient(SClient *client)
 		lastFocused = focused;
 	}
 
-	focused = client;
+	focused	      = client;
+	deferredFocus = NULL;
+	pushFocusHistory(client);
 
 	if (no_warps) {
 		forcedMonitor = client->monitor;
@@ -1486,81 +1853,247 @@ void focusClient(SClient *client)
 	if (!client->isFloating && !client->isFullscreen) {
 		SMonitor *monitor = &monitors[client->monitor];
 		monitor->lastTiledClient[client->workspace] = client->window;
-		fprintf(stderr,
-			"Updating last tiled client for workspace %d to "
-			"0x%lx\n",
-			client->workspace, client->window);
+		LOG_DEBUG("Updating last tiled client for workspace %d to "
+			  "0x%lx\n",
+			  client->workspace, client->window);
 	}
 
 	if ((windowMovement.active && windowMovement.client == client) ||
 	    (windowResize.active && windowResize.client == client)) {
-		XRaiseWindow(display, client->window);
-	}
-
-	static unsigned long activeBorder = 0;
-	if (activeBorder == 0) {
-		XColor	 color;
-		Colormap cmap =
-		    DefaultColormap(display, DefaultScreen(display));
-
-		if (XAllocNamedColor(display, cmap, activeBorderColor, &color,
-				     &color)) {
-			activeBorder = color.pixel | 0xFF000000;
-		} else {
-			activeBorder =
-			    BlackPixel(display, DefaultScreen(display)) |
-			    0xFF000000;
-		}
-	}
-
-	SMonitor *monitor = &monitors[client->monitor];
-	if (!client->isFullscreen && !client->isDock &&
-	    !(monitor->currentLayout == LAYOUT_MONOCLE &&
-	      !client->isFloating)) {
-		XSetWindowBorder(display, client->window, activeBorder);
+		raiseClient(client);
 	}
 
 	if (!client->neverfocus) {
-		XSetInputFocus(display, client->window, RevertToPointerRoot,
-			       CurrentTime);
-		XChangeProperty(display, root, NET_ACTIVE_WINDOW, XA_WINDOW, 32,
-				PropModeReplace,
-				(unsigned char *)&client->window, 1);
+		backend->setInputFocus(display, client->window,
+				       RevertToPointerRoot, CurrentTime);
+		backend->changeProperty(display, root, NET_ACTIVE_WINDOW,
+					XA_WINDOW, 32, PropModeReplace,
+					(unsigned char *)&client->window, 1);
 	}
 
 	sendEvent(client, WM_TAKE_FOCUS);
+	if (client->isUrgent) {
+		ipcEmitEvent(IPC_EVENT_URGENCY, client->window, client->monitor,
+			     client->workspace, 0);
+	}
 	client->isUrgent = 0;
 	updateClientUrgency(client);
 
 	updateBorders();
-	restackFloatingWindows();
+	restackClients();
 	updateBars();
+
+	ipcEmitEvent(IPC_EVENT_FOCUS, client->window, client->monitor,
+		     client->workspace, 0);
 }
 
-void manageClient(Window window)
+/* events, type, hints and button grabs every managed window needs */
+void setupClientWindow(SClient *client)
 {
-	if (findClient(window)) {
-		return;
-	}
+	XSelectInput(display, client->window,
+		     EnterWindowMask | FocusChangeMask | PropertyChangeMask |
+			 StructureNotifyMask | PointerMotionMask);
 
-	XWindowAttributes wa;
-	if (!XGetWindowAttributes(display, window, &wa)) {
-		fprintf(stderr,
-			"Cannot manage window 0x%lx: failed to get "
-			"attributes\n",
-			window);
-		return;
+	updateWindowType(client);
+	updateWMHints(client);
+
+	if (!client->isDock && !client->isFullscreen) {
+		XGrabButton(display, Button1, modkey, client->window, False,
+			    ButtonPressMask | ButtonReleaseMask |
+				ButtonMotionMask,
+			    GrabModeAsync, GrabModeAsync, None, moveCursor);
 	}
 
-	if (wa.override_redirect) {
-		fprintf(stderr, "Skipping override_redirect window 0x%lx\n",
-			window);
-		return;
+	if (client->isFloating && !client->isDock) {
+		XGrabButton(display, Button3, modkey, client->window, False,
+			    ButtonPressMask | ButtonReleaseMask |
+				ButtonMotionMask,
+			    GrabModeAsync, GrabModeAsync, None, resizeSECursor);
 	}
+}
 
-	SClient *client = malloc(sizeof(SClient));
+/* windows stay in the order they were managed in, as the spec asks */
+void clientListAdd(Window window)
+{
+	if (clientListCount == clientListSize) {
+		int size = clientListSize ? clientListSize * 2 : MAX_CLIENTS;
+		Window *grown = realloc(clientListOrder, size * sizeof(Window));
+		if (!grown) {
+			LOG_ERROR("Failed to allocate memory for client "
+				  "list\n");
+			return;
+		}
+		clientListOrder = grown;
+		clientListSize	= size;
+	}
+
+	clientListOrder[clientListCount++] = window;
+	invalidateRootProperties(ROOT_CLIENT_LIST);
+}
+
+static void clientListRemove(Window window)
+{
+	for (int i = 0; i < clientListCount; i++) {
+		if (clientListOrder[i] != window) {
+			continue;
+		}
+
+		memmove(&clientListOrder[i], &clientListOrder[i + 1],
+			(clientListCount - i - 1) * sizeof(Window));
+		clientListCount--;
+		if (i < clientListPublished) {
+			clientListPublished = -1;
+		} else if (clientListPublished > clientListCount) {
+			clientListPublished = clientListCount;
+		}
+		invalidateRootProperties(ROOT_CLIENT_LIST);
+		return;
+	}
+}
+
+static void detachStack(SClient *client)
+{
+	for (SClient **c = &stack; *c; c = &(*c)->stackNext) {
+		if (*c == client) {
+			*c = client->stackNext;
+			break;
+		}
+	}
+	client->stackNext = NULL;
+}
+
+/* on top of the stack without restacking, for windows that are new to it */
+void attachStack(SClient *client)
+{
+	client->stackNext = stack;
+	stack		  = client;
+}
+
+static EStackLayer stackLayer(SClient *client)
+{
+	if (client->isFullscreen) {
+		return STACK_FULLSCREEN;
+	}
+
+	if ((windowMovement.active && windowMovement.client == client) ||
+	    (windowResize.active && windowResize.client == client)) {
+		return STACK_FLOATING;
+	}
+
+	if (client->isDock) {
+		return STACK_DOCK;
+	}
+
+	return client->isFloating ? STACK_FLOATING : STACK_TILED;
+}
+
+void raiseClient(SClient *client)
+{
+	detachStack(client);
+	attachStack(client);
+	restackClients();
+}
+
+void lowerClient(SClient *client)
+{
+	detachStack(client);
+
+	SClient **tail = &stack;
+	while (*tail) {
+		tail = &(*tail)->stackNext;
+	}
+	*tail = client;
+	restackClients();
+}
+
+/*
+ * orders the bars and every managed window by layer, keeping the stack order
+ * within a layer, and only restacks them and publishes
+ * _NET_CLIENT_LIST_STACKING when that order differs from the last one sent
+ */
+void restackClients()
+{
+	int count = 0, firstBar = 0, bars = 0;
+
+	/* scanExistingWindows restacks once for all of them */
+	if (adopting) {
+		return;
+	}
+
+	int size = numMonitors + 1;
+	for (SClient *c = stack; c; c = c->stackNext) {
+		size++;
+	}
+	Window order[size];
+
+	for (int layer = STACK_LAYERS - 1; layer >= 0; layer--) {
+		if (layer == STACK_BAR) {
+			firstBar = count;
+			for (int i = 0; barWindows && i < numMonitors; i++) {
+				if (barWindows[i]) {
+					order[count++] = barWindows[i];
+					bars++;
+				}
+			}
+			continue;
+		}
+
+		for (SClient *c = stack; c; c = c->stackNext) {
+			if (stackLayer(c) == (EStackLayer)layer) {
+				order[count++] = c->window;
+			}
+		}
+	}
+
+	if (count == appliedStackCount &&
+	    memcmp(order, appliedStack, count * sizeof(Window)) == 0) {
+		return;
+	}
+
+	if (!appliedStack || count > appliedStackSize) {
+		Window *grown = realloc(appliedStack, size * sizeof(Window));
+		if (!grown) {
+			LOG_ERROR("Failed to allocate memory for stacking "
+				  "order\n");
+			return;
+		}
+		appliedStack	 = grown;
+		appliedStackSize = size;
+	}
+
+	if (count > 1) {
+		backend->restackWindows(display, order, count);
+	}
+	memcpy(appliedStack, order, count * sizeof(Window));
+	appliedStackCount = count;
+	appliedFirstBar	  = firstBar;
+	appliedBars	  = bars;
+
+	invalidateRootProperties(ROOT_CLIENT_LIST_STACKING);
+}
+
+void manageClient(Window window)
+{
+	if (findClient(window)) {
+		return;
+	}
+
+	XWindowAttributes wa;
+	if (!backend->getWindowAttributes(display, window, &wa)) {
+		LOG_ERROR("Cannot manage window 0x%lx: failed to get "
+			  "attributes\n",
+			  window);
+		return;
+	}
+
+	if (wa.override_redirect) {
+		LOG_DEBUG("Skipping override_redirect window 0x%lx\n", window);
+		return;
+	}
+
+	SClient *client = malloc(sizeof(SClient));
 	if (!client) {
-		fprintf(stderr, "Failed to allocate memory for client\n");
+		LOG_ERROR("Failed to allocate memory for client\n");
 		return;
 	}
 
@@ -1574,17 +2107,17 @@ void manageClient(Window window)
 
 	if (no_warps && forcedMonitor >= 0 && forcedMonitor < numMonitors) {
 		monitorNum = forcedMonitor;
-	} else if (XQueryPointer(display, root, &root_return, &child_return,
-				 &rootX, &rootY, &cursorX, &cursorY, &mask)) {
+	} else if (backend->queryPointer(display, root, &root_return,
+					 &child_return, &rootX, &rootY,
+					 &cursorX, &cursorY, &mask)) {
 		monitorNum = monitorAtPoint(rootX, rootY)->num;
-		fprintf(stderr,
-			"Using monitor %d at cursor position for new window\n",
-			monitorNum);
+		LOG_DEBUG("Using monitor %d at cursor position for new "
+			  "window\n",
+			  monitorNum);
 	} else if (focused) {
 		monitorNum = focused->monitor;
-		fprintf(stderr,
-			"Falling back to focused monitor %d for new window\n",
-			monitorNum);
+		LOG_DEBUG("Falling back to focused monitor %d for new window\n",
+			  monitorNum);
 	}
 
 	client->monitor		= monitorNum;
@@ -1597,6 +2130,8 @@ void manageClient(Window window)
 	client->isUrgent	= 0;
 	client->neverfocus	= 0;
 	client->oldState	= 0;
+	client->borderPixel	= 0;
+	client->isHidden	= 0;
 	client->oldx		= 0;
 	client->oldy		= 0;
 	client->oldwidth	= 0;
@@ -1608,12 +2143,26 @@ void manageClient(Window window)
 	client->sizeHints.valid = 0;
 	client->swallowed	= NULL;
 	client->swallowedBy	= NULL;
+	client->focusPrev	= NULL;
+	client->focusNext	= NULL;
+	client->focusMonitor	= 0;
+	client->focusWorkspace	= 0;
+	client->stackNext	= NULL;
+	client->syncAlarm	= None;
+	client->syncValue	= 0;
+	client->syncSent	= 0;
+	client->syncState	= SYNC_REQUEST_UNCHECKED;
+	client->syncWaiting	= 0;
 	client->isSwallowing	= 0;
 	client->noswallow	= 0;
 	client->pid		= getWindowPID(window);
 
+	getWindowClass(window, client->className, client->instanceName,
+		       sizeof(client->className));
+	updateClientTitle(client);
+
 	Window transientFor = None;
-	if (XGetTransientForHint(display, window, &transientFor)) {
+	if (backend->getTransientForHint(display, window, &transientFor)) {
 		SClient *parent = findClient(transientFor);
 		if (parent) {
 			client->monitor	   = parent->monitor;
@@ -1623,10 +2172,10 @@ void manageClient(Window window)
 			client->x = parent->x + 50;
 			client->y = parent->y + 50;
 
-			fprintf(stderr,
-				"Transient window detected, attached to parent "
-				"0x%lx\n",
-				transientFor);
+			LOG_DEBUG("Transient window detected, attached to "
+				  "parent "
+				  "0x%lx\n",
+				  transientFor);
 		}
 	}
 
@@ -1637,6 +2186,7 @@ void manageClient(Window window)
 	int	 willBeSwallowed = 0;
 	SClient *potentialParent = NULL;
 
+	resetProcessCache();
 	if (client->pid > 0) {
 		for (SClient *c = clients; c; c = c->next) {
 			if (c == client) {
@@ -1649,11 +2199,10 @@ void manageClient(Window window)
 				if (isChildProcess(c->pid, client->pid)) {
 					willBeSwallowed = 1;
 					potentialParent = c;
-					fprintf(stderr,
-						"Window 0x%lx will be "
-						"swallowed by 0x%lx - "
-						"preparing in advance\n",
-						window, c->window);
+					LOG_DEBUG("Window 0x%lx will be "
+						  "swallowed by 0x%lx - "
+						  "preparing in advance\n",
+						  window, c->window);
 					break;
 				}
 			}
@@ -1666,24 +2215,27 @@ void manageClient(Window window)
 		client->y	   = potentialParent->y;
 		client->width	   = potentialParent->width;
 		client->height	   = potentialParent->height;
-		fprintf(stderr,
-			"Pre-setting window 0x%lx as floating with parent "
-			"geometry: %dx%d at %d,%d\n",
-			window, client->width, client->height, client->x,
-			client->y);
+		LOG_DEBUG("Pre-setting window 0x%lx as floating with parent "
+			  "geometry: %dx%d at %d,%d\n",
+			  window, client->width, client->height, client->x,
+			  client->y);
 	}
 
 	applyRules(client);
 
+	if (client->isSwallowing) {
+		trackProcess(client->pid);
+	}
+
 	if (client->sizeHints.valid && client->sizeHints.maxWidth &&
 	    client->sizeHints.maxHeight && client->sizeHints.minWidth &&
 	    client->sizeHints.minHeight &&
 	    client->sizeHints.maxWidth == client->sizeHints.minWidth &&
 	    client->sizeHints.maxHeight == client->sizeHints.minHeight) {
 		client->isFloating = 1;
-		fprintf(stderr, "Auto-floating fixed size window: %dx%d\n",
-			client->sizeHints.minWidth,
-			client->sizeHints.minHeight);
+		LOG_DEBUG("Auto-floating fixed size window: %dx%d\n",
+			  client->sizeHints.minWidth,
+			  client->sizeHints.minHeight);
 	}
 
 	monitor = &monitors[client->monitor];
@@ -1769,71 +2321,55 @@ void manageClient(Window window)
 		}
 	}
 
-	XMoveResizeWindow(display, window, client->x, client->y, client->width,
-			  client->height);
+	/* new windows start at the top of their layer */
+	attachStack(client);
+
+	backend->moveResizeWindow(display, window, client->x, client->y,
+				  client->width, client->height);
 
-	XSetWindowBorderWidth(display, window, borderWidth);
+	backend->setWindowBorderWidth(display, window, borderWidth);
 
 	XErrorHandler oldHandler = XSetErrorHandler(xerrorHandler);
 
-	XSelectInput(display, window,
-		     EnterWindowMask | FocusChangeMask | PropertyChangeMask |
-			 StructureNotifyMask | PointerMotionMask);
-
-	updateWindowType(client);
-	updateWMHints(client);
+	setupClientWindow(client);
 
 	Atom	       actual_type;
 	int	       actual_format;
 	unsigned long  nitems, bytes_after;
 	unsigned char *data = NULL;
 
-	if (XGetWindowProperty(display, window, NET_WM_DESKTOP, 0, 1, False,
-			       XA_CARDINAL, &actual_type, &actual_format,
-			       &nitems, &bytes_after, &data) == Success &&
+	if (backend->getWindowProperty(display, window, NET_WM_DESKTOP, 0, 1,
+				       False, XA_CARDINAL, &actual_type,
+				       &actual_format, &nitems, &bytes_after,
+				       &data) == Success &&
 	    data) {
 		if (actual_type == XA_CARDINAL && actual_format == 32 &&
 		    nitems == 1) {
 			long desktop = *(long *)data;
 
 			if (desktop >= 0 && desktop < workspaceCount) {
-				fprintf(stderr,
-					"Window 0x%lx has existing "
-					"_NET_WM_DESKTOP = %ld\n",
-					window, desktop);
+				LOG_DEBUG("Window 0x%lx has existing "
+					  "_NET_WM_DESKTOP = %ld\n",
+					  window, desktop);
 				client->workspace = desktop;
 			}
 		}
 		XFree(data);
 	}
 
-	if (!client->isDock && !client->isFullscreen) {
-		XGrabButton(display, Button1, modkey, window, False,
-			    ButtonPressMask | ButtonReleaseMask |
-				ButtonMotionMask,
-			    GrabModeAsync, GrabModeAsync, None, moveCursor);
-	}
-
-	if (client->isFloating && !client->isDock) {
-		XGrabButton(display, Button3, modkey, window, False,
-			    ButtonPressMask | ButtonReleaseMask |
-				ButtonMotionMask,
-			    GrabModeAsync, GrabModeAsync, None, resizeSECursor);
-	}
-
-	XSync(display, False);
+	backend->sync(display, False);
 	XSetErrorHandler(oldHandler);
 
-	fprintf(stderr,
-		"Client managed: 0x%lx on monitor %d at position %d,%d with "
-		"size %dx%d\n",
-		window, client->monitor, client->x, client->y, client->width,
-		client->height);
+	LOG_DEBUG("Client managed: 0x%lx on monitor %d at position %d,%d with "
+		  "size %dx%d\n",
+		  window, client->monitor, client->x, client->y, client->width,
+		  client->height);
 
-	updateBorders();
+	if (!adopting) {
+		updateBorders();
+	}
 
-	XChangeProperty(display, root, NET_CLIENT_LIST, XA_WINDOW, 32,
-			PropModeAppend, (unsigned char *)&window, 1);
+	clientListAdd(window);
 	setClientState(client, NormalState);
 
 	configureClient(client);
@@ -1842,44 +2378,47 @@ void manageClient(Window window)
 	updateFrameExtents(client);
 
 	if (client->isDock) {
-		XMapWindow(display, client->window);
-		XRaiseWindow(display, client->window);
-		fprintf(stderr, "Mapping dock window 0x%lx immediately\n",
-			client->window);
+		backend->mapWindow(display, client->window);
+		raiseClient(client);
+		LOG_DEBUG("Mapping dock window 0x%lx immediately\n",
+			  client->window);
 
 		if (barVisible) {
-			fprintf(stderr,
-				"Hiding bar because a dock was "
-				"detected on monitor %d\n",
-				client->monitor);
+			LOG_DEBUG("Hiding bar because a dock was "
+				  "detected on monitor %d\n",
+				  client->monitor);
 			barVisible = 0;
 			showHideBars(0);
 			updateClientPositionsForBar();
 		}
+	} else if (adopting) {
+		LOG_DEBUG("Adopting existing window, focusing after the "
+			  "scan\n");
 	} else if (wa.map_state == IsViewable) {
-		fprintf(stderr, "Window is viewable, focusing now\n");
+		LOG_DEBUG("Window is viewable, focusing now\n");
 		focusClient(client);
 	} else {
-		fprintf(stderr,
-			"Window not yet viewable (state: %d), deferring "
-			"focus\n",
-			wa.map_state);
+		LOG_DEBUG("Window not yet viewable (state: %d), deferring "
+			  "focus\n",
+			  wa.map_state);
 	}
 
-	arrangeClients(monitor);
-
-	if (!client->isFloating && !client->isFullscreen) {
-		XLowerWindow(display, client->window);
+	/* scanExistingWindows arranges and publishes once for all of them */
+	if (!adopting) {
+		arrangeClients(monitor);
 	}
 
-	restackFloatingWindows();
+	if (!adopting) {
+		restackClients();
 
-	updateBars();
+		updateBars();
 
-	updateClientList();
-	updateClientListStacking();
-	updateClientDesktop(client);
-	updateClientAllowedActions(client);
+		updateClientDesktop(client);
+		updateClientAllowedActions(client);
+	}
+
+	ipcEmitEvent(IPC_EVENT_MANAGE, client->window, client->monitor,
+		     client->workspace, 0);
 
 	if (client->pid > 0) {
 		trySwallowClient(client);
@@ -1903,20 +2442,37 @@ void unmanageClient(Window window)
 	if (lastFocused == client) {
 		lastFocused = NULL;
 	}
+	if (dragHeld == client) {
+		dragHeld = NULL;
+		hideOutline();
+	}
+	if (deferredFocus == client) {
+		deferredFocus = NULL;
+	}
+	endSyncRequest(client);
+	unlinkFocusHistory(client);
+
+	ipcEmitEvent(IPC_EVENT_UNMANAGE, client->window, client->monitor,
+		     client->workspace, 0);
+
+	if (client->isSwallowing) {
+		untrackProcess(client->pid);
+	}
 
 	int wasClientDock = client->isDock;
 
 	if (!client->isFloating && !client->isFullscreen) {
 		SMonitor *mon = &monitors[client->monitor];
 		if (mon->lastTiledClient[client->workspace] == client->window) {
-			fprintf(stderr,
-				"Last tiled client for workspace %d is being "
-				"removed\n",
-				client->workspace);
+			LOG_DEBUG("Last tiled client for workspace %d is being "
+				  "removed\n",
+				  client->workspace);
 
-			Window newLastTiled = None;
+			SClient *recent =
+			    recentClient(client->monitor, client->workspace, 1);
+			Window newLastTiled = recent ? recent->window : None;
 
-			for (SClient *c = clients; c; c = c->next) {
+			for (SClient *c = clients; !recent && c; c = c->next) {
 				if (c != client && !c->isFloating &&
 				    !c->isFullscreen &&
 				    c->monitor == client->monitor &&
@@ -1927,10 +2483,9 @@ void unmanageClient(Window window)
 			}
 
 			mon->lastTiledClient[client->workspace] = newLastTiled;
-			fprintf(stderr,
-				"New last tiled client for workspace %d: "
-				"0x%lx\n",
-				client->workspace, newLastTiled);
+			LOG_DEBUG("New last tiled client for workspace %d: "
+				  "0x%lx\n",
+				  client->workspace, newLastTiled);
 		}
 	}
 
@@ -1938,11 +2493,12 @@ void unmanageClient(Window window)
 		SMonitor *currentMonitor   = &monitors[client->monitor];
 		int	  currentWorkspace = client->workspace;
 
-		SClient	 *clientToFocus	 = NULL;
-		SClient	 *tiledClient	 = NULL;
-		SClient	 *floatingClient = NULL;
+		SClient	 *clientToFocus =
+		    recentClient(client->monitor, currentWorkspace, 0);
+		SClient *tiledClient	= NULL;
+		SClient *floatingClient = NULL;
 
-		for (SClient *c = clients; c; c = c->next) {
+		for (SClient *c = clients; !clientToFocus && c; c = c->next) {
 			if (c != client && c->monitor == client->monitor &&
 			    c->workspace == currentWorkspace) {
 				if (!c->isFloating && !c->isFullscreen) {
@@ -1964,14 +2520,16 @@ void unmanageClient(Window window)
 			}
 		}
 
-		clientToFocus = tiledClient ? tiledClient : floatingClient;
+		if (!clientToFocus) {
+			clientToFocus = tiledClient ? tiledClient
+						    : floatingClient;
+		}
 
 		if (clientToFocus) {
-			fprintf(stderr,
-				"Window closed, focusing %s client "
-				"in workspace (tiled: %d)\n",
-				newAsMaster ? "master" : "last",
-				clientToFocus && !clientToFocus->isFloating);
+			LOG_DEBUG("Window closed, focusing %s client "
+				  "in workspace (tiled: %d)\n",
+				  newAsMaster ? "master" : "last",
+				  clientToFocus && !clientToFocus->isFloating);
 			focused = clientToFocus;
 
 			if (no_warps) {
@@ -1988,26 +2546,28 @@ void unmanageClient(Window window)
 					currentMonitor
 					    ->lastTiledClient[currentWorkspace] =
 					    clientToFocus->window;
-					fprintf(stderr,
-						"Setting new last tiled client "
-						"for "
-						"monocle: 0x%lx\n",
-						clientToFocus->window);
+					LOG_DEBUG("Setting new last tiled "
+						  "client "
+						  "for "
+						  "monocle: 0x%lx\n",
+						  clientToFocus->window);
 				}
 
 				focusClient(clientToFocus);
-				XMapWindow(display, clientToFocus->window);
-				XRaiseWindow(display, clientToFocus->window);
+				backend->mapWindow(display,
+						   clientToFocus->window);
+				raiseClient(clientToFocus);
 			} else {
 				focusClient(clientToFocus);
 			}
 		} else {
-			fprintf(stderr,
-				"Window closed, no other windows in workspace, "
-				"focusing monitor %d\n",
-				currentMonitor->num);
+			LOG_DEBUG("Window closed, no other windows in "
+				  "workspace, "
+				  "focusing monitor %d\n",
+				  currentMonitor->num);
 			focused = NULL;
-			XDeleteProperty(display, root, NET_ACTIVE_WINDOW);
+			backend->deleteProperty(display, root,
+						NET_ACTIVE_WINDOW);
 		}
 
 		updateFocus();
@@ -2023,30 +2583,32 @@ void unmanageClient(Window window)
 	} else {
 		clients = client->next;
 	}
+	detachStack(client);
+	clientListRemove(window);
 
 	if (swallowedBy) {
-		fprintf(stderr, "Cleaning up swallow relationship - child "
-				"window closed\n");
+		LOG_DEBUG("Cleaning up swallow relationship - child "
+			  "window closed\n");
 		swallowedBy->swallowed = swallowed;
 
 		if (swallowed) {
-			fprintf(stderr, "Transferring nested swallow "
-					"relationship to parent\n");
+			LOG_DEBUG("Transferring nested swallow "
+				  "relationship to parent\n");
 			swallowed->swallowedBy = swallowedBy;
 		} else {
 			remapSwallowedClient(client);
 		}
 	} else if (swallowed) {
-		fprintf(stderr, "Cleaning up swallow relationship - parent "
-				"window closed\n");
+		LOG_DEBUG("Cleaning up swallow relationship - parent "
+			  "window closed\n");
 		swallowed->swallowedBy = NULL;
 
 		swallowed->workspace = swallowed->oldWorkspace;
 
 		if (client->workspace ==
 		    monitors[client->monitor].currentWorkspace) {
-			fprintf(stderr, "Focusing previously swallowed "
-					"window\n");
+			LOG_DEBUG("Focusing previously swallowed "
+				  "window\n");
 			focusClient(swallowed);
 		}
 	}
@@ -2063,7 +2625,7 @@ void unmanageClient(Window window)
 	if (wasClientDock) {
 		if (!hasDocksOnMonitor(monitor->num) && !barVisible &&
 		    showBar) {
-			fprintf(stderr, "Last dock closed, showing bar\n");
+			LOG_DEBUG("Last dock closed, showing bar\n");
 			barVisible = 1;
 			showHideBars(1);
 			updateClientPositionsForBar();
@@ -2074,20 +2636,17 @@ void unmanageClient(Window window)
 			if (i != monitor->num && x < m->x + m->width &&
 			    x + width > m->x && y < m->y + m->height &&
 			    y + height > m->y) {
-				fprintf(stderr,
-					"Arranging monitor %d after dock "
-					"removal\n",
-					i);
+				LOG_DEBUG("Arranging monitor %d after dock "
+					  "removal\n",
+					  i);
 				arrangeClients(&monitors[i]);
 			}
 		}
 	}
 
 	updateClientVisibility();
+	restackClients();
 	updateBars();
-
-	updateClientList();
-	updateClientListStacking();
 }
 
 void configureClient(SClient *client)
@@ -2102,7 +2661,7 @@ void configureClient(SClient *client)
 	    (monitor->currentLayout == LAYOUT_MONOCLE && !client->isFloating);
 
 	XWindowChanges wc;
-	wc.x		= client->x;
+	wc.x		= client->isHidden ? hiddenX(client) : client->x;
 	wc.y		= client->y;
 	wc.width	= client->width;
 	wc.height	= client->height;
@@ -2110,107 +2669,72 @@ void configureClient(SClient *client)
 	wc.sibling	= None;
 	wc.stack_mode	= Above;
 
-	XConfigureWindow(display, client->window,
-			 CWX | CWY | CWWidth | CWHeight | CWBorderWidth, &wc);
+	backend->configureWindow(display, client->window,
+				 CWX | CWY | CWWidth | CWHeight | CWBorderWidth,
+				 &wc);
 
 	XEvent event;
 	event.type			   = ConfigureNotify;
 	event.xconfigure.display	   = display;
 	event.xconfigure.event		   = client->window;
 	event.xconfigure.window		   = client->window;
-	event.xconfigure.x		   = client->x;
+	event.xconfigure.x		   = wc.x;
 	event.xconfigure.y		   = client->y;
 	event.xconfigure.width		   = client->width;
 	event.xconfigure.height		   = client->height;
 	event.xconfigure.border_width	   = noBorder ? 0 : borderWidth;
 	event.xconfigure.above		   = None;
 	event.xconfigure.override_redirect = False;
-	XSendEvent(display, client->window, False, StructureNotifyMask, &event);
+	backend->sendEvent(display, client->window, False, StructureNotifyMask,
+			   &event);
 
-	XSetWindowBorderWidth(display, client->window,
-			      noBorder ? 0 : borderWidth);
+	backend->setWindowBorderWidth(display, client->window,
+				      noBorder ? 0 : borderWidth);
 
 	updateFrameExtents(client);
 
 	updateBorders();
-	XSync(display, False);
+	backend->sync(display, False);
 }
 
-void updateBorders()
+/* border colors are allocated once per config load */
+void allocBorderColors(void)
 {
-	static unsigned long activeBorder	     = 0;
-	static unsigned long inactiveBorder	     = 0;
-	static char	    *lastActiveBorderColor   = NULL;
-	static char	    *lastInactiveBorderColor = NULL;
-
-	if ((lastActiveBorderColor == NULL && activeBorderColor != NULL) ||
-	    (lastActiveBorderColor != NULL && activeBorderColor != NULL &&
-	     strcmp(lastActiveBorderColor, activeBorderColor) != 0) ||
-	    (lastInactiveBorderColor == NULL && inactiveBorderColor != NULL) ||
-	    (lastInactiveBorderColor != NULL && inactiveBorderColor != NULL &&
-	     strcmp(lastInactiveBorderColor, inactiveBorderColor) != 0)) {
-		if (lastActiveBorderColor) {
-			free(lastActiveBorderColor);
-			lastActiveBorderColor = NULL;
-		}
-
-		if (lastInactiveBorderColor) {
-			free(lastInactiveBorderColor);
-			lastInactiveBorderColor = NULL;
-		}
-
-		activeBorder   = 0;
-		inactiveBorder = 0;
-	}
-
-	if (activeBorder == 0 || inactiveBorder == 0) {
-		XColor	 color;
-		Colormap cmap =
-		    DefaultColormap(display, DefaultScreen(display));
-
-		if (XAllocNamedColor(display, cmap, activeBorderColor, &color,
-				     &color)) {
-			activeBorder = color.pixel | 0xFF000000;
-		} else {
-			activeBorder =
-			    BlackPixel(display, DefaultScreen(display)) |
+	activeBorderPixel = backend->allocColor(display, activeBorderColor) |
 			    0xFF000000;
-		}
+	inactiveBorderPixel =
+	    backend->allocColor(display, inactiveBorderColor) | 0xFF000000;
 
-		if (XAllocNamedColor(display, cmap, inactiveBorderColor, &color,
-				     &color)) {
-			inactiveBorder = color.pixel | 0xFF000000;
-		} else {
-			inactiveBorder =
-			    BlackPixel(display, DefaultScreen(display)) |
-			    0xFF000000;
-		}
+	LOG_DEBUG("Border colors initialized\n");
+}
 
-		lastActiveBorderColor	= safeStrdup(activeBorderColor);
-		lastInactiveBorderColor = safeStrdup(inactiveBorderColor);
+unsigned long getActiveBorderPixel(void)
+{
+	return activeBorderPixel;
+}
 
-		fprintf(stderr, "Border colors initialized\n");
+static void setClientBorder(SClient *client, unsigned long pixel)
+{
+	if (client->borderPixel != pixel) {
+		backend->setWindowBorder(display, client->window, pixel);
+		client->borderPixel = pixel;
 	}
+}
 
-	SClient *client = clients;
-	while (client) {
+/*
+ * every client remembers the border color it was last given, so a focus
+ * change only sends the borders of the old and the new focused window
+ */
+void updateBorders()
+{
+	for (SClient *client = clients; client; client = client->next) {
 		SMonitor *monitor = &monitors[client->monitor];
 		if (!client->isFullscreen && !client->isDock &&
 		    !(monitor->currentLayout == LAYOUT_MONOCLE &&
 		      !client->isFloating)) {
-			XSetWindowBorder(display, client->window,
-					 inactiveBorder);
-		}
-		client = client->next;
-	}
-
-	if (focused) {
-		SMonitor *monitor = &monitors[focused->monitor];
-		if (!focused->isFullscreen && !focused->isDock &&
-		    !(monitor->currentLayout == LAYOUT_MONOCLE &&
-		      !focused->isFloating)) {
-			XSetWindowBorder(display, focused->window,
-					 activeBorder);
+			setClientBorder(client, client == focused
+						    ? activeBorderPixel
+						    : inactiveBorderPixel);
 		}
 	}
 
@@ -2247,236 +2771,231 @@ SMonitor *monitorAtPoint(int x, int y)
 	return &monitors[0];
 }
 
-void updateMonitors()
+typedef struct {
+	XID id;
+	int x, y;
+	int width, height;
+} SMonitorGeometry;
+
+static int monitorPrevious[MAX_MONITORS];
+static int monitorChanged[MAX_MONITORS];
+static int monitorsChanged = 0;
+
+static void initMonitor(SMonitor *monitor, const SMonitorGeometry *geometry)
 {
-	if (monitors) {
-		for (int i = 0; i < numMonitors; i++) {
-			free(monitors[i].masterFactors);
-			free(monitors[i].workspaceLayouts);
-			free(monitors[i].lastTiledClient);
+	monitor->id		  = geometry->id;
+	monitor->x		  = geometry->x;
+	monitor->y		  = geometry->y;
+	monitor->width		  = geometry->width;
+	monitor->height		  = geometry->height;
+	monitor->currentWorkspace = 0;
+	monitor->currentLayout	  = LAYOUT_TILED;
+	monitor->masterCount	  = 1;
+	monitor->masterFactors	  = malloc(workspaceCount * sizeof(float));
+	monitor->workspaceLayouts = malloc(workspaceCount * sizeof(ELayout));
+	monitor->lastTiledClient  = malloc(workspaceCount * sizeof(Window));
+	for (int ws = 0; ws < workspaceCount; ws++) {
+		monitor->masterFactors[ws] = defaultMasterFactor;
+		monitor->workspaceLayouts[ws] =
+		    strcasecmp(defaultLayout, "monocle") == 0 ? LAYOUT_MONOCLE
+							      : LAYOUT_TILED;
+		monitor->lastTiledClient[ws] = None;
+	}
+}
+
+/*
+ * asks the server for the active monitors without making it reprobe the
+ * outputs, a monitor is identified by its randr name, or by its output on
+ * servers older than randr 1.5
+ */
+static int probeMonitors(SMonitorGeometry *found)
+{
+	static int	haveMonitors = -1;
+	int		count	     = 0;
+	int		n	     = 0;
+	XRRMonitorInfo *info	     = NULL;
+
+	if (haveMonitors < 0) {
+		int major = 0, minor = 0;
+		haveMonitors = XRRQueryVersion(display, &major, &minor) &&
+			       (major > 1 || (major == 1 && minor >= 5));
+	}
+
+	if (haveMonitors) {
+		info = XRRGetMonitors(display, root, True, &n);
+	}
+
+	if (info) {
+		for (int i = 0; i < n && count < MAX_MONITORS; i++) {
+			found[count].id	    = info[i].name;
+			found[count].x	    = info[i].x;
+			found[count].y	    = info[i].y;
+			found[count].width  = info[i].width;
+			found[count].height = info[i].height;
+			count++;
+		}
+		XRRFreeMonitors(info);
+	}
+
+	XRRScreenResources *screenRes =
+	    count ? NULL : XRRGetScreenResourcesCurrent(display, root);
+	for (int i = 0;
+	     screenRes && i < screenRes->noutput && count < MAX_MONITORS; i++) {
+		XRROutputInfo *outputInfo =
+		    XRRGetOutputInfo(display, screenRes, screenRes->outputs[i]);
+		if (outputInfo && outputInfo->connection == RR_Connected &&
+		    outputInfo->crtc) {
+			XRRCrtcInfo *crtcInfo = XRRGetCrtcInfo(
+			    display, screenRes, outputInfo->crtc);
+			if (crtcInfo) {
+				found[count].id	    = screenRes->outputs[i];
+				found[count].x	    = crtcInfo->x;
+				found[count].y	    = crtcInfo->y;
+				found[count].width  = crtcInfo->width;
+				found[count].height = crtcInfo->height;
+				count++;
+				XRRFreeCrtcInfo(crtcInfo);
+			}
+		}
+		if (outputInfo) {
+			XRRFreeOutputInfo(outputInfo);
 		}
-		free(monitors);
+	}
+	if (screenRes) {
+		XRRFreeScreenResources(screenRes);
 	}
 
-	XRRScreenResources *screenRes = NULL;
-	monitors		      = NULL;
-	int oldNumMonitors	      = numMonitors;
-	numMonitors		      = 0;
+	if (count == 0) {
+		found[0].id    = None;
+		found[0].x     = 0;
+		found[0].y     = 0;
+		found[0].width = DisplayWidth(display, DefaultScreen(display));
+		found[0].height =
+		    DisplayHeight(display, DefaultScreen(display));
+		count = 1;
+	}
 
-	screenRes = XRRGetScreenResources(display, root);
+	return count;
+}
 
-	if (!screenRes || screenRes->noutput == 0) {
-		numMonitors   = 1;
-		monitors      = malloc(sizeof(SMonitor));
-		monitors[0].x = 0;
-		monitors[0].y = 0;
-		monitors[0].width =
-		    DisplayWidth(display, DefaultScreen(display));
-		monitors[0].height =
-		    DisplayHeight(display, DefaultScreen(display));
-		monitors[0].num		     = 0;
-		monitors[0].currentWorkspace = 0;
-		monitors[0].currentLayout    = LAYOUT_TILED;
-		monitors[0].masterCount	     = 1;
-		monitors[0].masterFactors =
-		    malloc(workspaceCount * sizeof(float));
-		monitors[0].workspaceLayouts =
-		    malloc(workspaceCount * sizeof(ELayout));
-		monitors[0].lastTiledClient =
-		    malloc(workspaceCount * sizeof(Window));
-		for (int ws = 0; ws < workspaceCount; ws++) {
-			monitors[0].masterFactors[ws] = defaultMasterFactor;
-			monitors[0].workspaceLayouts[ws] =
-			    strcasecmp(defaultLayout, "monocle") == 0
-				? LAYOUT_MONOCLE
-				: LAYOUT_TILED;
-			monitors[0].lastTiledClient[ws] = None;
-		}
+/*
+ * matches the probed monitors against the current ones so a monitor that is
+ * still there keeps its workspace, layouts and master factors, clients on a
+ * monitor that went away move to the one under their center
+ */
+void updateMonitors()
+{
+	SMonitorGeometry found[MAX_MONITORS];
+	int		 count = probeMonitors(found);
 
-		if (screenRes) {
-			XRRFreeScreenResources(screenRes);
-		}
-	} else {
-		for (int i = 0; i < screenRes->noutput; i++) {
-			XRROutputInfo *outputInfo = XRRGetOutputInfo(
-			    display, screenRes, screenRes->outputs[i]);
-			if (outputInfo &&
-			    outputInfo->connection == RR_Connected &&
-			    outputInfo->crtc) {
-				numMonitors++;
-			}
-			if (outputInfo) {
-				XRRFreeOutputInfo(outputInfo);
+	SMonitor	*next = calloc(count, sizeof(SMonitor));
+	if (!next) {
+		LOG_ERROR("Failed to allocate memory for monitors\n");
+		return;
+	}
+
+	int claimed[MAX_MONITORS] = {0};
+	int remap[MAX_MONITORS];
+	monitorsChanged = count != numMonitors;
+
+	for (int j = 0; j < numMonitors; j++) {
+		remap[j] = -1;
+	}
+
+	for (int i = 0; i < count; i++) {
+		int previous = -1;
+		for (int j = 0; j < numMonitors; j++) {
+			if (!claimed[j] && monitors[j].id == found[i].id) {
+				previous = j;
+				break;
 			}
 		}
 
-		if (numMonitors == 0) {
-			numMonitors   = 1;
-			monitors      = malloc(sizeof(SMonitor));
-			monitors[0].x = 0;
-			monitors[0].y = 0;
-			monitors[0].width =
-			    DisplayWidth(display, DefaultScreen(display));
-			monitors[0].height =
-			    DisplayHeight(display, DefaultScreen(display));
-			monitors[0].num		     = 0;
-			monitors[0].currentWorkspace = 0;
-			monitors[0].currentLayout    = LAYOUT_TILED;
-			monitors[0].masterCount	     = 1;
-			monitors[0].masterFactors =
-			    malloc(workspaceCount * sizeof(float));
-			monitors[0].workspaceLayouts =
-			    malloc(workspaceCount * sizeof(ELayout));
-			monitors[0].lastTiledClient =
-			    malloc(workspaceCount * sizeof(Window));
-			for (int ws = 0; ws < workspaceCount; ws++) {
-				monitors[0].masterFactors[ws] =
-				    defaultMasterFactor;
-				monitors[0].workspaceLayouts[ws] =
-				    strcasecmp(defaultLayout, "monocle") == 0
-					? LAYOUT_MONOCLE
-					: LAYOUT_TILED;
-				monitors[0].lastTiledClient[ws] = None;
-			}
+		monitorPrevious[i] = previous;
+		if (previous < 0) {
+			initMonitor(&next[i], &found[i]);
+			monitorChanged[i] = 1;
 		} else {
-			monitors = malloc(numMonitors * sizeof(SMonitor));
-			int monitorIndex = 0;
-
-			for (int i = 0; i < screenRes->noutput &&
-					monitorIndex < numMonitors;
-			     i++) {
-				XRROutputInfo *outputInfo = XRRGetOutputInfo(
-				    display, screenRes, screenRes->outputs[i]);
-
-				if (outputInfo &&
-				    outputInfo->connection == RR_Connected &&
-				    outputInfo->crtc) {
-					XRRCrtcInfo *crtcInfo =
-					    XRRGetCrtcInfo(display, screenRes,
-							   outputInfo->crtc);
-
-					if (crtcInfo) {
-						monitors[monitorIndex].x =
-						    crtcInfo->x;
-						monitors[monitorIndex].y =
-						    crtcInfo->y;
-						monitors[monitorIndex].width =
-						    crtcInfo->width;
-						monitors[monitorIndex].height =
-						    crtcInfo->height;
-						monitors[monitorIndex].num =
-						    monitorIndex;
-						monitors[monitorIndex]
-						    .currentWorkspace = 0;
-						monitors[monitorIndex]
-						    .currentLayout =
-						    LAYOUT_TILED;
-						monitors[monitorIndex]
-						    .masterCount = 1;
-						monitors[monitorIndex]
-						    .masterFactors =
-						    malloc(workspaceCount *
-							   sizeof(float));
-						monitors[monitorIndex]
-						    .workspaceLayouts =
-						    malloc(workspaceCount *
-							   sizeof(ELayout));
-						monitors[monitorIndex]
-						    .lastTiledClient =
-						    malloc(workspaceCount *
-							   sizeof(Window));
-
-						for (int ws = 0;
-						     ws < workspaceCount;
-						     ws++) {
-							monitors[monitorIndex]
-							    .masterFactors[ws] =
-							    defaultMasterFactor;
-							monitors[monitorIndex]
-							    .workspaceLayouts[ws] =
-							    strcasecmp(
-								defaultLayout,
-								"monocle") == 0
-								? LAYOUT_MONOCLE
-								: LAYOUT_TILED;
-							monitors[monitorIndex]
-							    .lastTiledClient[ws] =
-							    None;
-						}
-
-						monitorIndex++;
-						XRRFreeCrtcInfo(crtcInfo);
-					}
-				}
+			claimed[previous] = 1;
+			remap[previous]	  = i;
+			next[i]		  = monitors[previous];
+			monitorChanged[i] = next[i].x != found[i].x ||
+					    next[i].y != found[i].y ||
+					    next[i].width != found[i].width ||
+					    next[i].height != found[i].height;
+			next[i].x      = found[i].x;
+			next[i].y      = found[i].y;
+			next[i].width  = found[i].width;
+			next[i].height = found[i].height;
+		}
 
-				if (outputInfo) {
-					XRRFreeOutputInfo(outputInfo);
-				}
-			}
+		next[i].num = i;
+		if (monitorChanged[i] || previous != i) {
+			monitorsChanged = 1;
+		}
+	}
 
-			if (monitorIndex < numMonitors) {
-				numMonitors = monitorIndex > 0 ? monitorIndex
-							       : 1;
-				if (monitorIndex == 0) {
-					monitors[0].x	  = 0;
-					monitors[0].y	  = 0;
-					monitors[0].width = DisplayWidth(
-					    display, DefaultScreen(display));
-					monitors[0].height = DisplayHeight(
-					    display, DefaultScreen(display));
-					monitors[0].num		     = 0;
-					monitors[0].currentWorkspace = 0;
-					monitors[0].currentLayout =
-					    LAYOUT_TILED;
-					monitors[0].masterCount	  = 1;
-					monitors[0].masterFactors = malloc(
-					    workspaceCount * sizeof(float));
-					monitors[0].workspaceLayouts = malloc(
-					    workspaceCount * sizeof(ELayout));
-					monitors[0].lastTiledClient = malloc(
-					    workspaceCount * sizeof(Window));
-					for (int ws = 0; ws < workspaceCount;
-					     ws++) {
-						monitors[0].masterFactors[ws] =
-						    defaultMasterFactor;
-						monitors[0]
-						    .workspaceLayouts[ws] =
-						    strcasecmp(defaultLayout,
-							       "monocle") == 0
-							? LAYOUT_MONOCLE
-							: LAYOUT_TILED;
-						monitors[0].lastTiledClient[ws] =
-						    None;
-					}
-				}
-			}
+	for (int j = 0; j < numMonitors; j++) {
+		if (!claimed[j]) {
+			LOG_INFO("Monitor %d was removed\n", j);
+			free(monitors[j].masterFactors);
+			free(monitors[j].workspaceLayouts);
+			free(monitors[j].lastTiledClient);
 		}
+	}
 
-		XRRFreeScreenResources(screenRes);
+	int previousCount = numMonitors;
+	free(monitors);
+	monitors    = next;
+	numMonitors = count;
+
+	if (!monitorsChanged) {
+		return;
 	}
 
-	if (numMonitors != oldNumMonitors) {
-		SClient *client = clients;
-		while (client) {
-			SMonitor *mon = getCurrentMonitor();
-			int	  x   = client->x;
-			int	  y   = client->y;
-			if (x < mon->x || x >= mon->x + mon->width ||
-			    y < mon->y || y >= mon->y + mon->height) {
-				client->monitor = mon->num;
-				client->x =
-				    mon->x + (mon->width - client->width) / 2;
-				client->y =
-				    mon->y + (mon->height - client->height) / 2;
-				if (client->y < mon->y + barHeight) {
-					client->y = mon->y + barHeight;
-				}
+	for (SClient *client = clients; client; client = client->next) {
+		/* the history of a removed monitor went away with it */
+		if (client->focusMonitor >= 0 &&
+		    client->focusMonitor < previousCount &&
+		    remap[client->focusMonitor] >= 0) {
+			client->focusMonitor = remap[client->focusMonitor];
+		} else {
+			client->focusPrev    = NULL;
+			client->focusNext    = NULL;
+			client->focusMonitor = 0;
+		}
+
+		if (client->monitor >= 0 && client->monitor < previousCount &&
+		    remap[client->monitor] >= 0) {
+			client->monitor = remap[client->monitor];
+			continue;
+		}
+
+		SMonitor *mon	= monitorAtPoint(client->x + client->width / 2,
+						 client->y + client->height / 2);
+		client->monitor = mon->num;
+		monitorChanged[mon->num] = 1;
+
+		int x = client->x;
+		int y = client->y;
+		if (x < mon->x || x >= mon->x + mon->width || y < mon->y ||
+		    y >= mon->y + mon->height) {
+			client->x = mon->x + (mon->width - client->width) / 2;
+			client->y = mon->y + (mon->height - client->height) / 2;
+			if (client->y < mon->y + barHeight) {
+				client->y = mon->y + barHeight;
 			}
-			client = client->next;
+			backend->moveWindow(display, client->window, client->x,
+					    client->y);
 		}
+	}
 
-		updateDesktopViewport();
+	if (forcedMonitor >= 0) {
+		forcedMonitor =
+		    forcedMonitor < previousCount ? remap[forcedMonitor] : -1;
 	}
+
+	invalidateRootProperties(ROOT_DESKTOP_VIEWPORT);
 }
 
 void handlePropertyNotify(XEvent *event)
@@ -2485,10 +3004,10 @@ void handlePropertyNotify(XEvent *event)
 
 	if (ev->window == root && ev->atom == XA_WM_NAME) {
 		updateStatus();
-	} else if (ev->atom == XInternAtom(display, "_NET_WM_NAME", False) ||
-		   ev->atom == XA_WM_NAME) {
+	} else if (ev->atom == NET_WM_NAME || ev->atom == XA_WM_NAME) {
 		SClient *client = findClient(ev->window);
 		if (client) {
+			updateClientTitle(client);
 			updateBars();
 		}
 	}
@@ -2508,7 +3027,7 @@ void handlePropertyNotify(XEvent *event)
 			}
 		}
 
-		restackFloatingWindows();
+		restackClients();
 	}
 }
 
@@ -2533,7 +3052,8 @@ SClient *focusWindowUnderCursor(SMonitor *monitor)
 	if (focused && (focused->monitor != monitor->num ||
 			focused->workspace != monitor->currentWorkspace)) {
 		focused = NULL;
-		XSetInputFocus(display, root, RevertToPointerRoot, CurrentTime);
+		backend->setInputFocus(display, root, RevertToPointerRoot,
+				       CurrentTime);
 		updateBorders();
 	}
 
@@ -2541,8 +3061,8 @@ SClient *focusWindowUnderCursor(SMonitor *monitor)
 		return NULL;
 	}
 
-	if (XQueryPointer(display, root, &root_return, &child_return, &x, &y,
-			  &x, &y, &mask)) {
+	if (backend->queryPointer(display, root, &root_return, &child_return,
+				  &x, &y, &x, &y, &mask)) {
 		if (x >= monitor->x && x < monitor->x + monitor->width &&
 		    y >= monitor->y && y < monitor->y + monitor->height) {
 			SClient *windowUnderCursor = clientAtPoint(x, y);
@@ -2567,7 +3087,8 @@ SClient *focusWindowUnderCursor(SMonitor *monitor)
 
 	if (activeMonitor != monitor->num || !clientInWorkspace) {
 		focused = NULL;
-		XSetInputFocus(display, root, RevertToPointerRoot, CurrentTime);
+		backend->setInputFocus(display, root, RevertToPointerRoot,
+				       CurrentTime);
 		updateBorders();
 		updateBars();
 	}
@@ -2590,27 +3111,31 @@ void switchToWorkspace(const char *arg)
 		return;
 	}
 
-	fprintf(stderr, "Switching from workspace %d to %d on monitor %d\n",
-		monitor->currentWorkspace, workspace, monitor->num);
+	LOG_DEBUG("Switching from workspace %d to %d on monitor %d\n",
+		  monitor->currentWorkspace, workspace, monitor->num);
 
 	gettimeofday(&lastWindowOperation, NULL);
 
+	/* nothing else draws until every window is in its final place */
+	int grab = workspaceSwitch == WORKSPACE_SWITCH_GRAB;
+	if (grab) {
+		backend->grabServer(display);
+	}
+
 	focused = NULL;
-	XSetInputFocus(display, root, RevertToPointerRoot, CurrentTime);
 
 	monitor->currentWorkspace = workspace;
+	ipcEmitEvent(IPC_EVENT_WORKSPACE, 0, monitor->num, workspace, 0);
 
 	if (no_warps) {
 		forcedMonitor = monitor->num;
 	}
 
-	long currentDesktop = workspace;
-	XChangeProperty(display, root, NET_CURRENT_DESKTOP, XA_CARDINAL, 32,
-			PropModeReplace, (unsigned char *)&currentDesktop, 1);
+	invalidateCurrentDesktop(workspace);
 
-	XDeleteProperty(display, root, NET_ACTIVE_WINDOW);
+	backend->deleteProperty(display, root, NET_ACTIVE_WINDOW);
 
-	updateDesktopViewport();
+	invalidateRootProperties(ROOT_DESKTOP_VIEWPORT);
 
 	if (monitor->currentLayout == LAYOUT_MONOCLE &&
 	    monitor->lastTiledClient[workspace] == None) {
@@ -2627,19 +3152,21 @@ void switchToWorkspace(const char *arg)
 		if (firstTiled) {
 			monitor->lastTiledClient[workspace] =
 			    firstTiled->window;
-			fprintf(stderr,
-				"Setting lastTiledClient for workspace %d to "
-				"0x%lx\n",
-				workspace, firstTiled->window);
+			LOG_DEBUG("Setting lastTiledClient for workspace %d to "
+				  "0x%lx\n",
+				  workspace, firstTiled->window);
 		}
 	}
 
-	updateClientVisibility();
-	updateBars();
-
+	/* windows are placed before they are shown, not shown then moved */
 	arrangeClients(monitor);
+	updateBars();
 
-	SClient *focusedClient = focusWindowUnderCursor(monitor);
+	SClient *focusedClient = recentClient(monitor->num, workspace, 0);
+	focusClient(focusedClient);
+	if (!focusedClient || focused != focusedClient) {
+		focusedClient = focusWindowUnderCursor(monitor);
+	}
 
 	if (!focusedClient) {
 		SClient *windowToFocus = NULL;
@@ -2653,10 +3180,9 @@ void switchToWorkspace(const char *arg)
 			    lastTiled->workspace == workspace &&
 			    !lastTiled->isFloating) {
 				windowToFocus = lastTiled;
-				fprintf(stderr,
-					"Using last tiled client 0x%lx for "
-					"workspace %d\n",
-					lastTiled->window, workspace);
+				LOG_DEBUG("Using last tiled client 0x%lx for "
+					  "workspace %d\n",
+					  lastTiled->window, workspace);
 			}
 		}
 
@@ -2666,27 +3192,29 @@ void switchToWorkspace(const char *arg)
 		}
 
 		if (windowToFocus) {
-			fprintf(stderr,
-				"Focusing window 0x%lx in workspace %d\n",
-				windowToFocus->window, workspace);
+			LOG_DEBUG("Focusing window 0x%lx in workspace %d\n",
+				  windowToFocus->window, workspace);
 			focusClient(windowToFocus);
 		} else {
 			currentWorkspace = workspace;
+			backend->setInputFocus(
+			    display, root, RevertToPointerRoot, CurrentTime);
 			if (focused && focused->monitor != monitor->num) {
-				XSetInputFocus(display, root,
-					       RevertToPointerRoot,
-					       CurrentTime);
 				focused = NULL;
 				updateBorders();
 			}
 
-			XDeleteProperty(display, root, NET_ACTIVE_WINDOW);
-			fprintf(stderr,
-				"No windows in workspace %d, clearing "
-				"NET_ACTIVE_WINDOW\n",
-				workspace);
+			backend->deleteProperty(display, root,
+						NET_ACTIVE_WINDOW);
+			LOG_DEBUG("No windows in workspace %d, clearing "
+				  "NET_ACTIVE_WINDOW\n",
+				  workspace);
 		}
 	}
+
+	if (grab) {
+		backend->ungrabServer(display);
+	}
 }
 
 void moveClientToWorkspace(const char *arg)
@@ -2710,18 +3238,22 @@ void moveClientToWorkspace(const char *arg)
 	updateClientDesktop(movedClient);
 
 	if (workspace != currentMon->currentWorkspace) {
-		XUnmapWindow(display, movedClient->window);
+		backend->unmapWindow(display, movedClient->window);
 
-		SClient *focusedClient = focusWindowUnderCursor(currentMon);
+		SClient *focusedClient = recentClient(
+		    currentMon->num, currentMon->currentWorkspace, 0);
+		focusClient(focusedClient);
+		if (!focusedClient || focused != focusedClient) {
+			focusedClient = focusWindowUnderCursor(currentMon);
+		}
 
 		if (!focusedClient) {
 			SClient *remainingWindow = findVisibleClientInWorkspace(
 			    currentMon->num, currentMon->currentWorkspace);
 			if (remainingWindow) {
-				fprintf(stderr,
-					"No window under cursor, focusing "
-					"remaining window in workspace %d\n",
-					currentMon->currentWorkspace);
+				LOG_DEBUG("No window under cursor, focusing "
+					  "remaining window in workspace %d\n",
+					  currentMon->currentWorkspace);
 				focusClient(remainingWindow);
 			}
 		}
@@ -2759,18 +3291,62 @@ int hasDocksOnMonitor(int monitorNum)
 			if (c->x < m->x + m->width && c->x + c->width > m->x &&
 			    c->y < m->y + m->height &&
 			    c->y + c->height > m->y) {
-				fprintf(stderr,
-					"Found dock window 0x%lx overlapping "
-					"monitor %d\n",
-					c->window, monitorNum);
+				LOG_DEBUG("Found dock window 0x%lx overlapping "
+					  "monitor %d\n",
+					  c->window, monitorNum);
 				return 1;
 			}
 		}
 	}
-	fprintf(stderr, "No docks found on monitor %d\n", monitorNum);
+	LOG_DEBUG("No docks found on monitor %d\n", monitorNum);
 	return 0;
 }
 
+/*
+ * offscreen keeps hidden windows mapped and moves them out of sight, so
+ * their contents survive and showing them again needs no repaint
+ */
+static void hideClient(SClient *client)
+{
+	if (workspaceSwitch != WORKSPACE_SWITCH_OFFSCREEN) {
+		backend->unmapWindow(display, client->window);
+		return;
+	}
+
+	if (client->isHidden) {
+		return;
+	}
+
+	backend->moveWindow(display, client->window, hiddenX(client),
+			    client->y);
+	client->isHidden = 1;
+}
+
+static void showClient(SClient *client)
+{
+	if (client->isHidden) {
+		backend->moveWindow(display, client->window, client->x,
+				    client->y);
+		client->isHidden = 0;
+	}
+	backend->mapWindow(display, client->window);
+}
+
+/* puts windows hidden offscreen back before another wm can see them */
+void revealHiddenClients(void)
+{
+	for (SClient *client = clients; client; client = client->next) {
+		if (!client->isHidden) {
+			continue;
+		}
+
+		backend->unmapWindow(display, client->window);
+		backend->moveWindow(display, client->window, client->x,
+				    client->y);
+		client->isHidden = 0;
+	}
+}
+
 void updateClientVisibility()
 {
 	int hasFullscreen[MAX_MONITORS][100] = {0};
@@ -2803,59 +3379,71 @@ void updateClientVisibility()
 				continue;
 			}
 
-			m->lastTiledClient[ws] = None;
+			SClient *recent	       = recentClient(i, ws, 1);
+			m->lastTiledClient[ws] = recent ? recent->window : None;
 
-			for (SClient *c = clients; c; c = c->next) {
+			for (SClient *c = clients; !recent && c; c = c->next) {
 				if (c->monitor != i || c->workspace != ws ||
 				    c->isFloating || c->isFullscreen) {
 					continue;
 				}
 
 				m->lastTiledClient[ws] = c->window;
-				fprintf(stderr,
-					"Resetting lastTiledClient to 0x%lx\n",
-					c->window);
+				LOG_DEBUG("Resetting lastTiledClient to "
+					  "0x%lx\n",
+					  c->window);
 				break;
 			}
 		}
 	}
 
+	int clientCount = 0;
+	for (SClient *c = clients; c; c = c->next) {
+		clientCount++;
+	}
+
+	/* decided for every client first, then sent as one batch */
+	SClient *show[clientCount + 1];
+	SClient *hide[clientCount + 1];
+	SClient *focusTarget = NULL;
+	int	 showCount = 0, hideCount = 0;
+
 	for (SClient *client = clients; client; client = client->next) {
 		if (client->workspace == INT_MAX) {
-			XUnmapWindow(display, client->window);
+			backend->unmapWindow(display, client->window);
 			continue;
 		}
 
 		if (client->isDock || client->workspace == DOCK_WORKSPACE) {
-			XMapWindow(display, client->window);
+			show[showCount++] = client;
 			continue;
 		}
 
 		SMonitor *m = &monitors[client->monitor];
 		if (client->workspace != m->currentWorkspace) {
-			XUnmapWindow(display, client->window);
+			hide[hideCount++] = client;
 			continue;
 		}
 
 		if (windowMovement.active && windowMovement.client == client) {
-			XMapWindow(display, client->window);
-			XRaiseWindow(display, client->window);
+			show[showCount++] = client;
+			raiseClient(client);
 			continue;
 		}
 
 		if (hasFullscreen[client->monitor][client->workspace]) {
 			if (client->isFullscreen) {
-				XMapWindow(display, client->window);
-				XRaiseWindow(display, client->window);
+				show[showCount++] = client;
+				raiseClient(client);
 
 				if (client != focused &&
 				    client->workspace == m->currentWorkspace &&
 				    client->monitor ==
 					getCurrentMonitor()->num) {
-					focusClient(client);
+					focusTarget = client;
 				}
 			} else {
-				XUnmapWindow(display, client->window);
+				hide[hideCount++] = client;
 			}
 			continue;
 		}
@@ -2865,20 +3453,32 @@ void updateClientVisibility()
 			if (client == focused ||
 			    m->lastTiledClient[m->currentWorkspace] ==
 				client->window) {
-				XMapWindow(display, client->window);
+				show[showCount++] = client;
 
 				if (client != focused &&
 				    m->lastTiledClient[m->currentWorkspace] ==
 					client->window) {
-					XRaiseWindow(display, client->window);
+					raiseClient(client);
 				}
 			} else {
-				XUnmapWindow(display, client->window);
+				hide[hideCount++] = client;
 			}
 			continue;
 		}
 
-		XMapWindow(display, client->window);
+		show[showCount++] = client;
+	}
+
+	/* showing first never leaves a frame with both workspaces gone */
+	for (int i = 0; i < showCount; i++) {
+		showClient(show[i]);
+	}
+	for (int i = 0; i < hideCount; i++) {
+		hideClient(hide[i]);
+	}
+
+	if (focusTarget) {
+		focusClient(focusTarget);
 	}
 }
 
@@ -2889,8 +3489,8 @@ SClient *findVisibleClientInWorkspace(int monitor, int workspace)
 	unsigned int mask;
 	Window	     root_return, child_return;
 
-	if (XQueryPointer(display, root, &root_return, &child_return, &x, &y,
-			  &x, &y, &mask)) {
+	if (backend->queryPointer(display, root, &root_return, &child_return,
+				  &x, &y, &x, &y, &mask)) {
 		for (SClient *c = clients; c; c = c->next) {
 			if (c->monitor == monitor &&
 			    c->workspace == workspace && x >= c->x &&
@@ -2922,8 +3522,8 @@ SMonitor *getCurrentMonitor()
 	unsigned int mask;
 	Window	     root_return, child_return;
 
-	if (XQueryPointer(display, root, &root_return, &child_return, &x, &y,
-			  &x, &y, &mask)) {
+	if (backend->queryPointer(display, root, &root_return, &child_return,
+				  &x, &y, &x, &y, &mask)) {
 		return monitorAtPoint(x, y);
 	}
 
@@ -3027,9 +3627,10 @@ void toggleFloating(const char *arg)
 			focused->width	= newWidth;
 			focused->height = newHeight;
 
-			XMoveResizeWindow(display, focused->window, focused->x,
-					  focused->y, focused->width,
-					  focused->height);
+			backend->moveResizeWindow(display, focused->window,
+						  focused->x, focused->y,
+						  focused->width,
+						  focused->height);
 		}
 
 		XGrabButton(display, Button3, modkey, focused->window, False,
@@ -3037,10 +3638,11 @@ void toggleFloating(const char *arg)
 				ButtonMotionMask,
 			    GrabModeAsync, GrabModeAsync, None, resizeSECursor);
 
-		XRaiseWindow(display, focused->window);
+		raiseClient(focused);
 		if (!focused->neverfocus) {
-			XSetInputFocus(display, focused->window,
-				       RevertToPointerRoot, CurrentTime);
+			backend->setInputFocus(display, focused->window,
+					       RevertToPointerRoot,
+					       CurrentTime);
 		}
 
 		configureClient(focused);
@@ -3063,24 +3665,23 @@ void toggleFloating(const char *arg)
 
 		moveClientToEnd(focused);
 
-		XLowerWindow(display, focused->window);
+		lowerClient(focused);
 
 		if (!focused->isFloating && !focused->isFullscreen) {
 			SMonitor *monitor = &monitors[focused->monitor];
 			monitor->lastTiledClient[focused->workspace] =
 			    focused->window;
-			fprintf(stderr,
-				"Updating last tiled client for workspace %d "
-				"to 0x%lx "
-				"(toggle floating)\n",
-				focused->workspace, focused->window);
+			LOG_DEBUG("Updating last tiled client for workspace %d "
+				  "to 0x%lx "
+				  "(toggle floating)\n",
+				  focused->workspace, focused->window);
 		}
 
 		arrangeClients(&monitors[focused->monitor]);
 	}
 
 	updateBorders();
-	restackFloatingWindows();
+	restackClients();
 	updateBars();
 }
 
@@ -3090,7 +3691,7 @@ void arrangeClients(SMonitor *monitor)
 		return;
 	}
 
-	fprintf(stderr, "Arranging clients for monitor %d\n", monitor->num);
+	LOG_DEBUG("Arranging clients for monitor %d\n", monitor->num);
 
 	if (strcasecmp(defaultLayout, "monocle") == 0) {
 		monitor->currentLayout = LAYOUT_MONOCLE;
@@ -3101,21 +3702,53 @@ void arrangeClients(SMonitor *monitor)
 	monitor->currentLayout =
 	    monitor->workspaceLayouts[monitor->currentWorkspace];
 
+	if (updateBatchDepth > 0) {
+		/* the arrange at the end of the batch maps and unmaps too */
+		deferredArranges |= 1u << monitor->num;
+		return;
+	}
+
+	uint64_t start = traceBegin();
+
 	if (monitor->currentLayout == LAYOUT_MONOCLE) {
 		monocleClients(monitor);
-
-		for (SClient *c = clients; c; c = c->next) {
-			if (c->monitor == monitor->num &&
-			    c->workspace == monitor->currentWorkspace &&
-			    c->isFloating && !c->isDock) {
-				XRaiseWindow(display, c->window);
-			}
-		}
 	} else {
 		tileClients(monitor);
 	}
 
 	updateClientVisibility();
+	statsCount(STATS_ARRANGES);
+	traceEnd(TRACE_ARRANGE, "arrange", monitor->num, start);
+}
+
+void beginUpdateBatch(void)
+{
+	updateBatchDepth++;
+}
+
+void endUpdateBatch(void)
+{
+	if (updateBatchDepth == 0 || --updateBatchDepth > 0) {
+		return;
+	}
+
+	for (int i = 0; i < numMonitors; i++) {
+		if (deferredArranges & (1u << i)) {
+			arrangeClients(&monitors[i]);
+		}
+	}
+	deferredArranges = 0;
+
+	if (deferredFocus) {
+		SClient *client = deferredFocus;
+		deferredFocus	= NULL;
+		focusClient(client);
+	}
+
+	if (barUpdatePending) {
+		barUpdatePending = 0;
+		updateBars();
+	}
 }
 
 void monocleClients(SMonitor *monitor)
@@ -3157,19 +3790,17 @@ void monocleClients(SMonitor *monitor)
 	if (!focusedClient && visibleCount > 0 && isActiveMonitor) {
 		if (lastTiledClient) {
 			focusedClient = lastTiledClient;
-			fprintf(stderr,
-				"Using last tiled client 0x%lx for workspace "
-				"%d\n",
-				focusedClient->window,
-				monitor->currentWorkspace);
+			LOG_DEBUG("Using last tiled client 0x%lx for workspace "
+				  "%d\n",
+				  focusedClient->window,
+				  monitor->currentWorkspace);
 		} else {
 			focusedClient = visibleClients[0];
 			monitor->lastTiledClient[monitor->currentWorkspace] =
 			    focusedClient->window;
-			fprintf(stderr,
-				"No last tiled client found, using first "
-				"client 0x%lx\n",
-				focusedClient->window);
+			LOG_DEBUG("No last tiled client found, using first "
+				  "client 0x%lx\n",
+				  focusedClient->window);
 		}
 
 		monitor->lastTiledClient[monitor->currentWorkspace] =
@@ -3203,16 +3834,15 @@ void monocleClients(SMonitor *monitor)
 		availableHeight -= dockHeight;
 
 		if (dockPosition == 1) {
-			fprintf(stderr,
-				"Adjusting monocle window position for bottom "
-				"dock: %d on monitor %d\n",
-				dockHeight, monitor->num);
+			LOG_DEBUG("Adjusting monocle window position for "
+				  "bottom "
+				  "dock: %d on monitor %d\n",
+				  dockHeight, monitor->num);
 		} else {
 			y += dockHeight;
-			fprintf(stderr,
-				"Adjusting monocle window position for top "
-				"dock: %d on monitor %d\n",
-				dockHeight, monitor->num);
+			LOG_DEBUG("Adjusting monocle window position for top "
+				  "dock: %d on monitor %d\n",
+				  dockHeight, monitor->num);
 		}
 	}
 
@@ -3227,50 +3857,17 @@ void monocleClients(SMonitor *monitor)
 		client->width  = width;
 		client->height = height;
 
-		XMoveResizeWindow(display, client->window, client->x, client->y,
-				  client->width, client->height);
-		XSetWindowBorderWidth(display, client->window, 0);
+		backend->moveResizeWindow(display, client->window, client->x,
+					  client->y, client->width,
+					  client->height);
+		backend->setWindowBorderWidth(display, client->window, 0);
 		configureClient(client);
 
 		if (client == focusedClient) {
-			XRaiseWindow(display, client->window);
-			XMapWindow(display, client->window);
+			raiseClient(client);
+			backend->mapWindow(display, client->window);
 		} else {
-			XUnmapWindow(display, client->window);
-		}
-	}
-}
-
-void restackFloatingWindows()
-{
-	for (int m = 0; m < numMonitors; m++) {
-		SMonitor *monitor = &monitors[m];
-
-		for (SClient *c = clients; c; c = c->next) {
-			if (c->monitor == monitor->num &&
-			    c->workspace == monitor->currentWorkspace &&
-			    c->isDock) {
-				XLowerWindow(display, c->window);
-			}
-		}
-
-		for (SClient *c = clients; c; c = c->next) {
-			if (c->monitor == monitor->num &&
-			    c->workspace == monitor->currentWorkspace &&
-			    !c->isFloating && !c->isDock) {
-				XLowerWindow(display, c->window);
-			}
-		}
-
-		for (SClient *c = clients; c; c = c->next) {
-			if (c->monitor == monitor->num &&
-			    c->workspace == monitor->currentWorkspace &&
-			    c->isFloating && !c->isDock) {
-				if (c == focused && (windowMovement.active ||
-						     windowResize.active)) {
-					XRaiseWindow(display, c->window);
-				}
-			}
+			backend->unmapWindow(display, client->window);
 		}
 	}
 }
@@ -3280,10 +3877,9 @@ int makeWindowFloatIfNeeded(SClient *client, SMonitor *monitor, int width,
 {
 	if ((width <= 0 || height <= 0 || width < 10 || height < 10) &&
 	    (lastMappedWindow == client->window)) {
-		fprintf(stderr,
-			"New window 0x%lx is too smol in tiled layout, "
-			"making it float\n",
-			client->window);
+		LOG_DEBUG("New window 0x%lx is too smol in tiled layout, "
+			  "making it float\n",
+			  client->window);
 
 		client->isFloating = 1;
 
@@ -3308,8 +3904,9 @@ int makeWindowFloatIfNeeded(SClient *client, SMonitor *monitor, int width,
 			client->y = monitor->y + barHeight;
 		}
 
-		XMoveResizeWindow(display, client->window, client->x, client->y,
-				  client->width, client->height);
+		backend->moveResizeWindow(display, client->window, client->x,
+					  client->y, client->width,
+					  client->height);
 		configureClient(client);
 
 		XGrabButton(display, Button3, modkey, client->window, False,
@@ -3385,16 +3982,14 @@ void tileClients(SMonitor *monitor)
 		availableHeight -= dockHeight;
 
 		if (dockPosition == 1) {
-			fprintf(stderr,
-				"Adjusting tiled window positions for bottom "
-				"dock: %d on monitor %d\n",
-				dockHeight, monitor->num);
+			LOG_DEBUG("Adjusting tiled window positions for bottom "
+				  "dock: %d on monitor %d\n",
+				  dockHeight, monitor->num);
 		} else {
 			y += dockHeight;
-			fprintf(stderr,
-				"Adjusting tiled window positions for top "
-				"dock: %d on monitor %d\n",
-				dockHeight, monitor->num);
+			LOG_DEBUG("Adjusting tiled window positions for top "
+				  "dock: %d on monitor %d\n",
+				  dockHeight, monitor->num);
 		}
 	}
 
@@ -3412,14 +4007,14 @@ void tileClients(SMonitor *monitor)
 		client->width  = width;
 		client->height = height;
 
-		XMoveResizeWindow(display, client->window, client->x, client->y,
-				  client->width, client->height);
+		backend->moveResizeWindow(display, client->window, client->x,
+					  client->y, client->width,
+					  client->height);
 		configureClient(client);
-		fprintf(stderr,
-			"Single window tiled: monitor=%d pos=%d,%d "
-			"size=%dx%d\n",
-			monitor->num, client->x, client->y, client->width,
-			client->height);
+		LOG_DEBUG("Single window tiled: monitor=%d pos=%d,%d "
+			  "size=%dx%d\n",
+			  monitor->num, client->x, client->y, client->width,
+			  client->height);
 		return;
 	}
 
@@ -3474,9 +4069,10 @@ void tileClients(SMonitor *monitor)
 			client->width  = width;
 			client->height = height;
 
-			XMoveResizeWindow(display, client->window, client->x,
-					  client->y, client->width,
-					  client->height);
+			backend->moveResizeWindow(display, client->window,
+						  client->x, client->y,
+						  client->width,
+						  client->height);
 			configureClient(client);
 
 			my += height + useInnerGap + 2 * borderWidth;
@@ -3542,9 +4138,10 @@ void tileClients(SMonitor *monitor)
 				    height + useInnerGap + 2 * borderWidth;
 			}
 
-			XMoveResizeWindow(display, client->window, client->x,
-					  client->y, client->width,
-					  client->height);
+			backend->moveResizeWindow(display, client->window,
+						  client->x, client->y,
+						  client->width,
+						  client->height);
 			configureClient(client);
 		}
 	} else {
@@ -3593,9 +4190,10 @@ void tileClients(SMonitor *monitor)
 			client->width  = width;
 			client->height = height;
 
-			XMoveResizeWindow(display, client->window, client->x,
-					  client->y, client->width,
-					  client->height);
+			backend->moveResizeWindow(display, client->window,
+						  client->x, client->y,
+						  client->width,
+						  client->height);
 			configureClient(client);
 
 			masterY += currentHeight;
@@ -3625,9 +4223,10 @@ void tileClients(SMonitor *monitor)
 			client->width  = width;
 			client->height = height;
 
-			XMoveResizeWindow(display, client->window, client->x,
-					  client->y, client->width,
-					  client->height);
+			backend->moveResizeWindow(display, client->window,
+						  client->x, client->y,
+						  client->width,
+						  client->height);
 			configureClient(client);
 
 			stackY += currentHeight;
@@ -3652,7 +4251,7 @@ void warpPointerToClientCenter(SClient *client)
 	int centerX = client->x + client->width / 2;
 	int centerY = client->y + client->height / 2;
 
-	XWarpPointer(display, None, root, 0, 0, 0, 0, centerX, centerY);
+	backend->warpPointer(display, None, root, 0, 0, 0, 0, centerX, centerY);
 	lastCursorWarp = 1;
 	gettimeofday(&lastWindowOperation, NULL);
 }
@@ -3682,7 +4281,7 @@ void moveWindowInStack(const char *arg)
 			moveWindow(focused, focused->x + moveStep, focused->y);
 		}
 
-		XRaiseWindow(display, focused->window);
+		raiseClient(focused);
 
 		if (!no_warps) {
 			warpPointerToClientCenter(focused);
@@ -3737,13 +4336,13 @@ void moveWindowInStack(const char *arg)
 	}
 
 	if (targetClient && targetClient != focused) {
-		fprintf(stderr,
-			"Moving window in stack: 0x%lx with 0x%lx (direction: "
-			"%s)\n",
-			focused->window, targetClient->window, arg);
+		LOG_DEBUG("Moving window in stack: 0x%lx with 0x%lx "
+			  "(direction: "
+			  "%s)\n",
+			  focused->window, targetClient->window, arg);
 		swapClients(focused, targetClient);
 		arrangeClients(monitor);
-		restackFloatingWindows();
+		restackClients();
 
 		if (!no_warps) {
 			warpPointerToClientCenter(focused);
@@ -3825,26 +4424,26 @@ void cycleFocusBetweenFloatingAndMonocle(const char *arg)
 	}
 
 	if (targetClient && targetClient != focused) {
-		fprintf(stderr,
-			"Cycling focus between monocle and floating: "
-			"0x%lx (direction: %s)\n",
-			targetClient->window, arg);
+		LOG_DEBUG("Cycling focus between monocle and floating: "
+			  "0x%lx (direction: %s)\n",
+			  targetClient->window, arg);
 
 		if (!targetClient->isFloating) {
 			monitor->lastTiledClient[workspace] =
 			    targetClient->window;
-			XMapWindow(display, targetClient->window);
-			XRaiseWindow(display, targetClient->window);
+			backend->mapWindow(display, targetClient->window);
+			raiseClient(targetClient);
 
 			if (prevFocused && !prevFocused->isFloating) {
-				XUnmapWindow(display, prevFocused->window);
+				backend->unmapWindow(display,
+						     prevFocused->window);
 			}
 		} else {
-			XMapWindow(display, targetClient->window);
-			XRaiseWindow(display, targetClient->window);
+			backend->mapWindow(display, targetClient->window);
+			raiseClient(targetClient);
 		}
 
-		XSync(display, False);
+		backend->sync(display, False);
 		focusClient(targetClient);
 		warpPointerToClientCenter(targetClient);
 		gettimeofday(&lastWindowOperation, NULL);
@@ -3904,23 +4503,23 @@ void focusWindowInStack(const char *arg)
 		targetClient = monocleClients[focusedIndex];
 
 		if (targetClient && targetClient != focused) {
-			fprintf(stderr,
-				"Cycling monocle window: 0x%lx (direction: "
-				"%s)\n",
-				targetClient->window, arg);
+			LOG_DEBUG("Cycling monocle window: 0x%lx (direction: "
+				  "%s)\n",
+				  targetClient->window, arg);
 
-			XMapWindow(display, targetClient->window);
-			XRaiseWindow(display, targetClient->window);
+			backend->mapWindow(display, targetClient->window);
+			raiseClient(targetClient);
 
-			XSync(display, False);
+			backend->sync(display, False);
 
 			focusClient(targetClient);
 
 			if (!prevFocused->isFloating) {
-				XUnmapWindow(display, prevFocused->window);
+				backend->unmapWindow(display,
+						     prevFocused->window);
 			}
 
-			XSync(display, False);
+			backend->sync(display, False);
 
 			warpPointerToClientCenter(targetClient);
 		}
@@ -4001,10 +4600,9 @@ void focusWindowInStack(const char *arg)
 	}
 
 	if (targetClient && targetClient != focused) {
-		fprintf(stderr,
-			"Focusing window in stack: 0x%lx (direction: %s, "
-			"floating: %d)\n",
-			targetClient->window, arg, targetClient->isFloating);
+		LOG_DEBUG("Focusing window in stack: 0x%lx (direction: %s, "
+			  "floating: %d)\n",
+			  targetClient->window, arg, targetClient->isFloating);
 		focusClient(targetClient);
 		warpPointerToClientCenter(targetClient);
 		gettimeofday(&lastWindowOperation, NULL);
@@ -4039,13 +4637,6 @@ void adjustMasterFactor(const char *arg)
 	}
 
 	tileClients(monitor);
-	for (SClient *c = clients; c; c = c->next) {
-		if (c->monitor == monitor->num &&
-		    c->workspace == monitor->currentWorkspace &&
-		    !c->isFloating) {
-			XLowerWindow(display, c->window);
-		}
-	}
 }
 
 void swapClients(SClient *a, SClient *b)
@@ -4054,8 +4645,8 @@ void swapClients(SClient *a, SClient *b)
 		return;
 	}
 
-	fprintf(stderr, "Swapping clients in list: 0x%lx and 0x%lx\n",
-		a->window, b->window);
+	LOG_DEBUG("Swapping clients in list: 0x%lx and 0x%lx\n", a->window,
+		  b->window);
 
 	SClient *aNext = a->next;
 	SClient *bNext = b->next;
@@ -4100,65 +4691,189 @@ void swapClients(SClient *a, SClient *b)
 			clients = b;
 		}
 
-		if (prevB) {
-			prevB->next = a;
-		} else {
-			clients = a;
+		if (prevB) {
+			prevB->next = a;
+		} else {
+			clients = a;
+		}
+
+		a->next = bNext;
+		b->next = aNext;
+	}
+
+	if (a->next == a) {
+		a->next = b;
+	}
+	if (b->next == b) {
+		b->next = a;
+	}
+
+	restackClients();
+}
+
+void invalidateRootProperties(unsigned int properties)
+{
+	dirtyRootProperties |= properties;
+}
+
+void invalidateCurrentDesktop(int workspace)
+{
+	pendingDesktop = workspace;
+	invalidateRootProperties(ROOT_CURRENT_DESKTOP);
+}
+
+/*
+ * windows managed since the last flush are appended, only a removal of a
+ * window the root already lists rewrites the whole property
+ */
+static void publishClientList(void)
+{
+	if (clientListPublished < 0) {
+		backend->changeProperty(display, root, NET_CLIENT_LIST,
+					XA_WINDOW, 32, PropModeReplace,
+					(unsigned char *)clientListOrder,
+					clientListCount);
+	} else if (clientListPublished < clientListCount) {
+		backend->changeProperty(
+		    display, root, NET_CLIENT_LIST, XA_WINDOW, 32,
+		    PropModeAppend,
+		    (unsigned char *)&clientListOrder[clientListPublished],
+		    clientListCount - clientListPublished);
+	}
+	clientListPublished = clientListCount;
+}
+
+/* the last order restackClients sent, bottom to top and without the bars */
+static void publishClientListStacking(void)
+{
+	Window windowList[MAX(appliedStackCount, 1)];
+	int    count = 0;
+
+	for (int i = appliedStackCount - 1; i >= 0; i--) {
+		if (i < appliedFirstBar || i >= appliedFirstBar + appliedBars) {
+			windowList[count++] = appliedStack[i];
+		}
+	}
+
+	backend->changeProperty(display, root, NET_CLIENT_LIST_STACKING,
+				XA_WINDOW, 32, PropModeReplace,
+				(unsigned char *)windowList, count);
+
+	LOG_DEBUG("Updated _NET_CLIENT_LIST_STACKING with %d windows\n", count);
+}
+
+static void publishCurrentDesktop(void)
+{
+	if (pendingDesktop == publishedDesktop) {
+		return;
+	}
+
+	long currentDesktop = pendingDesktop;
+	backend->changeProperty(display, root, NET_CURRENT_DESKTOP, XA_CARDINAL,
+				32, PropModeReplace,
+				(unsigned char *)&currentDesktop, 1);
+	publishedDesktop = pendingDesktop;
+}
+
+static void publishDesktopViewport(void)
+{
+	if (!monitors || numMonitors <= 0 || workspaceCount <= 0) {
+		LOG_ERROR("Cannot update desktop viewport: no monitors "
+			  "or invalid workspace count\n");
+		return;
+	}
+
+	long data[workspaceCount * 2];
+	int  idx = 0;
+
+	for (int ws = 0; ws < workspaceCount; ws++) {
+		int monitorFound = 0;
+
+		for (int m = 0; m < numMonitors; m++) {
+			if (monitors[m].currentWorkspace == ws) {
+				data[idx++]  = monitors[m].x;
+				data[idx++]  = monitors[m].y;
+				monitorFound = 1;
+				break;
+			}
 		}
 
-		a->next = bNext;
-		b->next = aNext;
+		if (!monitorFound) {
+			data[idx++] = monitors[0].x;
+			data[idx++] = monitors[0].y;
+		}
 	}
 
-	if (a->next == a) {
-		a->next = b;
-	}
-	if (b->next == b) {
-		b->next = a;
-	}
+	backend->changeProperty(display, root, NET_DESKTOP_VIEWPORT,
+				XA_CARDINAL, 32, PropModeReplace,
+				(unsigned char *)data, idx);
 
-	restackFloatingWindows();
+	LOG_DEBUG("Updated desktop viewport information for %d workspaces\n",
+		  workspaceCount);
 }
 
-void updateClientList()
+static void publishDesktopNames(void)
 {
-	Window	 windowList[MAX_CLIENTS];
-	int	 count	= 0;
-	SClient *client = clients;
-
-	while (client && count < MAX_CLIENTS) {
-		windowList[count++] = client->window;
-		client		    = client->next;
+	if (workspaceCount <= 0) {
+		return;
 	}
 
-	XChangeProperty(display, root, NET_CLIENT_LIST, XA_WINDOW, 32,
-			PropModeReplace, (unsigned char *)windowList, count);
-}
+	char *names[workspaceCount];
+	char  buffer[workspaceCount][32];
+	int   totalSize = 0;
 
-void updateClientListStacking()
-{
-	Window windowList[MAX_CLIENTS];
-	int    count = 0;
+	for (int i = 0; i < workspaceCount; i++) {
+		snprintf(buffer[i], sizeof(buffer[i]), "%d", i + 1);
+		names[i] = buffer[i];
+		totalSize += strlen(names[i]) + 1;
+	}
 
-	for (SClient *client = clients; client && count < MAX_CLIENTS;
-	     client	     = client->next) {
-		if (client->isFloating || client->isFullscreen) {
-			windowList[count++] = client->window;
-		}
+	char *nameBuffer = malloc(totalSize);
+	if (!nameBuffer) {
+		LOG_ERROR("Failed to allocate memory for desktop "
+			  "names\n");
+		return;
 	}
 
-	for (SClient *client = clients; client && count < MAX_CLIENTS;
-	     client	     = client->next) {
-		if (!client->isFloating && !client->isFullscreen) {
-			windowList[count++] = client->window;
-		}
+	char *ptr = nameBuffer;
+	for (int i = 0; i < workspaceCount; i++) {
+		strcpy(ptr, names[i]);
+		ptr += strlen(names[i]) + 1;
 	}
 
-	XChangeProperty(display, root, NET_CLIENT_LIST_STACKING, XA_WINDOW, 32,
-			PropModeReplace, (unsigned char *)windowList, count);
+	backend->changeProperty(display, root, NET_DESKTOP_NAMES, UTF8_STRING,
+				8, PropModeReplace, (unsigned char *)nameBuffer,
+				totalSize);
 
-	fprintf(stderr, "Updated _NET_CLIENT_LIST_STACKING with %d windows\n",
-		count);
+	free(nameBuffer);
+	LOG_DEBUG("Updated _NET_DESKTOP_NAMES with %d workspaces\n",
+		  workspaceCount);
+}
+
+/*
+ * called once per batch of events and ipc commands, so a pager sees one
+ * PropertyNotify per property however often an action changed it
+ */
+void flushRootProperties(void)
+{
+	unsigned int dirty  = dirtyRootProperties;
+	dirtyRootProperties = 0;
+
+	if (dirty & ROOT_CLIENT_LIST) {
+		publishClientList();
+	}
+	if (dirty & ROOT_CLIENT_LIST_STACKING) {
+		publishClientListStacking();
+	}
+	if (dirty & ROOT_CURRENT_DESKTOP) {
+		publishCurrentDesktop();
+	}
+	if (dirty & ROOT_DESKTOP_VIEWPORT) {
+		publishDesktopViewport();
+	}
+	if (dirty & ROOT_DESKTOP_NAMES) {
+		publishDesktopNames();
+	}
 }
 
 Atom getAtomProperty(SClient *client, Atom prop)
@@ -4168,9 +4883,9 @@ Atom getAtomProperty(SClient *client, Atom prop)
 	unsigned char *p = NULL;
 	Atom	       da, atom = None;
 
-	if (XGetWindowProperty(display, client->window, prop, 0L, sizeof atom,
-			       False, XA_ATOM, &da, &di, &dl, &dl,
-			       &p) == Success &&
+	if (backend->getWindowProperty(display, client->window, prop, 0L,
+				       sizeof atom, False, XA_ATOM, &da, &di,
+				       &dl, &dl, &p) == Success &&
 	    p) {
 		atom = *(Atom *)p;
 		XFree(p);
@@ -4182,8 +4897,8 @@ void setClientState(SClient *client, long state)
 {
 	long data[] = {state, None};
 
-	XChangeProperty(display, client->window, WM_STATE, WM_STATE, 32,
-			PropModeReplace, (unsigned char *)data, 2);
+	backend->changeProperty(display, client->window, WM_STATE, WM_STATE, 32,
+				PropModeReplace, (unsigned char *)data, 2);
 }
 
 int sendEvent(SClient *client, Atom proto)
@@ -4193,7 +4908,7 @@ int sendEvent(SClient *client, Atom proto)
 	int    exists = 0;
 	XEvent ev;
 
-	if (XGetWMProtocols(display, client->window, &protocols, &n)) {
+	if (backend->getWMProtocols(display, client->window, &protocols, &n)) {
 		while (!exists && n--) {
 			exists = protocols[n] == proto;
 		}
@@ -4207,7 +4922,8 @@ int sendEvent(SClient *client, Atom proto)
 		ev.xclient.format	= 32;
 		ev.xclient.data.l[0]	= proto;
 		ev.xclient.data.l[1]	= CurrentTime;
-		XSendEvent(display, client->window, False, NoEventMask, &ev);
+		backend->sendEvent(display, client->window, False, NoEventMask,
+				   &ev);
 	}
 	return exists;
 }
@@ -4223,8 +4939,8 @@ void setFullscreen(SClient *client, int fullscreen)
 	}
 
 	if (fullscreen) {
-		fprintf(stderr, "Setting fullscreen for window 0x%lx\n",
-			client->window);
+		LOG_DEBUG("Setting fullscreen for window 0x%lx\n",
+			  client->window);
 
 		client->oldx	  = client->x;
 		client->oldy	  = client->y;
@@ -4245,18 +4961,20 @@ void setFullscreen(SClient *client, int fullscreen)
 		XUngrabButton(display, Button1, modkey, client->window);
 		XUngrabButton(display, Button3, modkey, client->window);
 
-		XSetWindowBorderWidth(display, client->window, 0);
-		XMoveResizeWindow(display, client->window, client->x, client->y,
-				  client->width, client->height);
-		XRaiseWindow(display, client->window);
+		backend->setWindowBorderWidth(display, client->window, 0);
+		backend->moveResizeWindow(display, client->window, client->x,
+					  client->y, client->width,
+					  client->height);
+		raiseClient(client);
 		configureClient(client);
 
-		XChangeProperty(display, client->window, NET_WM_STATE, XA_ATOM,
-				32, PropModeReplace,
-				(unsigned char *)&NET_WM_STATE_FULLSCREEN, 1);
+		backend->changeProperty(
+		    display, client->window, NET_WM_STATE, XA_ATOM, 32,
+		    PropModeReplace, (unsigned char *)&NET_WM_STATE_FULLSCREEN,
+		    1);
 	} else {
-		fprintf(stderr, "Unsetting fullscreen for window 0x%lx\n",
-			client->window);
+		LOG_DEBUG("Unsetting fullscreen for window 0x%lx\n",
+			  client->window);
 
 		client->isFullscreen = 0;
 		client->isFloating   = client->oldState;
@@ -4279,19 +4997,22 @@ void setFullscreen(SClient *client, int fullscreen)
 				    resizeSECursor);
 		}
 
-		XSetWindowBorderWidth(display, client->window, borderWidth);
-		XMoveResizeWindow(display, client->window, client->x, client->y,
-				  client->width, client->height);
+		backend->setWindowBorderWidth(display, client->window,
+					      borderWidth);
+		backend->moveResizeWindow(display, client->window, client->x,
+					  client->y, client->width,
+					  client->height);
 		configureClient(client);
 
-		XChangeProperty(display, client->window, NET_WM_STATE, XA_ATOM,
-				32, PropModeReplace, (unsigned char *)NULL, 0);
+		backend->changeProperty(display, client->window, NET_WM_STATE,
+					XA_ATOM, 32, PropModeReplace,
+					(unsigned char *)NULL, 0);
 
 		SMonitor *monitor = &monitors[client->monitor];
 		if (!client->isFloating &&
 		    monitor->currentLayout == LAYOUT_MONOCLE) {
-			fprintf(stderr, "Unfullscreening in monocle mode, "
-					"setting as lastTiledClient\n");
+			LOG_DEBUG("Unfullscreening in monocle mode, "
+				  "setting as lastTiledClient\n");
 			monitor->lastTiledClient[client->workspace] =
 			    client->window;
 		}
@@ -4301,7 +5022,7 @@ void setFullscreen(SClient *client, int fullscreen)
 	arrangeClients(monitor);
 	updateClientVisibility();
 	updateClientAllowedActions(client);
-	updateClientListStacking();
+	restackClients();
 	updateBars();
 }
 
@@ -4313,34 +5034,34 @@ int *getStrut(Window window)
 	unsigned long	     nitems, bytes_after;
 	unsigned char	    *data = NULL;
 
-	if (XGetWindowProperty(display, window, NET_WM_STRUT_PARTIAL, 0, 12,
-			       False, XA_CARDINAL, &actual_type, &actual_format,
-			       &nitems, &bytes_after, &data) == Success &&
+	if (backend->getWindowProperty(display, window, NET_WM_STRUT_PARTIAL, 0,
+				       12, False, XA_CARDINAL, &actual_type,
+				       &actual_format, &nitems, &bytes_after,
+				       &data) == Success &&
 	    data) {
 		if (nitems == 12) {
 			memcpy(strut, data, 12 * sizeof(unsigned long));
 			XFree(data);
-			fprintf(stderr,
-				"Found _NET_WM_STRUT_PARTIAL: left=%lu "
-				"right=%lu top=%lu bottom=%lu\n",
-				strut[0], strut[1], strut[2], strut[3]);
+			LOG_DEBUG("Found _NET_WM_STRUT_PARTIAL: left=%lu "
+				  "right=%lu top=%lu bottom=%lu\n",
+				  strut[0], strut[1], strut[2], strut[3]);
 			return (int *)strut;
 		}
 		XFree(data);
 	}
 
 	data = NULL;
-	if (XGetWindowProperty(display, window, NET_WM_STRUT, 0, 4, False,
-			       XA_CARDINAL, &actual_type, &actual_format,
-			       &nitems, &bytes_after, &data) == Success &&
+	if (backend->getWindowProperty(display, window, NET_WM_STRUT, 0, 4,
+				       False, XA_CARDINAL, &actual_type,
+				       &actual_format, &nitems, &bytes_after,
+				       &data) == Success &&
 	    data) {
 		if (nitems == 4) {
 			memcpy(strut, data, 4 * sizeof(unsigned long));
 			XFree(data);
-			fprintf(stderr,
-				"Found _NET_WM_STRUT: left=%lu right=%lu "
-				"top=%lu bottom=%lu\n",
-				strut[0], strut[1], strut[2], strut[3]);
+			LOG_DEBUG("Found _NET_WM_STRUT: left=%lu right=%lu "
+				  "top=%lu bottom=%lu\n",
+				  strut[0], strut[1], strut[2], strut[3]);
 			return (int *)strut;
 		}
 		XFree(data);
@@ -4354,13 +5075,12 @@ void updateWindowType(SClient *client)
 	Atom state = getAtomProperty(client, NET_WM_STATE);
 	Atom wtype = getAtomProperty(client, NET_WM_WINDOW_TYPE);
 
-	fprintf(stderr,
-		"Checking window type for 0x%lx, state=%ld, wtype=%ld\n",
-		client->window, state, wtype);
+	LOG_DEBUG("Checking window type for 0x%lx, state=%ld, wtype=%ld\n",
+		  client->window, state, wtype);
 
 	if (state == NET_WM_STATE_FULLSCREEN) {
-		fprintf(stderr, "Fullscreen window detected, forcing proper "
-				"position\n");
+		LOG_DEBUG("Fullscreen window detected, forcing proper "
+			  "position\n");
 		if (!client->isFullscreen) {
 			client->oldx	  = client->x;
 			client->oldy	  = client->y;
@@ -4380,28 +5100,30 @@ void updateWindowType(SClient *client)
 			XUngrabButton(display, Button1, modkey, client->window);
 			XUngrabButton(display, Button3, modkey, client->window);
 
-			XSetWindowBorderWidth(display, client->window, 0);
-			XChangeProperty(
+			backend->setWindowBorderWidth(display, client->window,
+						      0);
+			backend->changeProperty(
 			    display, client->window, NET_WM_STATE, XA_ATOM, 32,
 			    PropModeReplace,
 			    (unsigned char *)&NET_WM_STATE_FULLSCREEN, 1);
 
-			XMoveResizeWindow(display, client->window, client->x,
-					  client->y, client->width,
-					  client->height);
+			backend->moveResizeWindow(display, client->window,
+						  client->x, client->y,
+						  client->width,
+						  client->height);
 			configureClient(client);
-			XRaiseWindow(display, client->window);
+			raiseClient(client);
 		}
 	}
 	if (wtype == NET_WM_WINDOW_TYPE_DIALOG ||
 	    wtype == NET_WM_WINDOW_TYPE_UTILITY) {
-		fprintf(stderr, "Dialog or utility window detected, forcing "
-				"floating mode\n");
+		LOG_DEBUG("Dialog or utility window detected, forcing "
+			  "floating mode\n");
 		client->isFloating = 1;
 	}
 	if (wtype == NET_WM_WINDOW_TYPE_DOCK) {
-		fprintf(stderr, "Dock window detected, setting appropriate "
-				"properties\n");
+		LOG_DEBUG("Dock window detected, setting appropriate "
+			  "properties\n");
 		client->isDock	   = 1;
 		client->isFloating = 1;
 		client->noswallow  = 1;
@@ -4409,8 +5131,8 @@ void updateWindowType(SClient *client)
 		client->oldWorkspace = client->workspace;
 		client->workspace    = DOCK_WORKSPACE;
 
-		fprintf(stderr, "Dock window 0x%lx assigned to monitor %d\n",
-			client->window, client->monitor);
+		LOG_DEBUG("Dock window 0x%lx assigned to monitor %d\n",
+			  client->window, client->monitor);
 
 		int	 *strut	  = getStrut(client->window);
 		SMonitor *monitor = &monitors[client->monitor];
@@ -4418,50 +5140,48 @@ void updateWindowType(SClient *client)
 		if (strut) {
 			if (strut[2] > 0) {
 				client->y = monitor->y;
-				fprintf(stderr,
-					"Positioning dock at top edge: y=%d\n",
-					client->y);
+				LOG_DEBUG("Positioning dock at top edge: "
+					  "y=%d\n",
+					  client->y);
 			} else if (strut[3] > 0) {
 				client->y = monitor->y + monitor->height -
 					    client->height;
-				fprintf(stderr,
-					"Positioning dock at bottom edge: "
-					"y=%d\n",
-					client->y);
+				LOG_DEBUG("Positioning dock at bottom edge: "
+					  "y=%d\n",
+					  client->y);
 			} else if (strut[0] > 0) {
 				client->x = monitor->x;
-				fprintf(stderr,
-					"Positioning dock at left edge: x=%d\n",
-					client->x);
+				LOG_DEBUG("Positioning dock at left edge: "
+					  "x=%d\n",
+					  client->x);
 			} else if (strut[1] > 0) {
 				client->x =
 				    monitor->x + monitor->width - client->width;
-				fprintf(stderr,
-					"Positioning dock at right edge: "
-					"x=%d\n",
-					client->x);
+				LOG_DEBUG("Positioning dock at right edge: "
+					  "x=%d\n",
+					  client->x);
 			}
 		}
 
 		XSizeHints hints;
 		long	   supplied;
 
-		if (XGetWMNormalHints(display, client->window, &hints,
-				      &supplied)) {
+		if (backend->getWMNormalHints(display, client->window, &hints,
+					      &supplied)) {
 			if (supplied & PPosition) {
-				fprintf(stderr,
-					"Using position hints for dock: "
-					"%d,%d\n",
-					hints.x, hints.y);
+				LOG_DEBUG("Using position hints for dock: "
+					  "%d,%d\n",
+					  hints.x, hints.y);
 				client->x = hints.x;
 				client->y = hints.y;
 			}
 		}
 
-		XMoveWindow(display, client->window, client->x, client->y);
+		backend->moveWindow(display, client->window, client->x,
+				    client->y);
 		XUngrabButton(display, Button1, modkey, client->window);
 		XUngrabButton(display, Button3, modkey, client->window);
-		XSetWindowBorderWidth(display, client->window, 0);
+		backend->setWindowBorderWidth(display, client->window, 0);
 
 		for (int i = 0; i < numMonitors; i++) {
 			SMonitor *m = &monitors[i];
@@ -4469,10 +5189,10 @@ void updateWindowType(SClient *client)
 			    client->x + client->width > m->x &&
 			    client->y < m->y + m->height &&
 			    client->y + client->height > m->y) {
-				fprintf(stderr,
-					"Dock affects monitor %d, will arrange "
-					"it\n",
-					i);
+				LOG_DEBUG("Dock affects monitor %d, will "
+					  "arrange "
+					  "it\n",
+					  i);
 				arrangeClients(&monitors[i]);
 			}
 		}
@@ -4483,10 +5203,10 @@ void updateWMHints(SClient *client)
 {
 	XWMHints *wmh;
 
-	if ((wmh = XGetWMHints(display, client->window))) {
+	if ((wmh = backend->getWMHints(display, client->window))) {
 		if (client == focused && wmh->flags & XUrgencyHint) {
 			wmh->flags &= ~XUrgencyHint;
-			XSetWMHints(display, client->window, wmh);
+			backend->setWMHints(display, client->window, wmh);
 			client->isUrgent = 0;
 			updateClientUrgency(client);
 		} else {
@@ -4495,6 +5215,9 @@ void updateWMHints(SClient *client)
 
 			if (wasUrgent != client->isUrgent) {
 				updateClientUrgency(client);
+				ipcEmitEvent(IPC_EVENT_URGENCY, client->window,
+					     client->monitor, client->workspace,
+					     client->isUrgent);
 			}
 		}
 
@@ -4517,34 +5240,37 @@ void handleClientMessage(XEvent *event)
 	if (cme->message_type == NET_CURRENT_DESKTOP && cme->window == root) {
 		int workspace = cme->data.l[0];
 		if (workspace >= 0 && workspace < workspaceCount) {
-			fprintf(stderr,
-				"Received _NET_CURRENT_DESKTOP message, "
-				"switching to workspace %d\n",
-				workspace);
+			LOG_DEBUG("Received _NET_CURRENT_DESKTOP message, "
+				  "switching to workspace %d\n",
+				  workspace);
 			SMonitor *currentMonitor	 = getCurrentMonitor();
 			currentMonitor->currentWorkspace = workspace;
 			currentWorkspace		 = workspace;
+			ipcEmitEvent(IPC_EVENT_WORKSPACE, 0,
+				     currentMonitor->num, workspace, 0);
 
-			long currentDesktop = workspace;
-			XChangeProperty(display, root, NET_CURRENT_DESKTOP,
-					XA_CARDINAL, 32, PropModeReplace,
-					(unsigned char *)&currentDesktop, 1);
+			invalidateCurrentDesktop(workspace);
 
-			XDeleteProperty(display, root, NET_ACTIVE_WINDOW);
+			backend->deleteProperty(display, root,
+						NET_ACTIVE_WINDOW);
 
-			updateDesktopViewport();
+			invalidateRootProperties(ROOT_DESKTOP_VIEWPORT);
 			updateClientVisibility();
 			updateBars();
 
-			SClient *clientToFocus = findVisibleClientInWorkspace(
-			    currentMonitor->num, workspace);
+			SClient *clientToFocus =
+			    recentClient(currentMonitor->num, workspace, 0);
+			if (!clientToFocus) {
+				clientToFocus = findVisibleClientInWorkspace(
+				    currentMonitor->num, workspace);
+			}
 			if (clientToFocus) {
 				focusClient(clientToFocus);
 			} else {
 				focused = NULL;
-				XSetInputFocus(display, root,
-					       RevertToPointerRoot,
-					       CurrentTime);
+				backend->setInputFocus(display, root,
+						       RevertToPointerRoot,
+						       CurrentTime);
 				updateBorders();
 			}
 
@@ -4571,10 +5297,13 @@ void handleClientMessage(XEvent *event)
 			    monitors[client->monitor].currentWorkspace) {
 				client->isUrgent = 1;
 				updateClientUrgency(client);
+				ipcEmitEvent(IPC_EVENT_URGENCY, client->window,
+					     client->monitor, client->workspace,
+					     1);
 				updateBorders();
 				updateBars();
 
-				XChangeProperty(
+				backend->changeProperty(
 				    display, root, NET_ACTIVE_WINDOW, XA_WINDOW,
 				    32, PropModeReplace,
 				    (unsigned char *)&client->window, 1);
@@ -4586,10 +5315,9 @@ void handleClientMessage(XEvent *event)
 		long workspace = cme->data.l[0];
 
 		if (workspace >= 0 && workspace < workspaceCount) {
-			fprintf(stderr,
-				"Received _NET_WM_DESKTOP message, moving "
-				"window 0x%lx to workspace %ld\n",
-				client->window, workspace);
+			LOG_DEBUG("Received _NET_WM_DESKTOP message, moving "
+				  "window 0x%lx to workspace %ld\n",
+				  client->window, workspace);
 
 			client->oldWorkspace = client->workspace;
 			client->workspace    = workspace;
@@ -4597,9 +5325,9 @@ void handleClientMessage(XEvent *event)
 
 			if (workspace !=
 			    monitors[client->monitor].currentWorkspace) {
-				XUnmapWindow(display, client->window);
+				backend->unmapWindow(display, client->window);
 			} else {
-				XMapWindow(display, client->window);
+				backend->mapWindow(display, client->window);
 				focusClient(client);
 			}
 
@@ -4608,9 +5336,8 @@ void handleClientMessage(XEvent *event)
 		}
 	} else if (cme->message_type == NET_CLOSE_WINDOW) {
 		if (client) {
-			fprintf(stderr,
-				"Received _NET_CLOSE_WINDOW for 0x%lx\n",
-				client->window);
+			LOG_DEBUG("Received _NET_CLOSE_WINDOW for 0x%lx\n",
+				  client->window);
 			if (!sendEvent(client, WM_DELETE_WINDOW)) {
 				XKillClient(display, client->window);
 			}
@@ -4621,10 +5348,9 @@ void handleClientMessage(XEvent *event)
 			int y_root    = cme->data.l[1];
 			int direction = cme->data.l[2];
 
-			fprintf(stderr,
-				"Received _NET_WM_MOVERESIZE for 0x%lx, "
-				"direction: %d\n",
-				client->window, direction);
+			LOG_DEBUG("Received _NET_WM_MOVERESIZE for 0x%lx, "
+				  "direction: %d\n",
+				  client->window, direction);
 
 			if (direction == 8) {
 				windowMovement.active	= 1;
@@ -4633,7 +5359,7 @@ void handleClientMessage(XEvent *event)
 				windowMovement.y	= y_root;
 				windowMovement.wasTiled = 0;
 
-				XRaiseWindow(display, client->window);
+				raiseClient(client);
 				XGrabPointer(display, root, False,
 					     ButtonReleaseMask |
 						 PointerMotionMask,
@@ -4646,7 +5372,7 @@ void handleClientMessage(XEvent *event)
 				windowResize.y		= y_root;
 				windowResize.resizeType = direction;
 
-				XRaiseWindow(display, client->window);
+				raiseClient(client);
 				XGrabPointer(display, root, False,
 					     ButtonReleaseMask |
 						 PointerMotionMask,
@@ -4656,9 +5382,8 @@ void handleClientMessage(XEvent *event)
 		}
 	} else if (cme->message_type == NET_MOVERESIZE_WINDOW) {
 		if (client) {
-			fprintf(stderr,
-				"Received _NET_MOVERESIZE_WINDOW for 0x%lx\n",
-				client->window);
+			LOG_DEBUG("Received _NET_MOVERESIZE_WINDOW for 0x%lx\n",
+				  client->window);
 
 			int flags  = cme->data.l[0] & 0xFF;
 			int x	   = cme->data.l[1];
@@ -4679,17 +5404,17 @@ void handleClientMessage(XEvent *event)
 				client->height = height;
 			}
 
-			XMoveResizeWindow(display, client->window, client->x,
-					  client->y, client->width,
-					  client->height);
+			backend->moveResizeWindow(display, client->window,
+						  client->x, client->y,
+						  client->width,
+						  client->height);
 			configureClient(client);
 		}
 	} else if (cme->message_type == NET_REQUEST_FRAME_EXTENTS) {
 		if (client) {
-			fprintf(stderr,
-				"Received _NET_REQUEST_FRAME_EXTENTS for "
-				"0x%lx\n",
-				client->window);
+			LOG_DEBUG("Received _NET_REQUEST_FRAME_EXTENTS for "
+				  "0x%lx\n",
+				  client->window);
 
 			updateFrameExtents(client);
 
@@ -4697,7 +5422,7 @@ void handleClientMessage(XEvent *event)
 		}
 	}
 
-	restackFloatingWindows();
+	restackClients();
 }
 
 void toggleFullscreen(const char *arg)
@@ -4718,7 +5443,8 @@ void updateSizeHints(SClient *client)
 
 	client->sizeHints.valid = 0;
 
-	if (!XGetWMNormalHints(display, client->window, &hints, &supplied)) {
+	if (!backend->getWMNormalHints(display, client->window, &hints,
+				       &supplied)) {
 		return;
 	}
 
@@ -4748,12 +5474,11 @@ void updateSizeHints(SClient *client)
 
 	client->sizeHints.valid = 1;
 
-	fprintf(stderr,
-		"Size hints for 0x%lx: min=%dx%d, max=%dx%d, base=%dx%d\n",
-		client->window, client->sizeHints.minWidth,
-		client->sizeHints.minHeight, client->sizeHints.maxWidth,
-		client->sizeHints.maxHeight, client->sizeHints.baseWidth,
-		client->sizeHints.baseHeight);
+	LOG_DEBUG("Size hints for 0x%lx: min=%dx%d, max=%dx%d, base=%dx%d\n",
+		  client->window, client->sizeHints.minWidth,
+		  client->sizeHints.minHeight, client->sizeHints.maxWidth,
+		  client->sizeHints.maxHeight, client->sizeHints.baseWidth,
+		  client->sizeHints.baseHeight);
 }
 
 void getWindowClass(Window window, char *className, char *instanceName,
@@ -4764,7 +5489,7 @@ void getWindowClass(Window window, char *className, char *instanceName,
 	className[0]	= '\0';
 	instanceName[0] = '\0';
 
-	if (XGetClassHint(display, window, &classHint)) {
+	if (backend->getClassHint(display, window, &classHint)) {
 		if (classHint.res_class) {
 			strncpy(className, classHint.res_class, bufSize - 1);
 			className[bufSize - 1] = '\0';
@@ -4779,6 +5504,36 @@ void getWindowClass(Window window, char *className, char *instanceName,
 	}
 }
 
+void updateClientTitle(SClient *client)
+{
+	XTextProperty textprop = {0};
+
+	client->title[0] = '\0';
+
+	if (!backend->getTextProperty(display, client->window, &textprop,
+				      NET_WM_NAME) ||
+	    !textprop.value || !textprop.nitems) {
+		if (textprop.value) {
+			XFree(textprop.value);
+			textprop.value = NULL;
+		}
+		if (!backend->getTextProperty(display, client->window,
+					      &textprop, XA_WM_NAME)) {
+			return;
+		}
+	}
+
+	if (textprop.value && textprop.nitems) {
+		strncpy(client->title, (char *)textprop.value,
+			sizeof(client->title) - 1);
+		client->title[sizeof(client->title) - 1] = '\0';
+	}
+
+	if (textprop.value) {
+		XFree(textprop.value);
+	}
+}
+
 int applyRules(SClient *client)
 {
 	char className[256]    = {0};
@@ -4787,10 +5542,11 @@ int applyRules(SClient *client)
 	getWindowClass(client->window, className, instanceName,
 		       sizeof(className));
 
-	XTextProperty textprop;
+	XTextProperty textprop	  = {0};
 	char	     *windowTitle = NULL;
-	if (XGetWMName(display, client->window, &textprop) && textprop.value &&
-	    textprop.nitems) {
+	if (backend->getTextProperty(display, client->window, &textprop,
+				     XA_WM_NAME) &&
+	    textprop.value && textprop.nitems) {
 		windowTitle = (char *)textprop.value;
 	}
 
@@ -4843,18 +5599,16 @@ int applyRules(SClient *client)
 
 		if (rule->swallowing != -1) {
 			client->isSwallowing = rule->swallowing;
-			fprintf(stderr,
-				"Setting isSwallowing=%d for window 0x%lx "
-				"(rule matched)\n",
-				client->isSwallowing, client->window);
+			LOG_DEBUG("Setting isSwallowing=%d for window 0x%lx "
+				  "(rule matched)\n",
+				  client->isSwallowing, client->window);
 		}
 
 		if (rule->noswallow != -1) {
 			client->noswallow = rule->noswallow;
-			fprintf(stderr,
-				"Setting noswallow=%d for window 0x%lx (rule "
-				"matched)\n",
-				client->noswallow, client->window);
+			LOG_DEBUG("Setting noswallow=%d for window 0x%lx (rule "
+				  "matched)\n",
+				  client->noswallow, client->window);
 		}
 
 		if (sizeChanged && client->isFloating) {
@@ -4866,11 +5620,10 @@ int applyRules(SClient *client)
 			}
 		}
 
-		fprintf(stderr,
-			"Applied rule for window class=%s instance=%s "
-			"title=%s\n",
-			className, instanceName,
-			windowTitle ? windowTitle : "(null)");
+		LOG_DEBUG("Applied rule for window class=%s instance=%s "
+			  "title=%s\n",
+			  className, instanceName,
+			  windowTitle ? windowTitle : "(null)");
 
 		rulesApplied = 1;
 	}
@@ -4908,12 +5661,15 @@ void focusMonitor(const char *arg)
 	}
 
 	SMonitor *monitor = &monitors[targetMonitor];
+	ipcEmitEvent(IPC_EVENT_MONITOR, 0, targetMonitor,
+		     monitor->currentWorkspace, numMonitors);
 
-	int	  centerX = monitor->x + monitor->width / 2;
-	int	  centerY = monitor->y + monitor->height / 2;
+	int centerX = monitor->x + monitor->width / 2;
+	int centerY = monitor->y + monitor->height / 2;
 
 	if (!no_warps) {
-		XWarpPointer(display, None, root, 0, 0, 0, 0, centerX, centerY);
+		backend->warpPointer(display, None, root, 0, 0, 0, 0, centerX,
+				     centerY);
 		lastCursorWarp = 0;
 		gettimeofday(&lastWindowOperation, NULL);
 
@@ -4922,34 +5678,35 @@ void focusMonitor(const char *arg)
 			currentWorkspace = monitor->currentWorkspace;
 			updateBars();
 
-			long currentDesktop = currentWorkspace;
-			XChangeProperty(display, root, NET_CURRENT_DESKTOP,
-					XA_CARDINAL, 32, PropModeReplace,
-					(unsigned char *)&currentDesktop, 1);
-			updateDesktopViewport();
+			invalidateCurrentDesktop(currentWorkspace);
+			invalidateRootProperties(ROOT_DESKTOP_VIEWPORT);
 			return;
 		}
 	} else {
 		forcedMonitor = targetMonitor;
 	}
 
-	SClient *clientToFocus = findVisibleClientInWorkspace(
-	    targetMonitor, monitor->currentWorkspace);
+	SClient *clientToFocus =
+	    recentClient(targetMonitor, monitor->currentWorkspace, 0);
+	if (!clientToFocus) {
+		clientToFocus = findVisibleClientInWorkspace(
+		    targetMonitor, monitor->currentWorkspace);
+	}
 
 	if (clientToFocus) {
 		focusClient(clientToFocus);
 	} else {
 		if (focused) {
 			if (focused->monitor != targetMonitor) {
-				XSetInputFocus(display, root,
-					       RevertToPointerRoot,
-					       CurrentTime);
+				backend->setInputFocus(display, root,
+						       RevertToPointerRoot,
+						       CurrentTime);
 				focused = NULL;
 				updateBorders();
 			}
 		} else {
-			XSetInputFocus(display, root, RevertToPointerRoot,
-				       CurrentTime);
+			backend->setInputFocus(
+			    display, root, RevertToPointerRoot, CurrentTime);
 		}
 	}
 
@@ -4957,10 +5714,8 @@ void focusMonitor(const char *arg)
 
 	updateBars();
 
-	long currentDesktop = currentWorkspace;
-	XChangeProperty(display, root, NET_CURRENT_DESKTOP, XA_CARDINAL, 32,
-			PropModeReplace, (unsigned char *)&currentDesktop, 1);
-	updateDesktopViewport();
+	invalidateCurrentDesktop(currentWorkspace);
+	invalidateRootProperties(ROOT_DESKTOP_VIEWPORT);
 }
 
 void toggleBar(const char *arg)
@@ -4969,8 +5724,8 @@ void toggleBar(const char *arg)
 	SMonitor *currentMonitor = getCurrentMonitor();
 
 	if (hasDocksOnMonitor(currentMonitor->num)) {
-		fprintf(stderr, "Bar toggling disabled - docks are active on "
-				"this monitor\n");
+		LOG_DEBUG("Bar toggling disabled - docks are active on "
+			  "this monitor\n");
 		if (barVisible) {
 			barVisible = 0;
 			showHideBars(0);
@@ -5007,16 +5762,8 @@ void cycleLayouts(const char *arg)
 		monitors[i].currentLayout = newLayout;
 		arrangeClients(&monitors[i]);
 
-		if (newLayout == LAYOUT_MONOCLE) {
-			for (SClient *c = clients; c; c = c->next) {
-				if (c->monitor == i &&
-				    c->workspace ==
-					monitors[i].currentWorkspace &&
-				    c->isFloating && !c->isDock) {
-					XRaiseWindow(display, c->window);
-				}
-			}
-		}
+		ipcEmitEvent(IPC_EVENT_LAYOUT, 0, i,
+			     monitors[i].currentWorkspace, newLayout);
 	}
 
 	updateClientVisibility();
@@ -5053,21 +5800,18 @@ void tileAllMonitors(void)
 				   : LAYOUT_TILED;
 
 	for (int i = 0; i < numMonitors; i++) {
+		ELayout oldLayout = monitors[i].currentLayout;
+
 		for (int ws = 0; ws < workspaceCount; ws++) {
 			monitors[i].workspaceLayouts[ws] = configLayout;
 		}
 		monitors[i].currentLayout = configLayout;
 		arrangeClients(&monitors[i]);
 
-		if (configLayout == LAYOUT_MONOCLE) {
-			for (SClient *c = clients; c; c = c->next) {
-				if (c->monitor == i &&
-				    c->workspace ==
-					monitors[i].currentWorkspace &&
-				    c->isFloating && !c->isDock) {
-					XRaiseWindow(display, c->window);
-				}
-			}
+		if (oldLayout != configLayout) {
+			ipcEmitEvent(IPC_EVENT_LAYOUT, 0, i,
+				     monitors[i].currentWorkspace,
+				     configLayout);
 		}
 	}
 }
@@ -5083,163 +5827,57 @@ int getWindowPID(Window window)
 	static Atom    atom_pid = None;
 	if (atom_pid == None) {
 		atom_pid = XInternAtom(display, "_NET_WM_PID", False);
-		fprintf(stderr, "Initialized _NET_WM_PID atom\n");
+		LOG_DEBUG("Initialized _NET_WM_PID atom\n");
 	}
 
-	fprintf(stderr, "Getting PID for window 0x%lx\n", window);
+	LOG_DEBUG("Getting PID for window 0x%lx\n", window);
 
-	if (XGetWindowProperty(display, window, atom_pid, 0, 1, False,
-			       XA_CARDINAL, &actual_type, &actual_format,
-			       &nitems, &bytes_after, &prop) == Success) {
+	if (backend->getWindowProperty(display, window, atom_pid, 0, 1, False,
+				       XA_CARDINAL, &actual_type,
+				       &actual_format, &nitems, &bytes_after,
+				       &prop) == Success) {
 		if (prop && actual_type == XA_CARDINAL && actual_format == 32 &&
 		    nitems == 1) {
 			pid = *((int *)prop);
-			fprintf(stderr, "Window 0x%lx has PID %d\n", window,
-				pid);
+			LOG_DEBUG("Window 0x%lx has PID %d\n", window, pid);
 		} else {
-			fprintf(stderr,
-				"Window 0x%lx has no PID property (type=%ld, "
-				"format=%d, nitems=%ld)\n",
-				window, actual_type, actual_format, nitems);
+			LOG_DEBUG("Window 0x%lx has no PID property (type=%ld, "
+				  "format=%d, nitems=%ld)\n",
+				  window, actual_type, actual_format, nitems);
 		}
 		if (prop) {
 			XFree(prop);
 		}
 	} else {
-		fprintf(stderr, "Failed to get PID property for window 0x%lx\n",
-			window);
+		LOG_ERROR("Failed to get PID property for window 0x%lx\n",
+			  window);
 	}
 
 	return pid;
 }
 
-int isChildProcess(int parentPid, int childPid)
-{
-	if (parentPid <= 0 || childPid <= 0) {
-		fprintf(stderr,
-			"Invalid PIDs for child process check: parent=%d, "
-			"child=%d\n",
-			parentPid, childPid);
-		return 0;
-	}
-
-	char parentPath[256];
-	char buffer[256];
-
-	snprintf(parentPath, sizeof(parentPath), "/proc/%d/task/%d/children",
-		 parentPid, parentPid);
-	fprintf(stderr,
-		"Checking parent-child relationship: %d -> %d (path: %s)\n",
-		parentPid, childPid, parentPath);
-
-	FILE *f = fopen(parentPath, "r");
-	if (!f) {
-		fprintf(stderr, "Failed to open %s: %s\n", parentPath,
-			strerror(errno));
-		return 0;
-	}
-
-	if (!fgets(buffer, sizeof(buffer), f)) {
-		fprintf(stderr, "No children found for PID %d\n", parentPid);
-		fclose(f);
-		return 0;
-	}
-
-	fprintf(stderr, "Children of PID %d: %s\n", parentPid, buffer);
-
-	char *token = strtok(buffer, " ");
-	while (token) {
-		int pid = atoi(token);
-		if (pid == childPid) {
-			fclose(f);
-			fprintf(stderr,
-				"Found direct child PID match: %d is "
-				"child of %d\n",
-				childPid, parentPid);
-			return 1;
-		}
-		token = strtok(NULL, " ");
-	}
-
-	fseek(f, 0, SEEK_SET);
-	if (!fgets(buffer, sizeof(buffer), f)) {
-		fclose(f);
-		return 0;
-	}
-
-	char *bufferCopy = strdup(buffer);
-	if (!bufferCopy) {
-		fclose(f);
-		return 0;
-	}
-
-	token = strtok(bufferCopy, " ");
-	while (token) {
-		int pid = atoi(token);
-		fclose(f);
-
-		if (pid <= 0 || pid == parentPid) {
-			f = fopen(parentPath, "r");
-			if (!f) {
-				fprintf(stderr, "Failed to reopen %s\n",
-					parentPath);
-				free(bufferCopy);
-				return 0;
-			}
-			token = strtok(NULL, " ");
-			continue;
-		}
-
-		fprintf(stderr,
-			"Checking indirect child relationship through: %d\n",
-			pid);
-		if (isChildProcess(pid, childPid)) {
-			fprintf(stderr,
-				"Found indirect child relationship: %d -> %d "
-				"-> %d\n",
-				parentPid, pid, childPid);
-			free(bufferCopy);
-			return 1;
-		}
-
-		f = fopen(parentPath, "r");
-		if (!f) {
-			fprintf(stderr, "Failed to reopen %s\n", parentPath);
-			free(bufferCopy);
-			return 0;
-		}
-
-		token = strtok(NULL, " ");
-	}
-
-	free(bufferCopy);
-	fclose(f);
-	return 0;
-}
-
 void trySwallowClient(SClient *client)
 {
 	if (!client) {
-		fprintf(stderr, "trySwallowClient: client is NULL\n");
+		LOG_DEBUG("trySwallowClient: client is NULL\n");
 		return;
 	}
 
 	if (client->pid <= 0) {
-		fprintf(stderr, "trySwallowClient: client PID is invalid: %d\n",
-			client->pid);
+		LOG_DEBUG("trySwallowClient: client PID is invalid: %d\n",
+			  client->pid);
 		return;
 	}
 
 	if (client->noswallow) {
-		fprintf(stderr,
-			"Skipping swallow for client 0x%lx - has noswallow "
-			"flag\n",
-			client->window);
+		LOG_DEBUG("Skipping swallow for client 0x%lx - has noswallow "
+			  "flag\n",
+			  client->window);
 		return;
 	}
 
-	fprintf(stderr, "Trying to swallow client 0x%lx with PID %d\n",
-		client->window, client->pid);
+	LOG_DEBUG("Trying to swallow client 0x%lx with PID %d\n",
+		  client->window, client->pid);
 
 	for (SClient *c = clients; c; c = c->next) {
 		if (c == client) {
@@ -5247,40 +5885,36 @@ void trySwallowClient(SClient *client)
 		}
 
 		if (c->swallowed) {
-			fprintf(stderr,
-				"Skipping client 0x%lx - already swallowing "
-				"another window\n",
-				c->window);
+			LOG_DEBUG("Skipping client 0x%lx - already swallowing "
+				  "another window\n",
+				  c->window);
 			continue;
 		}
 
 		if (!c->isSwallowing) {
-			fprintf(stderr,
-				"Skipping client 0x%lx - swallowing not "
-				"enabled (isSwallowing=%d)\n",
-				c->window, c->isSwallowing);
+			LOG_DEBUG("Skipping client 0x%lx - swallowing not "
+				  "enabled (isSwallowing=%d)\n",
+				  c->window, c->isSwallowing);
 			continue;
 		}
 
-		fprintf(stderr,
-			"Checking if client 0x%lx (PID %d) can swallow 0x%lx "
-			"(PID %d)\n",
-			c->window, c->pid, client->window, client->pid);
+		LOG_DEBUG("Checking if client 0x%lx (PID %d) can swallow 0x%lx "
+			  "(PID %d)\n",
+			  c->window, c->pid, client->window, client->pid);
 
 		if (c->monitor != client->monitor ||
 		    c->workspace != client->workspace) {
-			fprintf(stderr,
-				"Skipping client 0x%lx - different "
-				"monitor/workspace\n",
-				c->window);
+			LOG_DEBUG("Skipping client 0x%lx - different "
+				  "monitor/workspace\n",
+				  c->window);
 			continue;
 		}
 
 		if (isChildProcess(c->pid, client->pid)) {
-			fprintf(stderr,
-				"Swallowing client 0x%lx (PID %d) by 0x%lx "
-				"(PID %d)\n",
-				client->window, client->pid, c->window, c->pid);
+			LOG_DEBUG("Swallowing client 0x%lx (PID %d) by 0x%lx "
+				  "(PID %d)\n",
+				  client->window, client->pid, c->window,
+				  c->pid);
 
 			int	 wasFloating	= client->isFloating;
 			int	 originalX	= client->x;
@@ -5325,31 +5959,28 @@ void trySwallowClient(SClient *client)
 			int parentHeight     = c->height;
 			int parentIsFloating = c->isFloating;
 
-			fprintf(stderr,
-				"Parent window geometry being inherited: "
-				"%dx%d at %d,%d (floating: %d)\n",
-				parentWidth, parentHeight, parentX, parentY,
-				parentIsFloating);
+			LOG_DEBUG("Parent window geometry being inherited: "
+				  "%dx%d at %d,%d (floating: %d)\n",
+				  parentWidth, parentHeight, parentX, parentY,
+				  parentIsFloating);
 
 			unmapSwallowedClient(c);
 
 			if (wasFloating) {
-				fprintf(stderr,
-					"Child was already floating, "
-					"preserving geometry: "
-					"%dx%d at %d,%d\n",
-					originalWidth, originalHeight,
-					originalX, originalY);
+				LOG_DEBUG("Child was already floating, "
+					  "preserving geometry: "
+					  "%dx%d at %d,%d\n",
+					  originalWidth, originalHeight,
+					  originalX, originalY);
 				client->x      = originalX;
 				client->y      = originalY;
 				client->width  = originalWidth;
 				client->height = originalHeight;
 			} else {
-				fprintf(stderr,
-					"Child inheriting parent geometry: "
-					"%dx%d at %d,%d (floating: %d)\n",
-					parentWidth, parentHeight, parentX,
-					parentY, parentIsFloating);
+				LOG_DEBUG("Child inheriting parent geometry: "
+					  "%dx%d at %d,%d (floating: %d)\n",
+					  parentWidth, parentHeight, parentX,
+					  parentY, parentIsFloating);
 				client->isFloating = parentIsFloating;
 				client->x	   = parentX;
 				client->y	   = parentY;
@@ -5366,31 +5997,30 @@ void trySwallowClient(SClient *client)
 					    GrabModeAsync, GrabModeAsync, None,
 					    resizeSECursor);
 
-				XMoveResizeWindow(display, client->window,
-						  client->x, client->y,
-						  client->width,
-						  client->height);
+				backend->moveResizeWindow(
+				    display, client->window, client->x,
+				    client->y, client->width, client->height);
 
-				fprintf(stderr, "Applying resize for swallowed "
-						"window\n");
+				LOG_DEBUG("Applying resize for swallowed "
+					  "window\n");
 				int tempWidth  = client->width - 1;
 				int tempHeight = client->height - 1;
 
-				XResizeWindow(display, client->window,
-					      tempWidth, tempHeight);
-				XSync(display, False);
+				backend->resizeWindow(display, client->window,
+						      tempWidth, tempHeight);
+				backend->sync(display, False);
 
-				XResizeWindow(display, client->window,
-					      client->width, client->height);
-				XSync(display, False);
+				backend->resizeWindow(display, client->window,
+						      client->width,
+						      client->height);
+				backend->sync(display, False);
 
-				XRaiseWindow(display, client->window);
+				raiseClient(client);
 
-				fprintf(stderr,
-					"Applied floating geometry to child: "
-					"%dx%d at %d,%d\n",
-					client->width, client->height,
-					client->x, client->y);
+				LOG_DEBUG("Applied floating geometry to child: "
+					  "%dx%d at %d,%d\n",
+					  client->width, client->height,
+					  client->x, client->y);
 			}
 
 			configureClient(client);
@@ -5399,8 +6029,8 @@ void trySwallowClient(SClient *client)
 			focusClient(client);
 			break;
 		} else {
-			fprintf(stderr, "Not a child process: %d -> %d\n",
-				c->pid, client->pid);
+			LOG_DEBUG("Not a child process: %d -> %d\n", c->pid,
+				  client->pid);
 		}
 	}
 }
@@ -5411,8 +6041,8 @@ void unmapSwallowedClient(SClient *swallowed)
 		return;
 	}
 
-	fprintf(stderr, "Moving swallowed client 0x%lx to hidden workspace\n",
-		swallowed->window);
+	LOG_DEBUG("Moving swallowed client 0x%lx to hidden workspace\n",
+		  swallowed->window);
 
 	swallowed->oldWorkspace = swallowed->workspace;
 
@@ -5433,9 +6063,9 @@ void remapSwallowedClient(SClient *client)
 	}
 
 	SClient *parent = client->swallowedBy;
-	fprintf(stderr,
-		"Restoring previously swallowed client 0x%lx to workspace %d\n",
-		parent->window, parent->oldWorkspace);
+	LOG_DEBUG("Restoring previously swallowed client 0x%lx to workspace "
+		  "%d\n",
+		  parent->window, parent->oldWorkspace);
 
 	parent->swallowed   = NULL;
 	client->swallowedBy = NULL;
@@ -5444,19 +6074,18 @@ void remapSwallowedClient(SClient *client)
 	updateClientDesktop(parent);
 
 	XWindowAttributes wa;
-	if (XGetWindowAttributes(display, parent->window, &wa)) {
+	if (backend->getWindowAttributes(display, parent->window, &wa)) {
 		if (parent->workspace ==
 		    monitors[parent->monitor].currentWorkspace) {
-			XMapWindow(display, parent->window);
-			XSync(display, False);
+			backend->mapWindow(display, parent->window);
+			backend->sync(display, False);
 			focusClient(parent);
-			XRaiseWindow(display, parent->window);
+			raiseClient(parent);
 		}
 	} else {
-		fprintf(stderr,
-			"Parent window 0x%lx no longer exists, skipping "
-			"focus\n",
-			parent->window);
+		LOG_DEBUG("Parent window 0x%lx no longer exists, skipping "
+			  "focus\n",
+			  parent->window);
 	}
 
 	arrangeClients(&monitors[parent->monitor]);
@@ -5465,52 +6094,33 @@ void remapSwallowedClient(SClient *client)
 
 void handleScreenChange(XEvent *event)
 {
-	fprintf(stderr, "Screen configuration changed, updating monitors\n");
-
 	XRRUpdateConfiguration(event);
 
+	int previousCount = numMonitors;
 	updateMonitors();
 
-	if (barWindows) {
-		for (int i = 0; i < numMonitors; i++) {
-			if (barWindows[i] != 0) {
-				XDestroyWindow(display, barWindows[i]);
-				barWindows[i] = 0;
-			}
-		}
-		free(barWindows);
-		barWindows = NULL;
+	if (!monitorsChanged) {
+		LOG_DEBUG("Screen change left the monitors as they were\n");
+		return;
 	}
 
-	createBars();
-	updateStatus();
-
-	for (SClient *c = clients; c; c = c->next) {
-		if (c->monitor >= numMonitors) {
-			c->monitor = 0;
-		}
-
-		SMonitor *mon = &monitors[c->monitor];
-		if (c->x < mon->x || c->x >= mon->x + mon->width ||
-		    c->y < mon->y || c->y >= mon->y + mon->height) {
-			c->x = mon->x + (mon->width - c->width) / 2;
-			c->y = mon->y + (mon->height - c->height) / 2;
-			if (c->y < mon->y + barHeight) {
-				c->y = mon->y + barHeight;
-			}
-			XMoveWindow(display, c->window, c->x, c->y);
-		}
-	}
+	LOG_INFO("Screen configuration changed, %d monitors\n", numMonitors);
 
+	updateBarMonitors(monitorPrevious, monitorChanged, previousCount);
 	updateClientPositionsForBar();
 
 	for (int i = 0; i < numMonitors; i++) {
-		arrangeClients(&monitors[i]);
+		if (monitorChanged[i]) {
+			arrangeClients(&monitors[i]);
+		}
 	}
 
 	updateClientVisibility();
 	updateBars();
-	updateDesktopViewport();
+
+	SMonitor *monitor = getCurrentMonitor();
+	ipcEmitEvent(IPC_EVENT_MONITOR, 0, monitor->num,
+		     monitor->currentWorkspace, numMonitors);
 }
 
 int getDockHeight(int monitorNum, int workspace)
@@ -5524,17 +6134,16 @@ int getDockHeight(int monitorNum, int workspace)
 			    c->y < m->y + m->height &&
 			    c->y + c->height > m->y) {
 				dockHeight += c->height;
-				fprintf(stderr,
-					"Found dock %lx overlapping monitor "
-					"%d, height %d, total now %d\n",
-					c->window, monitorNum, c->height,
-					dockHeight);
+				LOG_DEBUG("Found dock %lx overlapping monitor "
+					  "%d, height %d, total now %d\n",
+					  c->window, monitorNum, c->height,
+					  dockHeight);
 			}
 		}
 	}
 
-	fprintf(stderr, "Total dock height for monitor %d workspace %d: %d\n",
-		monitorNum, workspace, dockHeight);
+	LOG_DEBUG("Total dock height for monitor %d workspace %d: %d\n",
+		  monitorNum, workspace, dockHeight);
 	return dockHeight;
 }
 
@@ -5566,43 +6175,6 @@ int getDockPosition(int monitorNum)
 	return 0;
 }
 
-void updateDesktopViewport()
-{
-	if (!monitors || numMonitors <= 0 || workspaceCount <= 0) {
-		fprintf(stderr, "Cannot update desktop viewport: no monitors "
-				"or invalid workspace count\n");
-		return;
-	}
-
-	long data[workspaceCount * 2];
-	int  idx = 0;
-
-	for (int ws = 0; ws < workspaceCount; ws++) {
-		int monitorFound = 0;
-
-		for (int m = 0; m < numMonitors; m++) {
-			if (monitors[m].currentWorkspace == ws) {
-				data[idx++]  = monitors[m].x;
-				data[idx++]  = monitors[m].y;
-				monitorFound = 1;
-				break;
-			}
-		}
-
-		if (!monitorFound) {
-			data[idx++] = monitors[0].x;
-			data[idx++] = monitors[0].y;
-		}
-	}
-
-	XChangeProperty(display, root, NET_DESKTOP_VIEWPORT, XA_CARDINAL, 32,
-			PropModeReplace, (unsigned char *)data, idx);
-
-	fprintf(stderr,
-		"Updated desktop viewport information for %d workspaces\n",
-		workspaceCount);
-}
-
 void updateClientDesktop(SClient *client)
 {
 	if (!client) {
@@ -5615,11 +6187,12 @@ void updateClientDesktop(SClient *client)
 		desktop = 0;
 	}
 
-	XChangeProperty(display, client->window, NET_WM_DESKTOP, XA_CARDINAL,
-			32, PropModeReplace, (unsigned char *)&desktop, 1);
+	backend->changeProperty(display, client->window, NET_WM_DESKTOP,
+				XA_CARDINAL, 32, PropModeReplace,
+				(unsigned char *)&desktop, 1);
 
-	fprintf(stderr, "Updated NET_WM_DESKTOP to %ld for window 0x%lx\n",
-		desktop, client->window);
+	LOG_DEBUG("Updated NET_WM_DESKTOP to %ld for window 0x%lx\n", desktop,
+		  client->window);
 }
 
 void updateClientAllowedActions(SClient *client)
@@ -5648,52 +6221,13 @@ void updateClientAllowedActions(SClient *client)
 		}
 	}
 
-	XChangeProperty(display, client->window, NET_WM_ALLOWED_ACTIONS,
-			XA_ATOM, 32, PropModeReplace, (unsigned char *)actions,
-			count);
-
-	fprintf(stderr,
-		"Updated _NET_WM_ALLOWED_ACTIONS for window 0x%lx with %d "
-		"actions\n",
-		client->window, count);
-}
-
-void updateDesktopNames()
-{
-	if (workspaceCount <= 0) {
-		return;
-	}
-
-	char *names[workspaceCount];
-	char  buffer[workspaceCount][32];
-	int   totalSize = 0;
-
-	for (int i = 0; i < workspaceCount; i++) {
-		snprintf(buffer[i], sizeof(buffer[i]), "%d", i + 1);
-		names[i] = buffer[i];
-		totalSize += strlen(names[i]) + 1;
-	}
-
-	char *nameBuffer = malloc(totalSize);
-	if (!nameBuffer) {
-		fprintf(stderr, "Failed to allocate memory for desktop "
-				"names\n");
-		return;
-	}
-
-	char *ptr = nameBuffer;
-	for (int i = 0; i < workspaceCount; i++) {
-		strcpy(ptr, names[i]);
-		ptr += strlen(names[i]) + 1;
-	}
-
-	XChangeProperty(display, root, NET_DESKTOP_NAMES, UTF8_STRING, 8,
-			PropModeReplace, (unsigned char *)nameBuffer,
-			totalSize);
+	backend->changeProperty(display, client->window, NET_WM_ALLOWED_ACTIONS,
+				XA_ATOM, 32, PropModeReplace,
+				(unsigned char *)actions, count);
 
-	free(nameBuffer);
-	fprintf(stderr, "Updated _NET_DESKTOP_NAMES with %d workspaces\n",
-		workspaceCount);
+	LOG_DEBUG("Updated _NET_WM_ALLOWED_ACTIONS for window 0x%lx with %d "
+		  "actions\n",
+		  client->window, count);
 }
 
 void updateClientUrgency(SClient *client)
@@ -5710,9 +6244,10 @@ void updateClientUrgency(SClient *client)
 	unsigned long  nitems, bytes_after;
 	unsigned char *data = NULL;
 
-	if (XGetWindowProperty(display, client->window, NET_WM_STATE, 0, 1024,
-			       False, XA_ATOM, &actual_type, &actual_format,
-			       &nitems, &bytes_after, &data) == Success &&
+	if (backend->getWindowProperty(display, client->window, NET_WM_STATE, 0,
+				       1024, False, XA_ATOM, &actual_type,
+				       &actual_format, &nitems, &bytes_after,
+				       &data) == Success &&
 	    data) {
 		if (actual_type == XA_ATOM && actual_format == 32) {
 			Atom *states = (Atom *)data;
@@ -5730,31 +6265,30 @@ void updateClientUrgency(SClient *client)
 		atoms[count++] = NET_WM_STATE_DEMANDS_ATTENTION;
 	}
 
-	XChangeProperty(display, client->window, NET_WM_STATE, XA_ATOM, 32,
-			PropModeReplace, (unsigned char *)atoms, count);
+	backend->changeProperty(display, client->window, NET_WM_STATE, XA_ATOM,
+				32, PropModeReplace, (unsigned char *)atoms,
+				count);
 
-	XWMHints *wmh = XGetWMHints(display, client->window);
+	XWMHints *wmh = backend->getWMHints(display, client->window);
 	if (wmh) {
 		if (client->isUrgent) {
 			wmh->flags |= XUrgencyHint;
 		} else {
 			wmh->flags &= ~XUrgencyHint;
 		}
-		XSetWMHints(display, client->window, wmh);
+		backend->setWMHints(display, client->window, wmh);
 		XFree(wmh);
 	} else if (client->isUrgent) {
 		wmh = XAllocWMHints();
 		if (wmh) {
 			wmh->flags = XUrgencyHint;
-			XSetWMHints(display, client->window, wmh);
+			backend->setWMHints(display, client->window, wmh);
 			XFree(wmh);
 		}
 	}
 
-	fprintf(stderr, "Updated urgency state for window 0x%lx: urgent=%d\n",
-		client->window, client->isUrgent);
-
-	updateClientListStacking();
+	LOG_DEBUG("Updated urgency state for window 0x%lx: urgent=%d\n",
+		  client->window, client->isUrgent);
 }
 
 void updateFrameExtents(SClient *client)
@@ -5772,13 +6306,14 @@ void updateFrameExtents(SClient *client)
 
 	long extents[4] = {border, border, border, border};
 
-	fprintf(stderr,
-		"Setting _NET_FRAME_EXTENTS for window 0x%lx: "
-		"%ld,%ld,%ld,%ld\n",
-		client->window, extents[0], extents[1], extents[2], extents[3]);
+	LOG_DEBUG("Setting _NET_FRAME_EXTENTS for window 0x%lx: "
+		  "%ld,%ld,%ld,%ld\n",
+		  client->window, extents[0], extents[1], extents[2],
+		  extents[3]);
 
-	XChangeProperty(display, client->window, NET_FRAME_EXTENTS, XA_CARDINAL,
-			32, PropModeReplace, (unsigned char *)extents, 4);
+	backend->changeProperty(display, client->window, NET_FRAME_EXTENTS,
+				XA_CARDINAL, 32, PropModeReplace,
+				(unsigned char *)extents, 4);
 }
 
 void resizeWindowKeyboard(const char *arg)
@@ -5864,15 +6399,15 @@ void resizeWindowKeyboard(const char *arg)
 		}
 	}
 
-	XMoveResizeWindow(display, focused->window, newX, newY, newWidth,
-			  newHeight);
+	backend->moveResizeWindow(display, focused->window, newX, newY,
+				  newWidth, newHeight);
 
 	focused->x	= newX;
 	focused->y	= newY;
 	focused->width	= newWidth;
 	focused->height = newHeight;
 
-	XRaiseWindow(display, focused->window);
+	raiseClient(focused);
 	configureClient(focused);
 
 	if (!no_warps) {
@@ -5903,21 +6438,156 @@ int main(int argc, char *argv[])
 				return 1;
 			}
 			return 0;
+		} else if (strcmp(argv[1], "run") == 0 && argc > 2) {
+			char   command[IPC_MAX_PAYLOAD] = "";
+			size_t length			= 0;
+
+			for (int i = 2; i < argc; i++) {
+				length += snprintf(command + length,
+						   sizeof(command) - length,
+						   "%s%s", i > 2 ? " " : "",
+						   argv[i]);
+				if (length >= sizeof(command)) {
+					fprintf(stderr, "banana: command too "
+							"long\n");
+					return 1;
+				}
+			}
+
+			return ipcSendCommand(IPC_COMMAND_RUN, command) == 0
+				   ? 0
+				   : 1;
+		} else if (strcmp(argv[1], "get_tree") == 0) {
+			return ipcQuery(IPC_COMMAND_GET_TREE) == 0 ? 0 : 1;
+		} else if (strcmp(argv[1], "get_workspaces") == 0) {
+			return ipcQuery(IPC_COMMAND_GET_WORKSPACES) == 0 ? 0
+									 : 1;
+		} else if (strcmp(argv[1], "get_clients") == 0) {
+			return ipcQuery(IPC_COMMAND_GET_CLIENTS) == 0 ? 0 : 1;
+		} else if (strcmp(argv[1], "stats") == 0) {
+			if (argc > 2 && strcmp(argv[2], "reset") == 0) {
+				return ipcSendCommand(IPC_COMMAND_RESET_STATS,
+						      NULL) == 0
+					   ? 0
+					   : 1;
+			}
+			return ipcQuery(IPC_COMMAND_GET_STATS) == 0 ? 0 : 1;
+		} else if (strcmp(argv[1], "trace") == 0 && argc > 2) {
+			if (strcmp(argv[2], "start") == 0) {
+				return ipcSendCommand(IPC_COMMAND_START_TRACE,
+						      NULL) == 0
+					   ? 0
+					   : 1;
+			} else if (strcmp(argv[2], "stop") == 0) {
+				return ipcSendCommand(IPC_COMMAND_STOP_TRACE,
+						      NULL) == 0
+					   ? 0
+					   : 1;
+			} else if (strcmp(argv[2], "dump") == 0) {
+				char path[TRACE_PATH_MAX] = "";
+				char cwd[TRACE_PATH_MAX];
+
+				if (argc > 3 && argv[3][0] == '/') {
+					snprintf(path, sizeof(path), "%s",
+						 argv[3]);
+				} else if (argc > 3 &&
+					   getcwd(cwd, sizeof(cwd))) {
+					snprintf(path, sizeof(path), "%s/%s",
+						 cwd, argv[3]);
+				}
+
+				return ipcSendCommand(IPC_COMMAND_DUMP_TRACE,
+						      path) == 0
+					   ? 0
+					   : 1;
+			}
+			fprintf(stderr, "Usage: banana trace "
+					"[start|stop|dump [file]]\n");
+			return 1;
+		} else if (strcmp(argv[1], "record") == 0 && argc > 2) {
+			if (strcmp(argv[2], "stop") == 0) {
+				return ipcSendCommand(IPC_COMMAND_STOP_RECORD,
+						      NULL) == 0
+					   ? 0
+					   : 1;
+			}
+
+			char path[RECORD_PATH_MAX];
+			char cwd[RECORD_PATH_MAX];
+			if (argv[2][0] == '/' || !getcwd(cwd, sizeof(cwd))) {
+				snprintf(path, sizeof(path), "%s", argv[2]);
+			} else {
+				snprintf(path, sizeof(path), "%s/%s", cwd,
+					 argv[2]);
+			}
+
+			return ipcSendCommand(IPC_COMMAND_START_RECORD, path) ==
+				       0
+				   ? 0
+				   : 1;
+		} else if (strcmp(argv[1], "replay") == 0 && argc > 2) {
+			initLog();
+			setup();
+
+			int result = replayFile(argv[2]);
+
+			cleanup();
+			return result == 0 ? 0 : 1;
+		} else if (strcmp(argv[1], "subscribe") == 0) {
+			char   events[256] = "";
+			size_t length	   = 0;
+
+			for (int i = 2; i < argc; i++) {
+				length += snprintf(events + length,
+						   sizeof(events) - length,
+						   "%s%s", i > 2 ? " " : "",
+						   argv[i]);
+				if (length >= sizeof(events)) {
+					fprintf(stderr, "banana: too many "
+							"events\n");
+					return 1;
+				}
+			}
+
+			return ipcSubscribe(events) == 0 ? 0 : 1;
+		} else if (strcmp(argv[1], "batch") == 0) {
+			static char commands[IPC_MAX_PAYLOAD + 1];
+			size_t	    length =
+			    fread(commands, 1, IPC_MAX_PAYLOAD + 1, stdin);
+
+			if (length > IPC_MAX_PAYLOAD) {
+				fprintf(stderr, "banana: batch too large\n");
+				return 1;
+			}
+			commands[length] = '\0';
+
+			return ipcSendCommand(IPC_COMMAND_BATCH, commands) == 0
+				   ? 0
+				   : 1;
 		} else {
 			fprintf(stderr, "banana: unknown command '%s'\n",
 				argv[1]);
-			fprintf(stderr, "Usage: banana [validate|reload]\n");
+			fprintf(stderr, "Usage: banana "
+					"[validate|reload|run <action> "
+					"[argument]|batch|subscribe "
+					"[events...]|get_tree|get_workspaces|"
+					"get_clients|stats [reset]|trace "
+					"<start|stop|dump [file]>|record "
+					"<file|stop>|replay <file>]\n");
 			return 1;
 		}
 	}
 
 	signal(SIGCHLD, SIG_IGN);
 
+	initLog();
+	initRestart(argv[0]);
 	setup();
-	scanExistingWindows();
-	updateClientList();
 
-	runAutostart();
+	if (!restoredState) {
+		runAutostart();
+	}
+	refreshPools();
 
 	run();
 
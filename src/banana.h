@@ -1,6 +1,7 @@
 #ifndef BANANA_H
 #define BANANA_H
 
+#include <stdint.h>
 #include <X11/Xlib.h>
 #include <X11/Xutil.h>
 #include <X11/Xatom.h>
@@ -20,7 +21,10 @@
 
 #define MAX_CLIENTS    64
 #define MAX_MONITORS   16
+#define MAX_WORKSPACES 9
 #define DOCK_WORKSPACE -1
+#define CLASS_MAX      64
+#define TITLE_MAX      256
 
 typedef enum {
 	LAYOUT_FLOATING,
@@ -28,6 +32,25 @@ typedef enum {
 	LAYOUT_MONOCLE
 } ELayout;
 
+/* bottom to top, the order restackClients keeps the windows in */
+typedef enum {
+	STACK_DOCK,
+	STACK_TILED,
+	STACK_FLOATING,
+	STACK_BAR,
+	STACK_FULLSCREEN,
+	STACK_LAYERS
+} EStackLayer;
+
+/* root window properties flushRootProperties publishes once per batch */
+typedef enum {
+	ROOT_CLIENT_LIST	  = 1 << 0,
+	ROOT_CLIENT_LIST_STACKING = 1 << 1,
+	ROOT_CURRENT_DESKTOP	  = 1 << 2,
+	ROOT_DESKTOP_VIEWPORT	  = 1 << 3,
+	ROOT_DESKTOP_NAMES	  = 1 << 4
+} ERootProperty;
+
 typedef struct {
 	int minWidth, minHeight;
 	int maxWidth, maxHeight;
@@ -55,6 +78,8 @@ typedef struct SClient {
 	int		neverfocus;
 	int		isUrgent;
 	int		oldState;
+	unsigned long	borderPixel;
+	int		isHidden;
 	SSizeHints	sizeHints;
 	struct SClient *next;
 	int		pid;
@@ -62,9 +87,24 @@ typedef struct SClient {
 	int		noswallow;
 	struct SClient *swallowedBy;
 	struct SClient *swallowed;
+	struct SClient *focusPrev;
+	struct SClient *focusNext;
+	int		focusMonitor;
+	int		focusWorkspace;
+	struct SClient *stackNext;
+	XID		syncAlarm;
+	uint64_t	syncValue;
+	uint64_t	syncSent;
+	int		syncState;
+	int		syncWaiting;
+	char		className[CLASS_MAX];
+	char		instanceName[CLASS_MAX];
+	char		title[TITLE_MAX];
 } SClient;
 
 typedef struct SMonitor {
+	/* randr monitor name, or output on servers without randr 1.5 */
+	XID	 id;
 	int	 x, y;
 	int	 width, height;
 	int	 num;
@@ -74,6 +114,8 @@ typedef struct SMonitor {
 	float	*masterFactors;
 	int	 masterCount;
 	Window	*lastTiledClient;
+	/* most recently focused client first, linked through focusNext */
+	SClient *focusHistory[MAX_WORKSPACES];
 } SMonitor;
 
 typedef struct {
@@ -112,6 +154,8 @@ typedef struct {
 void	  setup();
 void	  run();
 void	  cleanup();
+void	  dispatchEvent(XEvent *event);
+int	  getRandrEventBase(void);
 
 void	  handleKeyPress(XEvent *event);
 void	  handleButtonPress(XEvent *event);
@@ -148,18 +192,28 @@ void	  swapWindowUnderCursor(SClient *client, int cursorX, int cursorY);
 void	  grabKeys();
 void	  updateFocus();
 void	  focusClient(SClient *client);
+void	  setupClientWindow(SClient *client);
 void	  manageClient(Window window);
 void	  unmanageClient(Window window);
 void	  configureClient(SClient *client);
+void	  allocBorderColors(void);
 void	  updateBorders();
 void	  moveWindow(SClient *client, int x, int y);
 void	  resizeWindow(SClient *client, int width, int height);
 void	  updateClientVisibility();
-void	  updateClientList();
-void	  updateDesktopViewport();
-void	  restackFloatingWindows();
+void	  revealHiddenClients(void);
+void	  invalidateRootProperties(unsigned int properties);
+void	  invalidateCurrentDesktop(int workspace);
+void	  flushRootProperties(void);
+void	  clientListAdd(Window window);
+int	  applyPendingDrag(void);
+void	  restackClients();
+void	  attachStack(SClient *client);
+void	  raiseClient(SClient *client);
+void	  lowerClient(SClient *client);
 void	  warpPointerToClientCenter(SClient *client);
 SClient	 *findVisibleClientInWorkspace(int monitor, int workspace);
+SClient	 *recentClient(int monitor, int workspace, int tiled);
 SMonitor *getCurrentMonitor();
 Atom	  getAtomProperty(SClient *client, Atom prop);
 void	  setClientState(SClient *client, long state);
@@ -169,7 +223,6 @@ void	  updateWindowType(SClient *client);
 void	  updateWMHints(SClient *client);
 void	  updateSizeHints(SClient *client);
 int	  getWindowPID(Window window);
-int	  isChildProcess(int parentPid, int childPid);
 void	  trySwallowClient(SClient *client);
 void	  unmapSwallowedClient(SClient *swallowed);
 void	  remapSwallowedClient(SClient *client);
@@ -178,6 +231,8 @@ int	 *getStrut(Window window);
 void	  tileClients(SMonitor *monitor);
 void	  monocleClients(SMonitor *monitor);
 void	  arrangeClients(SMonitor *monitor);
+void	  beginUpdateBatch(void);
+void	  endUpdateBatch(void);
 void	  swapClients(SClient *a, SClient *b);
 void	  tileAllMonitors(void);
 void	  updateMasterFactorsForAllMonitors(void);
@@ -192,6 +247,7 @@ SMonitor *monitorAtPoint(int x, int y);
 void	  updateMonitors();
 void	  getWindowClass(Window window, char *className, char *instanceName,
 			 size_t bufSize);
+void	  updateClientTitle(SClient *client);
 int	  applyRules(SClient *client);
 
 extern Display	      *display;
@@ -204,6 +260,8 @@ extern SWindowMovement windowMovement;
 extern SWindowResize   windowResize;
 extern SMFactAdjust    mfactAdjust;
 extern int	       newAsMaster;
+extern int	       updateBatchDepth;
+extern int	       barUpdatePending;
 
 extern Atom	       WM_PROTOCOLS;
 extern Atom	       WM_DELETE_WINDOW;
@@ -247,10 +305,11 @@ extern Atom	       NET_WM_ACTION_CHANGE_DESKTOP;
 extern Atom	       NET_WM_ACTION_MOVE;
 extern Atom	       NET_WM_ACTION_RESIZE;
 
+extern Atom	       NET_WM_SYNC_REQUEST;
+extern Atom	       NET_WM_SYNC_REQUEST_COUNTER;
+
 SClient		      *focusWindowUnderCursor(SMonitor *monitor);
 void		       updateClientDesktop(SClient *client);
-void		       updateClientListStacking(void);
-void		       updateDesktopNames(void);
 void		       updateClientAllowedActions(SClient *client);
 void		       updateClientUrgency(SClient *client);
 void		       cycleFocusBetweenFloatingAndMonocle(const char *arg);
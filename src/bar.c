@@ -11,6 +11,10 @@
 
 #include "bar.h"
 #include "config.h"
+#include "ipc.h"
+#include "log.h"
+#include "stats.h"
+#include "trace.h"
 
 extern int	     getDockHeight(int monitorNum, int workspace);
 extern void	     arrangeClients(SMonitor *monitor);
@@ -18,14 +22,16 @@ extern SMonitor	    *monitors;
 extern int	     numMonitors;
 extern int	     currentWorkspace;
 extern Display	    *display;
-extern Atom	     NET_CURRENT_DESKTOP;
-extern void	     updateDesktopViewport(void);
+extern void	     invalidateRootProperties(unsigned int properties);
+extern void	     invalidateCurrentDesktop(int workspace);
 extern SClient	    *findClient(Window window);
 extern SClient	    *findVisibleClientInWorkspace(int monitor, int workspace);
 extern void	     focusClient(SClient *client);
 extern SClient	    *clients;
 extern Window	     root;
 extern SClient	    *focused;
+extern int	     updateBatchDepth;
+extern int	     barUpdatePending;
 
 static char	    *workspaceNames[9];
 
@@ -145,14 +151,14 @@ static int initFont(void)
 {
 	barFontDesc = pango_font_description_from_string(barFont);
 	if (!barFontDesc) {
-		fprintf(stderr, "Failed to load bar font\n");
+		LOG_ERROR("Failed to load bar font\n");
 		return 0;
 	}
 
 	barPangoContext =
 	    pango_font_map_create_context(pango_cairo_font_map_get_default());
 	if (!barPangoContext) {
-		fprintf(stderr, "Failed to create Pango context\n");
+		LOG_ERROR("Failed to create Pango context\n");
 		pango_font_description_free(barFontDesc);
 		barFontDesc = NULL;
 		return 0;
@@ -259,24 +265,77 @@ void resetBarResources(void)
 	initialized = 0;
 }
 
+static void barGeometry(int monitor, int *x, int *y, int *width)
+{
+	*x     = monitors[monitor].x + barStrutsLeft;
+	*width = monitors[monitor].width - barStrutsLeft - barStrutsRight;
+
+	if (bottomBar) {
+		*y = monitors[monitor].y + monitors[monitor].height -
+		     barHeight - barStrutsTop;
+	} else {
+		*y = monitors[monitor].y + barStrutsTop;
+	}
+}
+
+static void createBar(int monitor)
+{
+	XSetWindowAttributes wa;
+	wa.override_redirect = True;
+	wa.background_pixel  = barBgColor;
+	wa.border_pixel	     = barBorderPixel;
+	wa.event_mask	     = ExposureMask | ButtonPressMask;
+
+	int barX, barY, barWidth;
+	barGeometry(monitor, &barX, &barY, &barWidth);
+
+	barWindows[monitor] = XCreateWindow(
+	    display, root, barX, barY, barWidth, barHeight, barBorderWidth,
+	    DefaultDepth(display, DefaultScreen(display)), CopyFromParent,
+	    DefaultVisual(display, DefaultScreen(display)),
+	    CWOverrideRedirect | CWBackPixel | CWBorderPixel | CWEventMask,
+	    &wa);
+
+	barSurfaces[monitor] = cairo_xlib_surface_create(
+	    display, barWindows[monitor],
+	    DefaultVisual(display, DefaultScreen(display)), barWidth,
+	    barHeight);
+	barCairos[monitor] = cairo_create(barSurfaces[monitor]);
+
+	barLayouts[monitor] = pango_cairo_create_layout(barCairos[monitor]);
+	pango_layout_set_font_description(barLayouts[monitor], barFontDesc);
+
+	if (barVisible) {
+		extern int hasDocks(void);
+		if (!hasDocks()) {
+			XMapWindow(display, barWindows[monitor]);
+		}
+	}
+}
+
+static void destroyBar(int monitor)
+{
+	XDestroyWindow(display, barWindows[monitor]);
+
+	if (barLayouts && barLayouts[monitor]) {
+		g_object_unref(barLayouts[monitor]);
+	}
+
+	if (barCairos && barCairos[monitor]) {
+		cairo_destroy(barCairos[monitor]);
+	}
+
+	if (barSurfaces && barSurfaces[monitor]) {
+		cairo_surface_destroy(barSurfaces[monitor]);
+	}
+}
+
 void createBars(void)
 {
 	if (barWindows) {
 		for (int i = 0; i < numMonitors; i++) {
 			if (barWindows[i] != 0) {
-				XDestroyWindow(display, barWindows[i]);
-
-				if (barLayouts && barLayouts[i]) {
-					g_object_unref(barLayouts[i]);
-				}
-
-				if (barCairos && barCairos[i]) {
-					cairo_destroy(barCairos[i]);
-				}
-
-				if (barSurfaces && barSurfaces[i]) {
-					cairo_surface_destroy(barSurfaces[i]);
-				}
+				destroyBar(i);
 			}
 		}
 		free(barWindows);
@@ -291,7 +350,7 @@ void createBars(void)
 	barSurfaces = calloc(numMonitors, sizeof(cairo_surface_t *));
 
 	if (!barWindows || !barLayouts || !barCairos || !barSurfaces) {
-		fprintf(stderr, "Failed to allocate memory for bars\n");
+		LOG_ERROR("Failed to allocate memory for bars\n");
 		return;
 	}
 
@@ -317,53 +376,85 @@ void createBars(void)
 		initialized = 1;
 	}
 
-	XSetWindowAttributes wa;
-	wa.override_redirect = True;
-	wa.background_pixel  = barBgColor;
-	wa.border_pixel	     = barBorderPixel;
-	wa.event_mask	     = ExposureMask | ButtonPressMask;
+	for (int i = 0; i < numMonitors; i++) {
+		createBar(i);
+	}
+
+	updateBars();
+}
+
+/*
+ * keeps the bar of every monitor that survived a screen change, previous[i]
+ * is the index monitor i had before or -1 when it is new
+ */
+void updateBarMonitors(const int *previous, const int *changed,
+		       int previousCount)
+{
+	if (!barWindows || !initialized) {
+		createBars();
+		return;
+	}
+
+	Window		 *windows = calloc(numMonitors, sizeof(Window));
+	PangoLayout	**layouts = calloc(numMonitors, sizeof(PangoLayout *));
+	cairo_t		**cairos  = calloc(numMonitors, sizeof(cairo_t *));
+	cairo_surface_t **surfaces =
+	    calloc(numMonitors, sizeof(cairo_surface_t *));
+
+	if (!windows || !layouts || !cairos || !surfaces) {
+		LOG_ERROR("Failed to allocate memory for bars\n");
+		free(windows);
+		free(layouts);
+		free(cairos);
+		free(surfaces);
+		return;
+	}
 
 	for (int i = 0; i < numMonitors; i++) {
-		int barX = monitors[i].x + barStrutsLeft;
-		int barY;
-		int barWidth =
-		    monitors[i].width - barStrutsLeft - barStrutsRight;
+		int j = previous[i];
+		if (j < 0 || j >= previousCount || !barWindows[j]) {
+			continue;
+		}
 
-		if (bottomBar) {
-			barY = monitors[i].y + monitors[i].height - barHeight -
-			       barStrutsTop;
-		} else {
-			barY = monitors[i].y + barStrutsTop;
+		windows[i]     = barWindows[j];
+		layouts[i]     = barLayouts[j];
+		cairos[i]      = barCairos[j];
+		surfaces[i]    = barSurfaces[j];
+		barWindows[j]  = 0;
+		barLayouts[j]  = NULL;
+		barCairos[j]   = NULL;
+		barSurfaces[j] = NULL;
+
+		if (changed[i]) {
+			int barX, barY, barWidth;
+			barGeometry(i, &barX, &barY, &barWidth);
+			XMoveResizeWindow(display, windows[i], barX, barY,
+					  barWidth, barHeight);
+			cairo_xlib_surface_set_size(surfaces[i], barWidth,
+						    barHeight);
 		}
+	}
 
-		barWindows[i] = XCreateWindow(
-		    display, root, barX, barY, barWidth, barHeight,
-		    barBorderWidth,
-		    DefaultDepth(display, DefaultScreen(display)),
-		    CopyFromParent,
-		    DefaultVisual(display, DefaultScreen(display)),
-		    CWOverrideRedirect | CWBackPixel | CWBorderPixel |
-			CWEventMask,
-		    &wa);
-
-		barSurfaces[i] = cairo_xlib_surface_create(
-		    display, barWindows[i],
-		    DefaultVisual(display, DefaultScreen(display)), barWidth,
-		    barHeight);
-		barCairos[i] = cairo_create(barSurfaces[i]);
-
-		barLayouts[i] = pango_cairo_create_layout(barCairos[i]);
-		pango_layout_set_font_description(barLayouts[i], barFontDesc);
-
-		if (barVisible) {
-			extern int hasDocks(void);
-			if (!hasDocks()) {
-				XMapWindow(display, barWindows[i]);
-			}
+	for (int j = 0; j < previousCount; j++) {
+		if (barWindows[j]) {
+			destroyBar(j);
 		}
 	}
 
-	updateBars();
+	free(barWindows);
+	free(barLayouts);
+	free(barCairos);
+	free(barSurfaces);
+	barWindows  = windows;
+	barLayouts  = layouts;
+	barCairos   = cairos;
+	barSurfaces = surfaces;
+
+	for (int i = 0; i < numMonitors; i++) {
+		if (!barWindows[i]) {
+			createBar(i);
+		}
+	}
 }
 
 void updateStatus(void)
@@ -417,10 +508,18 @@ static int workspaceHasClients(int monitor, int workspace)
 
 void updateBars(void)
 {
+	if (updateBatchDepth > 0) {
+		barUpdatePending = 1;
+		return;
+	}
+
 	if (!barWindows || !barVisible) {
 		return;
 	}
 
+	statsCount(STATS_BAR_REDRAWS);
+	uint64_t start = traceBegin();
+
 	for (int i = 0; i < numMonitors; i++) {
 		if (!barWindows[i] || !barCairos[i] || !barLayouts[i]) {
 			continue;
@@ -498,6 +597,8 @@ void updateBars(void)
 
 		cairo_surface_flush(barSurfaces[i]);
 	}
+
+	traceEnd(TRACE_BAR, "bar", numMonitors, start);
 }
 
 void raiseBars(void)
@@ -518,19 +619,7 @@ void cleanupBars(void)
 	if (barWindows) {
 		for (int i = 0; i < numMonitors; i++) {
 			if (barWindows[i]) {
-				XDestroyWindow(display, barWindows[i]);
-
-				if (barLayouts && barLayouts[i]) {
-					g_object_unref(barLayouts[i]);
-				}
-
-				if (barCairos && barCairos[i]) {
-					cairo_destroy(barCairos[i]);
-				}
-
-				if (barSurfaces && barSurfaces[i]) {
-					cairo_surface_destroy(barSurfaces[i]);
-				}
+				destroyBar(i);
 			}
 		}
 		free(barWindows);
@@ -617,13 +706,10 @@ void handleBarClick(XEvent *event)
 
 		if (workspaceChanged) {
 			currentWorkspace = monitors[i].currentWorkspace;
+			ipcEmitEvent(IPC_EVENT_WORKSPACE, 0, i, newWorkspace, 0);
 
-			long currentDesktop = currentWorkspace;
-			XChangeProperty(display, root, NET_CURRENT_DESKTOP,
-					XA_CARDINAL, 32, PropModeReplace,
-					(unsigned char *)&currentDesktop, 1);
-
-			updateDesktopViewport();
+			invalidateCurrentDesktop(currentWorkspace);
+			invalidateRootProperties(ROOT_DESKTOP_VIEWPORT);
 			updateClientVisibility();
 
 			SClient *windowToFocus = NULL;
@@ -16,6 +16,8 @@ extern Window *barWindows;
 extern int     barVisible;
 
 void	       createBars(void);
+void	       updateBarMonitors(const int *previous, const int *changed,
+				 int previousCount);
 void	       updateStatus(void);
 void	       updateBars(void);
 void	       raiseBars(void);
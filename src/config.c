@@ -18,6 +18,9 @@
 #include "banana.h"
 #include "config.h"
 #include "bar.h"
+#include "pool.h"
+#include "log.h"
+#include "restart.h"
 
 extern int	   barVisible;
 
@@ -51,6 +54,10 @@ int		   newAsMaster		    = 0;
 int		   centeredMaster	    = 0;
 char		  *defaultLayout	    = NULL;
 int		   no_warps		    = 0;
+int		   prewarmCount		    = 1;
+EWorkspaceSwitch   workspaceSwitch	    = WORKSPACE_SWITCH_UNMAP;
+EDragMode	   dragMode		    = DRAG_LIVE;
+int		   dragRate		    = 60;
 
 SKeyBinding	  *keys	      = NULL;
 size_t		   keysCount  = 0;
@@ -63,10 +70,14 @@ size_t		   variablesCount = 0;
 SAutostart	  *autostarts	   = NULL;
 size_t		   autostartsCount = 0;
 
+SPrewarm	  *prewarms	 = NULL;
+size_t		   prewarmsCount = 0;
+
 const SFunctionMap functionMap[] = {
     {"spawn", spawnProgram},
     {"kill", killClient},
     {"quit", quit},
+    {"restart", restart},
     {"switch_workspace", switchToWorkspace},
     {"move_to_workspace", moveClientToWorkspace},
     {"toggle_floating", toggleFloating},
@@ -80,6 +91,7 @@ const SFunctionMap functionMap[] = {
     {"toggle_bar", toggleBar},
     {"reload_config", reloadConfig},
     {"cycle_layouts", cycleLayouts},
+    {"log_level", setLogLevel},
     {NULL, NULL}};
 
 const SModifierMap modifierMap[] = {{"alt", Mod1Mask},
@@ -215,6 +227,94 @@ int isValidResizeWindowArg(const char *arg)
 		strcmp(arg, "grow_right") == 0);
 }
 
+int isValidFunctionArg(const char *funcStr, const char *arg, char *errMsg,
+		       size_t size)
+{
+	int argValid = 1;
+
+	if (strcasecmp(funcStr, "switch_workspace") == 0 ||
+	    strcasecmp(funcStr, "move_to_workspace") == 0) {
+		if (!isValidInteger(arg)) {
+			snprintf(errMsg, size,
+				 "Invalid workspace index: '%s' - must "
+				 "be an integer between 0 and 8",
+				 arg);
+			argValid = 0;
+		} else {
+			int value = atoi(arg);
+			if (value < 0 || value > 8) {
+				snprintf(errMsg, size,
+					 "Invalid workspace index: %d "
+					 "- must be between 0 and 8",
+					 value);
+				argValid = 0;
+			}
+		}
+	} else if (strcasecmp(funcStr, "adjust_master") == 0) {
+		if (!isValidAdjustMasterArg(arg)) {
+			snprintf(errMsg, size,
+				 "Invalid adjust_master argument: '%s' "
+				 "- must be 'increase' or 'decrease'",
+				 arg);
+			argValid = 0;
+		}
+	} else if (strcasecmp(funcStr, "move_window") == 0) {
+		if (!isValidMoveWindowArg(arg)) {
+			snprintf(errMsg, size,
+				 "Invalid move_window argument: '%s' - "
+				 "must be 'up', 'down', 'left', or "
+				 "'right'",
+				 arg);
+			argValid = 0;
+		}
+	} else if (strcasecmp(funcStr, "resize_window") == 0) {
+		if (!isValidResizeWindowArg(arg)) {
+			snprintf(errMsg, size,
+				 "Invalid resize_window argument: '%s' "
+				 "- "
+				 "must be 'up', 'down', 'left', "
+				 "'right', 'grow_up', 'grow_down', "
+				 "'grow_left', or 'grow_right'",
+				 arg);
+			argValid = 0;
+		}
+	} else if (strcasecmp(funcStr, "focus_window") == 0) {
+		if (!isValidFocusWindowArg(arg)) {
+			snprintf(errMsg, size,
+				 "Invalid focus_window argument: '%s' "
+				 "- must be 'up' or 'down'",
+				 arg);
+			argValid = 0;
+		}
+	} else if (strcasecmp(funcStr, "cycle_focus") == 0) {
+		if (!isValidCycleFocusArg(arg)) {
+			snprintf(errMsg, size,
+				 "Invalid cycle_focus argument: '%s' "
+				 "- must be 'up' or 'down'",
+				 arg);
+			argValid = 0;
+		}
+	} else if (strcasecmp(funcStr, "focus_monitor") == 0) {
+		if (!isValidFocusMonitorArg(arg)) {
+			snprintf(errMsg, size,
+				 "Invalid focus_monitor argument: '%s' "
+				 "- must be 'left' or 'right'",
+				 arg);
+			argValid = 0;
+		}
+	} else if (strcasecmp(funcStr, "log_level") == 0) {
+		if (parseLogLevel(arg) == -1) {
+			snprintf(errMsg, size,
+				 "Invalid log_level argument: '%s' - must "
+				 "be 'error', 'warn', 'info' or 'debug'",
+				 arg ? arg : "");
+			argValid = 0;
+		}
+	}
+
+	return argValid;
+}
+
 char **tokenizeLine(const char *line, int *tokenCount)
 {
 	if (!line || !line[0]) {
@@ -453,8 +553,8 @@ FILE *openConfigFile(STokenHandlerContext *ctx, char **configPath,
 			addError(ctx->errors,
 				 "HOME environment variable not set", 0, 1);
 		} else {
-			fprintf(stderr, "banana: HOME environment variable not "
-					"set\n");
+			LOG_ERROR("banana: HOME environment variable not "
+				  "set\n");
 		}
 
 		restoreConfigState(oldKeys, oldKeysCount, oldRules,
@@ -471,10 +571,9 @@ FILE *openConfigFile(STokenHandlerContext *ctx, char **configPath,
 					 "default",
 					 0, 0);
 			} else {
-				fprintf(stderr,
-					"banana: config file not found at %s, "
-					"creating default\n",
-					*configPath);
+				LOG_INFO("banana: config file not found at %s, "
+					 "creating default\n",
+					 *configPath);
 				free(*configPath);
 				createDefaultConfig();
 
@@ -489,10 +588,10 @@ FILE *openConfigFile(STokenHandlerContext *ctx, char **configPath,
 
 				fp = fopen(*configPath, "r");
 				if (!fp) {
-					fprintf(stderr,
-						"banana: failed to open config "
-						"file: %s\n",
-						strerror(errno));
+					LOG_ERROR("banana: failed to open "
+						  "config "
+						  "file: %s\n",
+						  strerror(errno));
 					restoreConfigState(oldKeys,
 							   oldKeysCount,
 							   oldRules,
@@ -509,7 +608,7 @@ FILE *openConfigFile(STokenHandlerContext *ctx, char **configPath,
 			if (ctx->mode == TOKEN_HANDLER_VALIDATE) {
 				addError(ctx->errors, errMsg, 0, 1);
 			} else {
-				fprintf(stderr, "banana: %s\n", errMsg);
+				LOG_WARN("banana: %s\n", errMsg);
 			}
 
 			restoreConfigState(oldKeys, oldKeysCount, oldRules,
@@ -633,9 +732,9 @@ int processLine(const char *line, char *section, int *inSection,
 						 0);
 					ctx->hasErrors = 1;
 				} else {
-					fprintf(stderr,
-						"banana: Unknown section: %s\n",
-						sectionName);
+					LOG_WARN("banana: Unknown section: "
+						 "%s\n",
+						 sectionName);
 				}
 			}
 
@@ -858,14 +957,15 @@ int processLine(const char *line, char *section, int *inSection,
 						 0);
 					ctx->hasErrors = 1;
 				} else {
-					fprintf(stderr, "banana: %s\n", errMsg);
+					LOG_WARN("banana: %s\n", errMsg);
 				}
 				freeTokens(tokens, tokenCount);
 				return 0;
 			}
 
 			if (tokens && tokenCount >= 2) {
-				if (strcasecmp(tokens[0], "exec") == 0) {
+				if (strcasecmp(tokens[0], "exec") == 0 ||
+				    strcasecmp(tokens[0], "prewarm") == 0) {
 					char command[MAX_LINE_LENGTH] = "";
 					for (int i = 1; i < tokenCount; i++) {
 						if (i > 1) {
@@ -886,8 +986,14 @@ int processLine(const char *line, char *section, int *inSection,
 							strlen(command));
 					}
 
-					processExecCommand(command, lineNum,
-							   ctx);
+					if (strcasecmp(tokens[0], "exec") ==
+					    0) {
+						processExecCommand(
+						    command, lineNum, ctx);
+					} else {
+						processPrewarmCommand(
+						    command, lineNum, ctx);
+					}
 					freeTokens(tokens, tokenCount);
 					return 1;
 				} else if (strcasecmp(tokens[0],
@@ -1035,8 +1141,7 @@ int processLine(const char *line, char *section, int *inSection,
 			addError(ctx->errors, errMsg, lineNum, 0);
 			ctx->hasErrors = 1;
 		} else {
-			fprintf(stderr, "banana: line %d: %s\n", lineNum,
-				errMsg);
+			LOG_WARN("banana: line %d: %s\n", lineNum, errMsg);
 		}
 
 		freeTokens(tokens, tokenCount);
@@ -1083,8 +1188,8 @@ int processLine(const char *line, char *section, int *inSection,
 				addError(ctx->errors, errMsg, lineNum, 0);
 				ctx->hasErrors = 1;
 			} else {
-				fprintf(stderr, "banana: line %d: %s\n",
-					lineNum, errMsg);
+				LOG_WARN("banana: line %d: %s\n", lineNum,
+					 errMsg);
 			}
 
 			freeTokens(tokens, tokenCount);
@@ -1119,8 +1224,8 @@ int processLine(const char *line, char *section, int *inSection,
 				addError(ctx->errors, errMsg, lineNum, 0);
 				ctx->hasErrors = 1;
 			} else {
-				fprintf(stderr, "banana: line %d: %s\n",
-					lineNum, errMsg);
+				LOG_WARN("banana: line %d: %s\n", lineNum,
+					 errMsg);
 			}
 
 			freeTokens(tokens, tokenCount);
@@ -1149,7 +1254,7 @@ int processLine(const char *line, char *section, int *inSection,
 			addError(ctx->errors, errMsg, lineNum, 0);
 			ctx->hasErrors = 1;
 		} else {
-			fprintf(stderr, "banana: %s\n", errMsg);
+			LOG_WARN("banana: %s\n", errMsg);
 		}
 	}
 
@@ -1200,10 +1305,9 @@ int finalizeConfigParser(STokenHandlerContext *ctx, SKeyBinding *oldKeys,
 	}
 
 	if (ctx->mode == TOKEN_HANDLER_LOAD) {
-		fprintf(stderr,
-			"banana: loaded %zu key bindings and %zu window "
-			"rules\n",
-			keysCount, rulesCount);
+		LOG_INFO("banana: loaded %zu key bindings and %zu window "
+			 "rules\n",
+			 keysCount, rulesCount);
 		return 1;
 	} else {
 		cleanupConfigData();
@@ -1265,7 +1369,7 @@ void *safeMalloc(size_t size)
 {
 	void *ptr = malloc(size);
 	if (!ptr) {
-		fprintf(stderr, "banana: failed to allocate memory\n");
+		LOG_ERROR("banana: failed to allocate memory\n");
 		exit(1);
 	}
 	return ptr;
@@ -1278,8 +1382,8 @@ char *safeStrdup(const char *s)
 	}
 	char *result = strdup(s);
 	if (!result) {
-		fprintf(stderr, "banana: failed to allocate memory for "
-				"string\n");
+		LOG_ERROR("banana: failed to allocate memory for "
+			  "string\n");
 		exit(1);
 	}
 	return result;
@@ -1289,7 +1393,7 @@ char *getConfigPath(void)
 {
 	const char *home = getenv("HOME");
 	if (!home) {
-		fprintf(stderr, "banana: HOME environment variable not set\n");
+		LOG_ERROR("banana: HOME environment variable not set\n");
 		return NULL;
 	}
 
@@ -1497,10 +1601,9 @@ void createDefaultConfig(void)
 		struct stat st;
 		if (stat(dirPath, &st) == -1) {
 			if (mkdir(dirPath, 0755) == -1) {
-				fprintf(stderr,
-					"banana: failed to create config "
-					"directory: %s\n",
-					strerror(errno));
+				LOG_ERROR("banana: failed to create config "
+					  "directory: %s\n",
+					  strerror(errno));
 				free(dirPath);
 				free(configPath);
 				return;
@@ -1511,8 +1614,8 @@ void createDefaultConfig(void)
 
 	FILE *fp = fopen(configPath, "w");
 	if (!fp) {
-		fprintf(stderr, "banana: failed to create config file: %s\n",
-			strerror(errno));
+		LOG_ERROR("banana: failed to create config file: %s\n",
+			  strerror(errno));
 		free(configPath);
 		return;
 	}
@@ -1529,6 +1632,10 @@ void createDefaultConfig(void)
 	fprintf(fp, "# exec \"picom\"\n");
 	fprintf(fp, "# exec \"dunst\"\n\n");
 
+	fprintf(fp, "# Programs kept started in the background so they open "
+		    "instantly\n");
+	fprintf(fp, "# prewarm \"$terminal\"\n\n");
+
 	fprintf(fp, "# General settings\n");
 	fprintf(fp, "general {\n");
 	fprintf(fp, "    workspace_count 9\n");
@@ -1538,6 +1645,10 @@ void createDefaultConfig(void)
 	fprintf(fp, "    border_width 1\n");
 	fprintf(fp, "    layout master\n");
 	fprintf(fp, "    no_warps false\n");
+	fprintf(fp, "    prewarm_count 1\n");
+	fprintf(fp, "    workspace_switch unmap\n");
+	fprintf(fp, "    drag_mode live\n");
+	fprintf(fp, "    drag_rate 60\n");
 	fprintf(fp, "}\n\n");
 
 	fprintf(fp, "# Bar settings\n");
@@ -1583,6 +1694,7 @@ void createDefaultConfig(void)
 	fprintf(fp, "    $mod escape spawn \"$screenshot\"\n");
 	fprintf(fp, "    $mod c kill\n");
 	fprintf(fp, "    $mod w quit\n");
+	fprintf(fp, "    $mod+shift r restart\n");
 	fprintf(fp, "    $mod space toggle_floating\n");
 	fprintf(fp, "    $mod f toggle_fullscreen\n");
 	fprintf(fp, "    $mod b toggle_bar\n");
@@ -1674,8 +1786,7 @@ void createDefaultConfig(void)
 	fprintf(fp, "}\n");
 
 	fclose(fp);
-	fprintf(stderr, "banana: created default config file at %s\n",
-		configPath);
+	LOG_INFO("banana: created default config file at %s\n", configPath);
 	free(configPath);
 }
 
@@ -1683,7 +1794,7 @@ void reloadConfig(const char *arg)
 {
 	(void)arg;
 
-	fprintf(stderr, "banana: reloading configuration...\n");
+	LOG_INFO("banana: reloading configuration...\n");
 
 	SKeyBinding *oldKeys	   = keys;
 	size_t	     oldKeysCount  = keysCount;
@@ -1692,6 +1803,8 @@ void reloadConfig(const char *arg)
 
 	SAutostart  *oldAutostarts	= autostarts;
 	size_t	     oldAutostartsCount = autostartsCount;
+	SPrewarm    *oldPrewarms	= prewarms;
+	size_t	     oldPrewarmsCount	= prewarmsCount;
 
 	char	    *oldBarFont		     = barFont;
 	char	    *oldActiveBorderColor    = activeBorderColor;
@@ -1724,6 +1837,10 @@ void reloadConfig(const char *arg)
 	int	     oldNoWarps			 = no_warps;
 	int	     oldNewAsMaster		 = newAsMaster;
 	int	     oldCenteredMaster		 = centeredMaster;
+	int	     oldPrewarmCount		 = prewarmCount;
+	int	     oldWorkspaceSwitch		 = workspaceSwitch;
+	int	     oldDragMode		 = dragMode;
+	int	     oldDragRate		 = dragRate;
 
 	keys		     = NULL;
 	keysCount	     = 0;
@@ -1731,6 +1848,8 @@ void reloadConfig(const char *arg)
 	rulesCount	     = 0;
 	autostarts	     = NULL;
 	autostartsCount	     = 0;
+	prewarms	     = NULL;
+	prewarmsCount	     = 0;
 	barFont		     = NULL;
 	activeBorderColor    = NULL;
 	inactiveBorderColor  = NULL;
@@ -1748,8 +1867,8 @@ void reloadConfig(const char *arg)
 	int result = loadConfig();
 
 	if (!result) {
-		fprintf(stderr, "banana: failed to reload configuration, "
-				"restoring old configuration\n");
+		LOG_ERROR("banana: failed to reload configuration, "
+			  "restoring old configuration\n");
 
 		keys			 = oldKeys;
 		keysCount		 = oldKeysCount;
@@ -1757,6 +1876,8 @@ void reloadConfig(const char *arg)
 		rulesCount		 = oldRulesCount;
 		autostarts		 = oldAutostarts;
 		autostartsCount		 = oldAutostartsCount;
+		prewarms		 = oldPrewarms;
+		prewarmsCount		 = oldPrewarmsCount;
 		barFont			 = oldBarFont;
 		activeBorderColor	 = oldActiveBorderColor;
 		inactiveBorderColor	 = oldInactiveBorderColor;
@@ -1787,6 +1908,10 @@ void reloadConfig(const char *arg)
 		no_warps		 = oldNoWarps;
 		newAsMaster		 = oldNewAsMaster;
 		centeredMaster		 = oldCenteredMaster;
+		prewarmCount		 = oldPrewarmCount;
+		workspaceSwitch		 = oldWorkspaceSwitch;
+		dragMode		 = oldDragMode;
+		dragRate		 = oldDragRate;
 
 		return;
 	}
@@ -1814,6 +1939,11 @@ void reloadConfig(const char *arg)
 	}
 	free(oldAutostarts);
 
+	for (size_t i = 0; i < oldPrewarmsCount; i++) {
+		free(oldPrewarms[i].command);
+	}
+	free(oldPrewarms);
+
 	for (size_t i = 0; i < oldKeysCount; i++) {
 		free((void *)oldKeys[i].arg);
 	}
@@ -1840,12 +1970,12 @@ void reloadConfig(const char *arg)
 	free(oldBarStatusTextColor);
 	free(oldDefaultLayout);
 
-	fprintf(stderr,
-		"banana: configuration reloaded with %zu key bindings and %zu "
-		"window rules\n",
-		keysCount, rulesCount);
+	LOG_INFO("banana: configuration reloaded with %zu key bindings and %zu "
+		 "window rules\n",
+		 keysCount, rulesCount);
 
 	if (display) {
+		extern void   allocBorderColors(void);
 		extern void   updateBorders(void);
 		extern void   updateClientPositionsForBar(void);
 		extern void   updateClientVisibility(void);
@@ -1859,12 +1989,13 @@ void reloadConfig(const char *arg)
 		XErrorHandler oldHandler = XSetErrorHandler(xerrorHandler);
 
 		if (!oldHandler) {
-			fprintf(stderr, "banana: warning - no error handler "
-					"registered, proceeding with "
-					"caution\n");
+			LOG_WARN("banana: warning - no error handler "
+				 "registered, proceeding with "
+				 "caution\n");
 		}
 
 		XSync(display, False);
+		allocBorderColors();
 		updateBorders();
 		XSync(display, False);
 
@@ -1878,8 +2009,8 @@ void reloadConfig(const char *arg)
 		if (hasDocks()) {
 			showHideBars(0);
 			barVisible = 0;
-			fprintf(stderr, "Bar hidden due to dock presence after "
-					"config reload\n");
+			LOG_DEBUG("Bar hidden due to dock presence after "
+				  "config reload\n");
 		} else {
 			showHideBars(showBar);
 		}
@@ -1897,6 +2028,8 @@ void reloadConfig(const char *arg)
 		updateBars();
 		XSync(display, False);
 
+		refreshPools();
+
 		XSetErrorHandler(oldHandler);
 	}
 }
@@ -1938,14 +2071,14 @@ void printConfigErrors(SConfigErrors *errors)
 
 	char *configPath = getConfigPath();
 	if (!configPath) {
-		fprintf(stderr, "banana: HOME environment variable not set\n");
+		LOG_ERROR("banana: HOME environment variable not set\n");
 		return;
 	}
 
 	FILE *fp = fopen(configPath, "r");
 	if (!fp) {
-		fprintf(stderr, "banana: failed to open config file: %s\n",
-			strerror(errno));
+		LOG_ERROR("banana: failed to open config file: %s\n",
+			  strerror(errno));
 		free(configPath);
 		return;
 	}
@@ -2041,7 +2174,7 @@ int handleGeneralSection(STokenHandlerContext *ctx, const char *var,
 				addError(ctx->errors, errMsg, lineNum, 0);
 				ctx->hasErrors = 1;
 			} else {
-				fprintf(stderr, "banana: %s\n", errMsg);
+				LOG_WARN("banana: %s\n", errMsg);
 			}
 			freeTokens(tokens, tokenCount);
 			return 1;
@@ -2057,7 +2190,7 @@ int handleGeneralSection(STokenHandlerContext *ctx, const char *var,
 				addError(ctx->errors, errMsg, lineNum, 0);
 				ctx->hasErrors = 1;
 			} else {
-				fprintf(stderr, "banana: %s\n", errMsg);
+				LOG_WARN("banana: %s\n", errMsg);
 				count = 9;
 			}
 		}
@@ -2076,7 +2209,7 @@ int handleGeneralSection(STokenHandlerContext *ctx, const char *var,
 				addError(ctx->errors, errMsg, lineNum, 0);
 				ctx->hasErrors = 1;
 			} else {
-				fprintf(stderr, "banana: %s\n", errMsg);
+				LOG_WARN("banana: %s\n", errMsg);
 			}
 			freeTokens(tokens, tokenCount);
 			return 1;
@@ -2093,7 +2226,7 @@ int handleGeneralSection(STokenHandlerContext *ctx, const char *var,
 				addError(ctx->errors, errMsg, lineNum, 0);
 				ctx->hasErrors = 1;
 			} else {
-				fprintf(stderr, "banana: %s\n", errMsg);
+				LOG_WARN("banana: %s\n", errMsg);
 				innerGap = 0;
 			}
 		} else if (gap > 100) {
@@ -2106,7 +2239,7 @@ int handleGeneralSection(STokenHandlerContext *ctx, const char *var,
 				addError(ctx->errors, errMsg, lineNum, 0);
 				ctx->hasErrors = 1;
 			} else {
-				fprintf(stderr, "banana: %s\n", errMsg);
+				LOG_WARN("banana: %s\n", errMsg);
 				innerGap = 100;
 			}
 		} else if (ctx->mode == TOKEN_HANDLER_LOAD) {
@@ -2123,7 +2256,7 @@ int handleGeneralSection(STokenHandlerContext *ctx, const char *var,
 				addError(ctx->errors, errMsg, lineNum, 0);
 				ctx->hasErrors = 1;
 			} else {
-				fprintf(stderr, "banana: %s\n", errMsg);
+				LOG_WARN("banana: %s\n", errMsg);
 			}
 			freeTokens(tokens, tokenCount);
 			return 1;
@@ -2140,7 +2273,7 @@ int handleGeneralSection(STokenHandlerContext *ctx, const char *var,
 				addError(ctx->errors, errMsg, lineNum, 0);
 				ctx->hasErrors = 1;
 			} else {
-				fprintf(stderr, "banana: %s\n", errMsg);
+				LOG_WARN("banana: %s\n", errMsg);
 				outerGap = 0;
 			}
 		} else if (gap > 100) {
@@ -2153,7 +2286,7 @@ int handleGeneralSection(STokenHandlerContext *ctx, const char *var,
 				addError(ctx->errors, errMsg, lineNum, 0);
 				ctx->hasErrors = 1;
 			} else {
-				fprintf(stderr, "banana: %s\n", errMsg);
+				LOG_WARN("banana: %s\n", errMsg);
 				outerGap = 100;
 			}
 		} else if (ctx->mode == TOKEN_HANDLER_LOAD) {
@@ -2182,7 +2315,7 @@ int handleGeneralSection(STokenHandlerContext *ctx, const char *var,
 						 0);
 					ctx->hasErrors = 1;
 				} else {
-					fprintf(stderr, "banana: %s\n", errMsg);
+					LOG_WARN("banana: %s\n", errMsg);
 					smartGaps = 0;
 				}
 			} else if (ctx->mode == TOKEN_HANDLER_LOAD) {
@@ -2199,7 +2332,7 @@ int handleGeneralSection(STokenHandlerContext *ctx, const char *var,
 				addError(ctx->errors, errMsg, lineNum, 0);
 				ctx->hasErrors = 1;
 			} else {
-				fprintf(stderr, "banana: %s\n", errMsg);
+				LOG_WARN("banana: %s\n", errMsg);
 			}
 			freeTokens(tokens, tokenCount);
 			return 1;
@@ -2216,7 +2349,7 @@ int handleGeneralSection(STokenHandlerContext *ctx, const char *var,
 				addError(ctx->errors, errMsg, lineNum, 0);
 				ctx->hasErrors = 1;
 			} else {
-				fprintf(stderr, "banana: %s\n", errMsg);
+				LOG_WARN("banana: %s\n", errMsg);
 			}
 			freeTokens(tokens, tokenCount);
 			return 1;
@@ -2233,7 +2366,7 @@ int handleGeneralSection(STokenHandlerContext *ctx, const char *var,
 				addError(ctx->errors, errMsg, lineNum, 0);
 				ctx->hasErrors = 1;
 			} else {
-				fprintf(stderr, "banana: %s\n", errMsg);
+				LOG_WARN("banana: %s\n", errMsg);
 				borderWidth = 0;
 			}
 		} else if (width > 100) {
@@ -2246,7 +2379,7 @@ int handleGeneralSection(STokenHandlerContext *ctx, const char *var,
 				addError(ctx->errors, errMsg, lineNum, 0);
 				ctx->hasErrors = 1;
 			} else {
-				fprintf(stderr, "banana: %s\n", errMsg);
+				LOG_WARN("banana: %s\n", errMsg);
 				borderWidth = 100;
 			}
 		} else if (ctx->mode == TOKEN_HANDLER_LOAD) {
@@ -2265,7 +2398,7 @@ int handleGeneralSection(STokenHandlerContext *ctx, const char *var,
 				addError(ctx->errors, errMsg, lineNum, 0);
 				ctx->hasErrors = 1;
 			} else {
-				fprintf(stderr, "banana: %s\n", errMsg);
+				LOG_WARN("banana: %s\n", errMsg);
 			}
 			freeTokens(tokens, tokenCount);
 			return 1;
@@ -2303,6 +2436,106 @@ int handleGeneralSection(STokenHandlerContext *ctx, const char *var,
 			ctx->hasErrors = 1;
 			return 0;
 		}
+	} else if (strcmp(var, "prewarm_count") == 0) {
+		if (!isValidInteger(val) || atoi(val) < 0 ||
+		    atoi(val) > MAX_PREWARM_COUNT) {
+			char errMsg[MAX_LINE_LENGTH];
+			snprintf(errMsg, MAX_LINE_LENGTH,
+				 "Invalid prewarm count: '%s' - must be an "
+				 "integer between 0 and %d",
+				 val, MAX_PREWARM_COUNT);
+
+			if (ctx->mode == TOKEN_HANDLER_VALIDATE) {
+				addError(ctx->errors, errMsg, lineNum, 0);
+				ctx->hasErrors = 1;
+			} else {
+				LOG_WARN("banana: %s\n", errMsg);
+			}
+			freeTokens(tokens, tokenCount);
+			return 1;
+		}
+
+		if (ctx->mode == TOKEN_HANDLER_LOAD) {
+			prewarmCount = atoi(val);
+		}
+	} else if (strcmp(var, "workspace_switch") == 0) {
+		EWorkspaceSwitch mode;
+		if (strcasecmp(val, "unmap") == 0) {
+			mode = WORKSPACE_SWITCH_UNMAP;
+		} else if (strcasecmp(val, "grab") == 0) {
+			mode = WORKSPACE_SWITCH_GRAB;
+		} else if (strcasecmp(val, "offscreen") == 0) {
+			mode = WORKSPACE_SWITCH_OFFSCREEN;
+		} else {
+			char errMsg[MAX_LINE_LENGTH];
+			snprintf(errMsg, MAX_LINE_LENGTH,
+				 "Invalid workspace_switch value: '%s' - must "
+				 "be 'unmap', 'grab' or 'offscreen'",
+				 val);
+
+			if (ctx->mode == TOKEN_HANDLER_VALIDATE) {
+				addError(ctx->errors, errMsg, lineNum, 0);
+				ctx->hasErrors = 1;
+			} else {
+				LOG_WARN("banana: %s\n", errMsg);
+			}
+			freeTokens(tokens, tokenCount);
+			return 1;
+		}
+
+		if (ctx->mode == TOKEN_HANDLER_LOAD) {
+			workspaceSwitch = mode;
+		}
+	} else if (strcmp(var, "drag_mode") == 0) {
+		EDragMode mode;
+		if (strcasecmp(val, "live") == 0) {
+			mode = DRAG_LIVE;
+		} else if (strcasecmp(val, "throttle") == 0) {
+			mode = DRAG_THROTTLE;
+		} else if (strcasecmp(val, "outline") == 0) {
+			mode = DRAG_OUTLINE;
+		} else {
+			char errMsg[MAX_LINE_LENGTH];
+			snprintf(errMsg, MAX_LINE_LENGTH,
+				 "Invalid drag_mode value: '%s' - must be "
+				 "'live', 'throttle' or 'outline'",
+				 val);
+
+			if (ctx->mode == TOKEN_HANDLER_VALIDATE) {
+				addError(ctx->errors, errMsg, lineNum, 0);
+				ctx->hasErrors = 1;
+			} else {
+				LOG_WARN("banana: %s\n", errMsg);
+			}
+			freeTokens(tokens, tokenCount);
+			return 1;
+		}
+
+		if (ctx->mode == TOKEN_HANDLER_LOAD) {
+			dragMode = mode;
+		}
+	} else if (strcmp(var, "drag_rate") == 0) {
+		if (!isValidInteger(val) || atoi(val) < 1 ||
+		    atoi(val) > MAX_DRAG_RATE) {
+			char errMsg[MAX_LINE_LENGTH];
+			snprintf(errMsg, MAX_LINE_LENGTH,
+				 "Invalid drag rate: '%s' - must be an "
+				 "integer between 1 and %d",
+				 val, MAX_DRAG_RATE);
+
+			if (ctx->mode == TOKEN_HANDLER_VALIDATE) {
+				addError(ctx->errors, errMsg, lineNum, 0);
+				ctx->hasErrors = 1;
+			} else {
+				LOG_WARN("banana: %s\n", errMsg);
+			}
+			freeTokens(tokens, tokenCount);
+			return 1;
+		}
+
+		if (ctx->mode == TOKEN_HANDLER_LOAD) {
+			dragRate = atoi(val);
+		}
 	} else {
 		char errMsg[MAX_LINE_LENGTH];
 		snprintf(errMsg, MAX_LINE_LENGTH, "Unknown general setting: %s",
@@ -2312,7 +2545,7 @@ int handleGeneralSection(STokenHandlerContext *ctx, const char *var,
 			addError(ctx->errors, errMsg, lineNum, 0);
 			ctx->hasErrors = 1;
 		} else {
-			fprintf(stderr, "banana: %s\n", errMsg);
+			LOG_WARN("banana: %s\n", errMsg);
 		}
 	}
 
@@ -2335,7 +2568,7 @@ int handleBarSection(STokenHandlerContext *ctx, const char *var,
 				addError(ctx->errors, errMsg, lineNum, 0);
 				ctx->hasErrors = 1;
 			} else {
-				fprintf(stderr, "banana: %s\n", errMsg);
+				LOG_WARN("banana: %s\n", errMsg);
 			}
 			freeTokens(tokens, tokenCount);
 			return 1;
@@ -2352,7 +2585,7 @@ int handleBarSection(STokenHandlerContext *ctx, const char *var,
 				addError(ctx->errors, errMsg, lineNum, 0);
 				ctx->hasErrors = 1;
 			} else {
-				fprintf(stderr, "banana: %s\n", errMsg);
+				LOG_WARN("banana: %s\n", errMsg);
 				barHeight = 0;
 			}
 		} else if (height > 100) {
@@ -2365,7 +2598,7 @@ int handleBarSection(STokenHandlerContext *ctx, const char *var,
 				addError(ctx->errors, errMsg, lineNum, 0);
 				ctx->hasErrors = 1;
 			} else {
-				fprintf(stderr, "banana: %s\n", errMsg);
+				LOG_WARN("banana: %s\n", errMsg);
 				barHeight = 100;
 			}
 		} else if (ctx->mode == TOKEN_HANDLER_LOAD) {
@@ -2473,7 +2706,7 @@ int handleBarSection(STokenHandlerContext *ctx, const char *var,
 				addError(ctx->errors, errMsg, lineNum, 0);
 				ctx->hasErrors = 1;
 			} else {
-				fprintf(stderr, "banana: %s\n", errMsg);
+				LOG_WARN("banana: %s\n", errMsg);
 			}
 			freeTokens(tokens, tokenCount);
 			return 1;
@@ -2490,7 +2723,7 @@ int handleBarSection(STokenHandlerContext *ctx, const char *var,
 				addError(ctx->errors, errMsg, lineNum, 0);
 				ctx->hasErrors = 1;
 			} else {
-				fprintf(stderr, "banana: %s\n", errMsg);
+				LOG_WARN("banana: %s\n", errMsg);
 				barBorderWidth = 0;
 			}
 		} else if (width > 100) {
@@ -2503,7 +2736,7 @@ int handleBarSection(STokenHandlerContext *ctx, const char *var,
 				addError(ctx->errors, errMsg, lineNum, 0);
 				ctx->hasErrors = 1;
 			} else {
-				fprintf(stderr, "banana: %s\n", errMsg);
+				LOG_WARN("banana: %s\n", errMsg);
 				barBorderWidth = 100;
 			}
 		} else if (ctx->mode == TOKEN_HANDLER_LOAD) {
@@ -2521,7 +2754,7 @@ int handleBarSection(STokenHandlerContext *ctx, const char *var,
 				addError(ctx->errors, errMsg, lineNum, 0);
 				ctx->hasErrors = 1;
 			} else {
-				fprintf(stderr, "banana: %s\n", errMsg);
+				LOG_WARN("banana: %s\n", errMsg);
 			}
 			freeTokens(tokens, tokenCount);
 			return 1;
@@ -2538,7 +2771,7 @@ int handleBarSection(STokenHandlerContext *ctx, const char *var,
 				addError(ctx->errors, errMsg, lineNum, 0);
 				ctx->hasErrors = 1;
 			} else {
-				fprintf(stderr, "banana: %s\n", errMsg);
+				LOG_WARN("banana: %s\n", errMsg);
 				barStrutsTop = 0;
 			}
 		} else if (strutsTop > 100) {
@@ -2551,7 +2784,7 @@ int handleBarSection(STokenHandlerContext *ctx, const char *var,
 				addError(ctx->errors, errMsg, lineNum, 0);
 				ctx->hasErrors = 1;
 			} else {
-				fprintf(stderr, "banana: %s\n", errMsg);
+				LOG_WARN("banana: %s\n", errMsg);
 				barStrutsTop = 100;
 			}
 		} else if (ctx->mode == TOKEN_HANDLER_LOAD) {
@@ -2569,7 +2802,7 @@ int handleBarSection(STokenHandlerContext *ctx, const char *var,
 				addError(ctx->errors, errMsg, lineNum, 0);
 				ctx->hasErrors = 1;
 			} else {
-				fprintf(stderr, "banana: %s\n", errMsg);
+				LOG_WARN("banana: %s\n", errMsg);
 			}
 			freeTokens(tokens, tokenCount);
 			return 1;
@@ -2586,7 +2819,7 @@ int handleBarSection(STokenHandlerContext *ctx, const char *var,
 				addError(ctx->errors, errMsg, lineNum, 0);
 				ctx->hasErrors = 1;
 			} else {
-				fprintf(stderr, "banana: %s\n", errMsg);
+				LOG_WARN("banana: %s\n", errMsg);
 				barStrutsLeft = 0;
 			}
 		} else if (strutsLeft > 100) {
@@ -2599,7 +2832,7 @@ int handleBarSection(STokenHandlerContext *ctx, const char *var,
 				addError(ctx->errors, errMsg, lineNum, 0);
 				ctx->hasErrors = 1;
 			} else {
-				fprintf(stderr, "banana: %s\n", errMsg);
+				LOG_WARN("banana: %s\n", errMsg);
 				barStrutsLeft = 100;
 			}
 		} else if (ctx->mode == TOKEN_HANDLER_LOAD) {
@@ -2617,7 +2850,7 @@ int handleBarSection(STokenHandlerContext *ctx, const char *var,
 				addError(ctx->errors, errMsg, lineNum, 0);
 				ctx->hasErrors = 1;
 			} else {
-				fprintf(stderr, "banana: %s\n", errMsg);
+				LOG_WARN("banana: %s\n", errMsg);
 			}
 			freeTokens(tokens, tokenCount);
 			return 1;
@@ -2634,7 +2867,7 @@ int handleBarSection(STokenHandlerContext *ctx, const char *var,
 				addError(ctx->errors, errMsg, lineNum, 0);
 				ctx->hasErrors = 1;
 			} else {
-				fprintf(stderr, "banana: %s\n", errMsg);
+				LOG_WARN("banana: %s\n", errMsg);
 				barStrutsRight = 0;
 			}
 		} else if (strutsRight > 100) {
@@ -2647,7 +2880,7 @@ int handleBarSection(STokenHandlerContext *ctx, const char *var,
 				addError(ctx->errors, errMsg, lineNum, 0);
 				ctx->hasErrors = 1;
 			} else {
-				fprintf(stderr, "banana: %s\n", errMsg);
+				LOG_WARN("banana: %s\n", errMsg);
 				barStrutsRight = 100;
 			}
 		} else if (ctx->mode == TOKEN_HANDLER_LOAD) {
@@ -2662,7 +2895,7 @@ int handleBarSection(STokenHandlerContext *ctx, const char *var,
 			addError(ctx->errors, errMsg, lineNum, 0);
 			ctx->hasErrors = 1;
 		} else {
-			fprintf(stderr, "banana: %s\n", errMsg);
+			LOG_WARN("banana: %s\n", errMsg);
 		}
 	}
 
@@ -2687,7 +2920,7 @@ int handleDecorationSection(STokenHandlerContext *ctx, const char *var,
 						 0);
 					ctx->hasErrors = 1;
 				} else {
-					fprintf(stderr, "banana: %s\n", errMsg);
+					LOG_WARN("banana: %s\n", errMsg);
 				}
 				freeTokens(tokens, tokenCount);
 				return 0;
@@ -2707,7 +2940,7 @@ int handleDecorationSection(STokenHandlerContext *ctx, const char *var,
 						 0);
 					ctx->hasErrors = 1;
 				} else {
-					fprintf(stderr, "banana: %s\n", errMsg);
+					LOG_WARN("banana: %s\n", errMsg);
 				}
 				freeTokens(tokens, tokenCount);
 				return 0;
@@ -2727,7 +2960,7 @@ int handleDecorationSection(STokenHandlerContext *ctx, const char *var,
 						 0);
 					ctx->hasErrors = 1;
 				} else {
-					fprintf(stderr, "banana: %s\n", errMsg);
+					LOG_WARN("banana: %s\n", errMsg);
 				}
 				freeTokens(tokens, tokenCount);
 				return 0;
@@ -2747,7 +2980,7 @@ int handleDecorationSection(STokenHandlerContext *ctx, const char *var,
 						 0);
 					ctx->hasErrors = 1;
 				} else {
-					fprintf(stderr, "banana: %s\n", errMsg);
+					LOG_WARN("banana: %s\n", errMsg);
 				}
 				freeTokens(tokens, tokenCount);
 				return 0;
@@ -2767,7 +3000,7 @@ int handleDecorationSection(STokenHandlerContext *ctx, const char *var,
 						 0);
 					ctx->hasErrors = 1;
 				} else {
-					fprintf(stderr, "banana: %s\n", errMsg);
+					LOG_WARN("banana: %s\n", errMsg);
 				}
 				freeTokens(tokens, tokenCount);
 				return 0;
@@ -2787,7 +3020,7 @@ int handleDecorationSection(STokenHandlerContext *ctx, const char *var,
 						 0);
 					ctx->hasErrors = 1;
 				} else {
-					fprintf(stderr, "banana: %s\n", errMsg);
+					LOG_WARN("banana: %s\n", errMsg);
 				}
 				freeTokens(tokens, tokenCount);
 				return 0;
@@ -2807,7 +3040,7 @@ int handleDecorationSection(STokenHandlerContext *ctx, const char *var,
 						 0);
 					ctx->hasErrors = 1;
 				} else {
-					fprintf(stderr, "banana: %s\n", errMsg);
+					LOG_WARN("banana: %s\n", errMsg);
 				}
 				freeTokens(tokens, tokenCount);
 				return 0;
@@ -2827,7 +3060,7 @@ int handleDecorationSection(STokenHandlerContext *ctx, const char *var,
 						 0);
 					ctx->hasErrors = 1;
 				} else {
-					fprintf(stderr, "banana: %s\n", errMsg);
+					LOG_WARN("banana: %s\n", errMsg);
 				}
 				freeTokens(tokens, tokenCount);
 				return 0;
@@ -2847,7 +3080,7 @@ int handleDecorationSection(STokenHandlerContext *ctx, const char *var,
 						 0);
 					ctx->hasErrors = 1;
 				} else {
-					fprintf(stderr, "banana: %s\n", errMsg);
+					LOG_WARN("banana: %s\n", errMsg);
 				}
 				freeTokens(tokens, tokenCount);
 				return 0;
@@ -2867,7 +3100,7 @@ int handleDecorationSection(STokenHandlerContext *ctx, const char *var,
 						 0);
 					ctx->hasErrors = 1;
 				} else {
-					fprintf(stderr, "banana: %s\n", errMsg);
+					LOG_WARN("banana: %s\n", errMsg);
 				}
 				freeTokens(tokens, tokenCount);
 				return 0;
@@ -2887,7 +3120,7 @@ int handleDecorationSection(STokenHandlerContext *ctx, const char *var,
 						 0);
 					ctx->hasErrors = 1;
 				} else {
-					fprintf(stderr, "banana: %s\n", errMsg);
+					LOG_WARN("banana: %s\n", errMsg);
 				}
 				freeTokens(tokens, tokenCount);
 				return 0;
@@ -2895,9 +3128,8 @@ int handleDecorationSection(STokenHandlerContext *ctx, const char *var,
 			free(barStatusTextColor);
 			barStatusTextColor = safeStrdup(val);
 		} else {
-			fprintf(stderr,
-				"banana: unknown decoration setting: %s\n",
-				var);
+			LOG_WARN("banana: unknown decoration setting: %s\n",
+				 var);
 		}
 	} else if (!(strcmp(var, "active_border_color") == 0 ||
 		     strcmp(var, "inactive_border_color") == 0 ||
@@ -2944,7 +3176,7 @@ int handleBindsSection(STokenHandlerContext *ctx, const char *modStr,
 			addError(ctx->errors, errMsg, lineNum, 0);
 			ctx->hasErrors = 1;
 		} else {
-			fprintf(stderr, "banana: %s\n", errMsg);
+			LOG_WARN("banana: %s\n", errMsg);
 		}
 
 		freeTokens(tokens, tokenCount);
@@ -2961,7 +3193,7 @@ int handleBindsSection(STokenHandlerContext *ctx, const char *modStr,
 			addError(ctx->errors, errMsg, lineNum, 0);
 			ctx->hasErrors = 1;
 		} else {
-			fprintf(stderr, "banana: %s\n", errMsg);
+			LOG_WARN("banana: %s\n", errMsg);
 		}
 
 		freeTokens(tokens, tokenCount);
@@ -2978,7 +3210,7 @@ int handleBindsSection(STokenHandlerContext *ctx, const char *modStr,
 			addError(ctx->errors, errMsg, lineNum, 0);
 			ctx->hasErrors = 1;
 		} else {
-			fprintf(stderr, "banana: %s\n", errMsg);
+			LOG_WARN("banana: %s\n", errMsg);
 		}
 
 		freeTokens(tokens, tokenCount);
@@ -2986,87 +3218,15 @@ int handleBindsSection(STokenHandlerContext *ctx, const char *modStr,
 	}
 
 	if (argStr) {
-		int  argValid = 1;
 		char errMsg[MAX_LINE_LENGTH];
 
-		if (strcasecmp(funcStr, "switch_workspace") == 0 ||
-		    strcasecmp(funcStr, "move_to_workspace") == 0) {
-			if (!isValidInteger(argStr)) {
-				snprintf(errMsg, MAX_LINE_LENGTH,
-					 "Invalid workspace index: '%s' - must "
-					 "be an integer between 0 and 8",
-					 argStr);
-				argValid = 0;
-			} else {
-				int value = atoi(argStr);
-				if (value < 0 || value > 8) {
-					snprintf(errMsg, MAX_LINE_LENGTH,
-						 "Invalid workspace index: %d "
-						 "- must be between 0 and 8",
-						 value);
-					argValid = 0;
-				}
-			}
-		} else if (strcasecmp(funcStr, "adjust_master") == 0) {
-			if (!isValidAdjustMasterArg(argStr)) {
-				snprintf(errMsg, MAX_LINE_LENGTH,
-					 "Invalid adjust_master argument: '%s' "
-					 "- must be 'increase' or 'decrease'",
-					 argStr);
-				argValid = 0;
-			}
-		} else if (strcasecmp(funcStr, "move_window") == 0) {
-			if (!isValidMoveWindowArg(argStr)) {
-				snprintf(errMsg, MAX_LINE_LENGTH,
-					 "Invalid move_window argument: '%s' - "
-					 "must be 'up', 'down', 'left', or "
-					 "'right'",
-					 argStr);
-				argValid = 0;
-			}
-		} else if (strcasecmp(funcStr, "resize_window") == 0) {
-			if (!isValidResizeWindowArg(argStr)) {
-				snprintf(errMsg, MAX_LINE_LENGTH,
-					 "Invalid resize_window argument: '%s' "
-					 "- "
-					 "must be 'up', 'down', 'left', "
-					 "'right', 'grow_up', 'grow_down', "
-					 "'grow_left', or 'grow_right'",
-					 argStr);
-				argValid = 0;
-			}
-		} else if (strcasecmp(funcStr, "focus_window") == 0) {
-			if (!isValidFocusWindowArg(argStr)) {
-				snprintf(errMsg, MAX_LINE_LENGTH,
-					 "Invalid focus_window argument: '%s' "
-					 "- must be 'up' or 'down'",
-					 argStr);
-				argValid = 0;
-			}
-		} else if (strcasecmp(funcStr, "cycle_focus") == 0) {
-			if (!isValidCycleFocusArg(argStr)) {
-				snprintf(errMsg, MAX_LINE_LENGTH,
-					 "Invalid cycle_focus argument: '%s' "
-					 "- must be 'up' or 'down'",
-					 argStr);
-				argValid = 0;
-			}
-		} else if (strcasecmp(funcStr, "focus_monitor") == 0) {
-			if (!isValidFocusMonitorArg(argStr)) {
-				snprintf(errMsg, MAX_LINE_LENGTH,
-					 "Invalid focus_monitor argument: '%s' "
-					 "- must be 'left' or 'right'",
-					 argStr);
-				argValid = 0;
-			}
-		}
-
-		if (!argValid) {
+		if (!isValidFunctionArg(funcStr, argStr, errMsg,
+					MAX_LINE_LENGTH)) {
 			if (ctx->mode == TOKEN_HANDLER_VALIDATE) {
 				addError(ctx->errors, errMsg, lineNum, 0);
 				ctx->hasErrors = 1;
 			} else {
-				fprintf(stderr, "banana: %s\n", errMsg);
+				LOG_WARN("banana: %s\n", errMsg);
 			}
 
 			freeTokens(tokens, tokenCount);
@@ -3083,7 +3243,7 @@ int handleBindsSection(STokenHandlerContext *ctx, const char *modStr,
 			addError(ctx->errors, errMsg, lineNum, 0);
 			ctx->hasErrors = 1;
 		} else {
-			fprintf(stderr, "banana: %s\n", errMsg);
+			LOG_WARN("banana: %s\n", errMsg);
 		}
 
 		freeTokens(tokens, tokenCount);
@@ -3116,7 +3276,7 @@ int handleRulesSection(STokenHandlerContext *ctx, int tokenCount, char **tokens,
 			addError(ctx->errors, errMsg, lineNum, 0);
 			ctx->hasErrors = 1;
 		} else {
-			fprintf(stderr, "banana: %s\n", errMsg);
+			LOG_WARN("banana: %s\n", errMsg);
 		}
 
 		freeTokens(tokens, tokenCount);
@@ -3191,7 +3351,7 @@ int handleRulesSection(STokenHandlerContext *ctx, int tokenCount, char **tokens,
 						 "Invalid workspace index: %d "
 						 "- must be between 0 and 8",
 						 workspace);
-					fprintf(stderr, "banana: %s\n", errMsg);
+					LOG_WARN("banana: %s\n", errMsg);
 				} else {
 					rules[rulesCount].workspace = workspace;
 				}
@@ -3231,7 +3391,7 @@ int handleRulesSection(STokenHandlerContext *ctx, int tokenCount, char **tokens,
 				addError(ctx->errors, errMsg, lineNum, 0);
 				ctx->hasErrors = 1;
 			} else {
-				fprintf(stderr, "banana: %s\n", errMsg);
+				LOG_WARN("banana: %s\n", errMsg);
 			}
 		}
 	}
@@ -3344,7 +3504,7 @@ int handleMasterSection(STokenHandlerContext *ctx, const char *var,
 				addError(ctx->errors, errMsg, lineNum, 0);
 				ctx->hasErrors = 1;
 			} else {
-				fprintf(stderr, "banana: %s\n", errMsg);
+				LOG_WARN("banana: %s\n", errMsg);
 			}
 			return 0;
 		}
@@ -3360,7 +3520,7 @@ int handleMasterSection(STokenHandlerContext *ctx, const char *var,
 				addError(ctx->errors, errMsg, lineNum, 0);
 				ctx->hasErrors = 1;
 			} else {
-				fprintf(stderr, "banana: %s\n", errMsg);
+				LOG_WARN("banana: %s\n", errMsg);
 				defaultMasterFactor = 0.10;
 			}
 		} else if (factor > 0.90) {
@@ -3373,7 +3533,7 @@ int handleMasterSection(STokenHandlerContext *ctx, const char *var,
 				addError(ctx->errors, errMsg, lineNum, 0);
 				ctx->hasErrors = 1;
 			} else {
-				fprintf(stderr, "banana: %s\n", errMsg);
+				LOG_WARN("banana: %s\n", errMsg);
 				defaultMasterFactor = 0.90;
 			}
 		} else if (ctx->mode == TOKEN_HANDLER_LOAD) {
@@ -3427,6 +3587,7 @@ void cleanupConfigData(void)
 
 	cleanupVariables();
 	cleanupAutostart();
+	cleanupPrewarms();
 }
 
 int processConfigVariable(const char *name, const char *value, int lineNum,
@@ -3445,7 +3606,7 @@ int processConfigVariable(const char *name, const char *value, int lineNum,
 			addError(ctx->errors, errMsg, lineNum, 0);
 			ctx->hasErrors = 1;
 		} else {
-			fprintf(stderr, "banana: %s\n", errMsg);
+			LOG_WARN("banana: %s\n", errMsg);
 		}
 		return 0;
 	}
@@ -3633,7 +3794,7 @@ int processExecCommand(const char *command, int lineNum,
 			addError(ctx->errors, errMsg, lineNum, 0);
 			ctx->hasErrors = 1;
 		} else {
-			fprintf(stderr, "banana: %s\n", errMsg);
+			LOG_WARN("banana: %s\n", errMsg);
 		}
 		return 0;
 	}
@@ -3654,6 +3815,41 @@ int processExecCommand(const char *command, int lineNum,
 	return 1;
 }
 
+int processPrewarmCommand(const char *command, int lineNum,
+			  STokenHandlerContext *ctx)
+{
+	if (!command) {
+		return 0;
+	}
+
+	if (prewarmsCount >= MAX_PREWARMS) {
+		char errMsg[MAX_LINE_LENGTH];
+		snprintf(errMsg, MAX_LINE_LENGTH,
+			 "Too many prewarm commands defined (max: %d)",
+			 MAX_PREWARMS);
+
+		if (ctx->mode == TOKEN_HANDLER_VALIDATE) {
+			addError(ctx->errors, errMsg, lineNum, 0);
+			ctx->hasErrors = 1;
+		} else {
+			LOG_WARN("banana: %s\n", errMsg);
+		}
+		return 0;
+	}
+
+	if (!prewarms) {
+		prewarms = safeMalloc(MAX_PREWARMS * sizeof(SPrewarm));
+		for (size_t i = 0; i < MAX_PREWARMS; i++) {
+			prewarms[i].command = NULL;
+		}
+	}
+
+	prewarms[prewarmsCount].command = safeStrdup(command);
+	prewarmsCount++;
+
+	return 1;
+}
+
 void runAutostart(void)
 {
 	if (!autostarts || autostartsCount == 0) {
@@ -3664,8 +3860,8 @@ void runAutostart(void)
 		if (autostarts[i].command) {
 			char *cmd = substituteVariables(autostarts[i].command);
 			if (cmd) {
-				fprintf(stderr,
-					"Running autostart command: %s\n", cmd);
+				LOG_INFO("Running autostart command: %s\n",
+					 cmd);
 				spawnProgram(cmd);
 				free(cmd);
 			}
@@ -3688,4 +3884,19 @@ void cleanupAutostart(void)
 	free(autostarts);
 	autostarts	= NULL;
 	autostartsCount = 0;
-}
\ No newline at end of file
+}
+
+void cleanupPrewarms(void)
+{
+	if (!prewarms) {
+		return;
+	}
+
+	for (size_t i = 0; i < prewarmsCount; i++) {
+		free(prewarms[i].command);
+	}
+
+	free(prewarms);
+	prewarms      = NULL;
+	prewarmsCount = 0;
+}
@@ -5,7 +5,7 @@
 #include <X11/keysym.h>
 #include <stddef.h>
 
-#define CONFIG_PATH	 "/.config/banana/banana.conf"
+#define CONFIG_PATH	  "/.config/banana/banana.conf"
 #define MAX_LINE_LENGTH	 1024
 #define MAX_TOKEN_LENGTH 128
 #define MAX_KEYS	 100
@@ -13,6 +13,9 @@
 #define MAX_ERRORS	 100
 #define MAX_VARIABLES	 50
 #define MAX_AUTOSTARTS	 50
+#define MAX_PREWARMS	 8
+#define MAX_PREWARM_COUNT 4
+#define MAX_DRAG_RATE	 1000
 #define MAX_SECTIONS	 20
 
 #define SECTION_GENERAL	   "general"
@@ -47,6 +50,16 @@ typedef struct {
 	char *value;
 } SVariable;
 
+/* how windows on a workspace that is switched away from are hidden */
+typedef enum {
+	WORKSPACE_SWITCH_UNMAP,
+	WORKSPACE_SWITCH_GRAB,
+	WORKSPACE_SWITCH_OFFSCREEN
+} EWorkspaceSwitch;
+
+/* how a window follows the pointer while it is moved or resized */
+typedef enum { DRAG_LIVE, DRAG_THROTTLE, DRAG_OUTLINE } EDragMode;
+
 typedef struct {
 	const char *name;
 	void (*func)(const char *);
@@ -99,6 +112,10 @@ typedef struct {
 	char *command;
 } SAutostart;
 
+typedef struct {
+	char *command;
+} SPrewarm;
+
 void	     spawnProgram(const char *arg);
 void	     killClient(const char *arg);
 void	     quit(const char *arg);
@@ -139,6 +156,8 @@ int    isValidFocusWindowArg(const char *arg);
 int    isValidCycleFocusArg(const char *arg);
 int    isValidFocusMonitorArg(const char *arg);
 int    isValidHexColor(const char *str);
+int    isValidFunctionArg(const char *funcStr, const char *arg, char *errMsg,
+			  size_t size);
 
 char **tokenizeLine(const char *line, int *tokenCount);
 int    initializeConfig(STokenHandlerContext *ctx, SKeyBinding **oldKeys,
@@ -191,11 +210,14 @@ int   processConfigVariable(const char *name, const char *value, int lineNum,
 			    STokenHandlerContext *ctx);
 int   processExecCommand(const char *command, int lineNum,
 			 STokenHandlerContext *ctx);
+int   processPrewarmCommand(const char *command, int lineNum,
+			    STokenHandlerContext *ctx);
 char *substituteVariables(const char *str);
 const char     *getVariableValue(const char *name);
 void		cleanupVariables(void);
 void		runAutostart(void);
 void		cleanupAutostart(void);
+void		cleanupPrewarms(void);
 
 extern Display *display;
 extern Window	root;
@@ -243,6 +265,10 @@ extern char		 *errorFont;
 
 extern char		 *defaultLayout;
 extern int		  no_warps;
+extern int		  prewarmCount;
+extern EWorkspaceSwitch	  workspaceSwitch;
+extern EDragMode	  dragMode;
+extern int		  dragRate;
 
 extern SKeyBinding	 *keys;
 extern size_t		  keysCount;
@@ -250,6 +276,8 @@ extern SWindowRule	 *rules;
 extern size_t		  rulesCount;
 extern SAutostart	 *autostarts;
 extern size_t		  autostartsCount;
+extern SPrewarm		 *prewarms;
+extern size_t		  prewarmsCount;
 
 extern const SFunctionMap functionMap[];
 extern const SModifierMap modifierMap[];
@@ -1,3 +1,4 @@
+#define _GNU_SOURCE
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -10,9 +11,61 @@
 #include <pwd.h>
 
 #include "ipc.h"
+#include "banana.h"
+#include "config.h"
+#include "snapshot.h"
+#include "query.h"
+#include "log.h"
+#include "stats.h"
+#include "trace.h"
+#include "record.h"
+
+typedef struct {
+	char  *data;
+	size_t length;
+	size_t capacity;
+} SIPCBuffer;
+
+typedef struct {
+	int	   fd;
+	SIPCBuffer in;
+	SIPCBuffer out;
+	uint32_t   eventMask;
+	SIPCEvent *events;
+	int	   eventHead;
+	int	   eventCount;
+	uint32_t   lagged;
+	int	   passFd;
+	size_t	   passOffset;
+} SIPCClient;
+
+typedef struct {
+	void (*func)(const char *);
+	char *arg;
+} SIPCAction;
 
 static int	   serverSocket = -1;
 static char	   socketPath[SOCKET_PATH_MAX];
+static SIPCClient  ipcClients[IPC_MAX_CLIENTS];
+static int	   ipcClientCount = 0;
+
+static const char *eventNames[] = {NULL,      "focus",	  "workspace",
+				   "manage",  "unmanage", "layout",
+				   "urgency",  "monitor"};
+
+static const char *commandNames[] = {
+    NULL,	   "reload",	   "run",	  "batch",
+    "subscribe",   "get_snapshot", "get_tree",	  "get_workspaces",
+    "get_clients", "get_stats",	   "reset_stats", "start_trace",
+    "stop_trace",  "dump_trace",   "start_record", "stop_record"};
+
+static const char *commandName(uint32_t type)
+{
+	if (type == 0 || type >= sizeof(commandNames) / sizeof(*commandNames)) {
+		return "unknown";
+	}
+	return commandNames[type];
+}
 
 static const char *getSocketPath(void)
 {
@@ -62,17 +115,15 @@ int ipcInitServer(void)
 
 	unlink(path);
 
-	serverSocket = socket(AF_UNIX, SOCK_STREAM, 0);
+	serverSocket = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
 	if (serverSocket == -1) {
-		fprintf(stderr, "Failed to create IPC socket: %s\n",
-			strerror(errno));
+		LOG_ERROR("Failed to create IPC socket: %s\n", strerror(errno));
 		return -1;
 	}
 
 	if (setNonblocking(serverSocket) == -1) {
-		fprintf(stderr,
-			"Failed to set socket to non-blocking mode: %s\n",
-			strerror(errno));
+		LOG_ERROR("Failed to set socket to non-blocking mode: %s\n",
+			  strerror(errno));
 		close(serverSocket);
 		serverSocket = -1;
 		return -1;
@@ -84,28 +135,643 @@ int ipcInitServer(void)
 	snprintf(addr.sun_path, sizeof(addr.sun_path), "%s", path);
 
 	if (bind(serverSocket, (struct sockaddr *)&addr, sizeof(addr)) == -1) {
-		fprintf(stderr, "Failed to bind IPC socket to %s: %s\n", path,
-			strerror(errno));
+		LOG_ERROR("Failed to bind IPC socket to %s: %s\n", path,
+			  strerror(errno));
 		close(serverSocket);
 		serverSocket = -1;
 		return -1;
 	}
 
-	if (listen(serverSocket, 5) == -1) {
-		fprintf(stderr, "Failed to listen on IPC socket: %s\n",
-			strerror(errno));
+	if (listen(serverSocket, IPC_MAX_CLIENTS) == -1) {
+		LOG_ERROR("Failed to listen on IPC socket: %s\n",
+			  strerror(errno));
 		close(serverSocket);
 		serverSocket = -1;
 		unlink(path);
 		return -1;
 	}
 
-	fprintf(stderr, "IPC server initialized at %s\n", path);
+	LOG_INFO("IPC server initialized at %s\n", path);
+	return 0;
+}
+
+static int bufferReserve(SIPCBuffer *buffer, size_t extra)
+{
+	if (buffer->length + extra <= buffer->capacity) {
+		return 0;
+	}
+
+	if (buffer->length + extra > IPC_MAX_BUFFER) {
+		return -1;
+	}
+
+	size_t capacity = buffer->capacity ? buffer->capacity : 1024;
+	while (capacity < buffer->length + extra) {
+		capacity *= 2;
+	}
+
+	char *data = realloc(buffer->data, capacity);
+	if (!data) {
+		return -1;
+	}
+
+	buffer->data	 = data;
+	buffer->capacity = capacity;
+	return 0;
+}
+
+static void bufferConsume(SIPCBuffer *buffer, size_t count)
+{
+	if (count >= buffer->length) {
+		buffer->length = 0;
+		return;
+	}
+
+	memmove(buffer->data, buffer->data + count, buffer->length - count);
+	buffer->length -= count;
+}
+
+static void closeClient(int index)
+{
+	SIPCClient *client = &ipcClients[index];
+
+	close(client->fd);
+	free(client->in.data);
+	free(client->out.data);
+	free(client->events);
+
+	ipcClients[index] = ipcClients[--ipcClientCount];
+	memset(&ipcClients[ipcClientCount], 0, sizeof(SIPCClient));
+}
+
+static int queueResponse(SIPCClient *client, uint32_t type, int status,
+			 const char *payload, size_t length)
+{
+	SIPCHeader header;
+	header.type   = type;
+	header.status = status;
+	header.length = length;
+
+	if (bufferReserve(&client->out, sizeof(header) + length) == -1) {
+		LOG_WARN("IPC client output buffer full, dropping\n");
+		return -1;
+	}
+
+	memcpy(client->out.data + client->out.length, &header, sizeof(header));
+	client->out.length += sizeof(header);
+	if (length) {
+		memcpy(client->out.data + client->out.length, payload, length);
+		client->out.length += length;
+	}
+
+	return 0;
+}
+
+static int queueQuery(SIPCClient *client, uint32_t type)
+{
+	long (*query)(char *, size_t) = NULL;
+
+	switch (type) {
+	case IPC_COMMAND_GET_TREE:
+		query = queryTree;
+		break;
+	case IPC_COMMAND_GET_WORKSPACES:
+		query = queryWorkspaces;
+		break;
+	case IPC_COMMAND_GET_STATS:
+		query = queryStats;
+		break;
+	default:
+		query = queryClients;
+		break;
+	}
+
+	for (size_t size = 16384; size <= IPC_MAX_RESPONSE; size *= 2) {
+		if (bufferReserve(&client->out, sizeof(SIPCHeader) + size) ==
+		    -1) {
+			break;
+		}
+
+		char *out    = client->out.data + client->out.length;
+		long  length = query(out + sizeof(SIPCHeader), size);
+		if (length == -1) {
+			continue;
+		}
+
+		SIPCHeader header;
+		header.type   = type;
+		header.status = 0;
+		header.length = length;
+		memcpy(out, &header, sizeof(header));
+		client->out.length += sizeof(header) + length;
+		return 0;
+	}
+
+	return queueResponse(client, type, 1, "State too large",
+			     strlen("State too large"));
+}
+
+static ssize_t sendFd(int socketFd, const char *data, size_t length, int fd)
+{
+	if (fd == -1) {
+		return send(socketFd, data, length, MSG_NOSIGNAL);
+	}
+
+	struct iovec iov;
+	iov.iov_base = (void *)data;
+	iov.iov_len  = length;
+
+	union {
+		char	       buffer[CMSG_SPACE(sizeof(int))];
+		struct cmsghdr align;
+	} control;
+	memset(&control, 0, sizeof(control));
+
+	struct msghdr msg;
+	memset(&msg, 0, sizeof(msg));
+	msg.msg_iov	   = &iov;
+	msg.msg_iovlen	   = 1;
+	msg.msg_control	   = control.buffer;
+	msg.msg_controllen = sizeof(control.buffer);
+
+	struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+	cmsg->cmsg_level     = SOL_SOCKET;
+	cmsg->cmsg_type	     = SCM_RIGHTS;
+	cmsg->cmsg_len	     = CMSG_LEN(sizeof(int));
+	memcpy(CMSG_DATA(cmsg), &fd, sizeof(int));
+
+	return sendmsg(socketFd, &msg, MSG_NOSIGNAL);
+}
+
+static void fillEvents(SIPCClient *client)
+{
+	while (client->eventCount > 0 &&
+	       client->out.length + sizeof(SIPCHeader) + sizeof(SIPCEvent) <=
+		   IPC_EVENT_BATCH) {
+		SIPCEvent *event = &client->events[client->eventHead];
+		event->lagged	 = client->lagged;
+
+		if (queueResponse(client, IPC_COMMAND_SUBSCRIBE, 0,
+				  (const char *)event, sizeof(SIPCEvent)) == -1) {
+			return;
+		}
+
+		client->lagged	  = 0;
+		client->eventHead = (client->eventHead + 1) % IPC_EVENT_RING_SIZE;
+		client->eventCount--;
+	}
+}
+
+static int flushClient(SIPCClient *client)
+{
+	fillEvents(client);
+
+	while (client->out.length > 0) {
+		int    fd     = client->passFd;
+		size_t length = client->out.length;
+
+		/* the fd goes with the first byte of the snapshot reply */
+		if (fd != -1 && client->passOffset > 0) {
+			fd     = -1;
+			length = client->passOffset;
+		}
+
+		ssize_t n = sendFd(client->fd, client->out.data, length, fd);
+		if (n == -1) {
+			if (errno == EINTR) {
+				continue;
+			}
+			if (errno == EAGAIN || errno == EWOULDBLOCK) {
+				return 0;
+			}
+			LOG_ERROR("Failed to send IPC response: %s\n",
+				  strerror(errno));
+			return -1;
+		}
+
+		if (fd != -1) {
+			client->passFd = -1;
+		} else if (client->passFd != -1) {
+			client->passOffset -= n;
+		}
+		bufferConsume(&client->out, n);
+		fillEvents(client);
+	}
+
+	return 0;
+}
+
+static int subscribeClient(SIPCClient *client, const char *payload,
+			   size_t length, char *errMsg, size_t size)
+{
+	char	 names[256];
+	uint32_t mask = 0;
+
+	if (length >= sizeof(names)) {
+		snprintf(errMsg, size, "Event list too long");
+		return -1;
+	}
+	memcpy(names, payload, length);
+	names[length] = '\0';
+
+	for (char *name = strtok(names, " ,\n"); name;
+	     name	= strtok(NULL, " ,\n")) {
+		int type = 0;
+		for (int i = IPC_EVENT_FOCUS; i <= IPC_EVENT_MONITOR; i++) {
+			if (strcasecmp(name, eventNames[i]) == 0) {
+				type = i;
+				break;
+			}
+		}
+
+		if (!type) {
+			snprintf(errMsg, size, "Unknown event: %s", name);
+			return -1;
+		}
+		mask |= IPC_EVENT_MASK(type);
+	}
+
+	if (!client->events) {
+		client->events = calloc(IPC_EVENT_RING_SIZE, sizeof(SIPCEvent));
+		if (!client->events) {
+			snprintf(errMsg, size, "Out of memory");
+			return -1;
+		}
+	}
+
+	client->eventMask = mask ? mask : IPC_EVENT_MASK_ALL;
+	return 0;
+}
+
+void ipcEmitEvent(EIPCEventType type, unsigned long window, int monitor,
+		  int workspace, int value)
+{
+	for (int i = 0; i < ipcClientCount; i++) {
+		SIPCClient *client = &ipcClients[i];
+		if (!(client->eventMask & IPC_EVENT_MASK(type))) {
+			continue;
+		}
+
+		if (client->eventCount == IPC_EVENT_RING_SIZE) {
+			client->eventHead =
+			    (client->eventHead + 1) % IPC_EVENT_RING_SIZE;
+			client->eventCount--;
+			client->lagged++;
+		}
+
+		int	   tail	 = (client->eventHead + client->eventCount) %
+			       IPC_EVENT_RING_SIZE;
+		SIPCEvent *event = &client->events[tail];
+
+		event->type	 = type;
+		event->lagged	 = 0;
+		event->window	 = window;
+		event->monitor	 = monitor;
+		event->workspace = workspace;
+		event->value	 = value;
+		client->eventCount++;
+	}
+}
+
+static int parseAction(char *line, SIPCAction *action, char *errMsg,
+		       size_t size)
+{
+	while (*line == ' ' || *line == '\t') {
+		line++;
+	}
+
+	char *end = line + strlen(line);
+	while (end > line && (end[-1] == ' ' || end[-1] == '\t' ||
+			      end[-1] == '\r' || end[-1] == '\n')) {
+		*--end = '\0';
+	}
+
+	if (!*line || *line == '#') {
+		action->func = NULL;
+		action->arg  = NULL;
+		return 0;
+	}
+
+	char *arg = line;
+	while (*arg && *arg != ' ' && *arg != '\t') {
+		arg++;
+	}
+	if (*arg) {
+		*arg++ = '\0';
+		while (*arg == ' ' || *arg == '\t') {
+			arg++;
+		}
+	}
+
+	action->func = getFunction(line);
+	action->arg  = *arg ? arg : NULL;
+
+	if (!action->func) {
+		snprintf(errMsg, size, "Unknown function: %s", line);
+		return -1;
+	}
+
+	if (action->arg &&
+	    !isValidFunctionArg(line, action->arg, errMsg, size)) {
+		return -1;
+	}
+
+	return 0;
+}
+
+static int runActions(const char *payload, size_t length, int single,
+		      char *errMsg, size_t size)
+{
+	char *buffer = malloc(length + 1);
+	if (!buffer) {
+		snprintf(errMsg, size, "Out of memory");
+		return -1;
+	}
+	memcpy(buffer, payload, length);
+	buffer[length] = '\0';
+
+	int lineCount = 1;
+	if (!single) {
+		for (size_t i = 0; i < length; i++) {
+			if (buffer[i] == '\n') {
+				lineCount++;
+			}
+		}
+	}
+
+	SIPCAction *actions = malloc(lineCount * sizeof(SIPCAction));
+	if (!actions) {
+		free(buffer);
+		snprintf(errMsg, size, "Out of memory");
+		return -1;
+	}
+
+	char *line = buffer;
+	for (int i = 0; i < lineCount; i++) {
+		char *next = single ? NULL : strchr(line, '\n');
+		if (next) {
+			*next++ = '\0';
+		}
+
+		char lineError[256];
+		if (parseAction(line, &actions[i], lineError,
+				sizeof(lineError)) == -1) {
+			if (single) {
+				snprintf(errMsg, size, "%s", lineError);
+			} else {
+				snprintf(errMsg, size, "line %d: %s", i + 1,
+					 lineError);
+			}
+			free(actions);
+			free(buffer);
+			return -1;
+		}
+
+		line = next;
+	}
+
+	beginUpdateBatch();
+	for (int i = 0; i < lineCount; i++) {
+		if (actions[i].func) {
+			statsRunAction(actions[i].func, actions[i].arg);
+		}
+	}
+	endUpdateBatch();
+
+	free(actions);
+	free(buffer);
+	return 0;
+}
+
+static int processIpcCommand(SIPCClient *client, SIPCHeader *header,
+			     const char *payload)
+{
+	char errMsg[512];
+
+	switch (header->type) {
+	case IPC_COMMAND_RELOAD:
+		LOG_DEBUG("Processing reload command via IPC\n");
+		reloadConfig(NULL);
+		return queueResponse(client, header->type, 0, "Config reloaded",
+				     strlen("Config reloaded"));
+
+	case IPC_COMMAND_RUN:
+	case IPC_COMMAND_BATCH:
+		if (runActions(payload, header->length,
+			       header->type == IPC_COMMAND_RUN, errMsg,
+			       sizeof(errMsg)) == -1) {
+			LOG_WARN("IPC command failed: %s\n", errMsg);
+			return queueResponse(client, header->type, 1, errMsg,
+					     strlen(errMsg));
+		}
+		return queueResponse(client, header->type, 0, NULL, 0);
+
+	case IPC_COMMAND_GET_SNAPSHOT: {
+		int fd = snapshotGetFd();
+		if (fd == -1) {
+			return queueResponse(client, header->type, 1,
+					     "Snapshot unavailable",
+					     strlen("Snapshot unavailable"));
+		}
+		/* one fd can wait for its reply at a time */
+		if (client->passFd != -1) {
+			return queueResponse(client, header->type, 1,
+					     "Snapshot request pending",
+					     strlen("Snapshot request "
+						    "pending"));
+		}
+		size_t offset = client->out.length;
+		if (queueResponse(client, header->type, 0, NULL, 0) == -1) {
+			return -1;
+		}
+		client->passFd	   = fd;
+		client->passOffset = offset;
+		return 0;
+	}
+
+	case IPC_COMMAND_GET_TREE:
+	case IPC_COMMAND_GET_WORKSPACES:
+	case IPC_COMMAND_GET_CLIENTS:
+	case IPC_COMMAND_GET_STATS:
+		return queueQuery(client, header->type);
+
+	case IPC_COMMAND_RESET_STATS:
+		statsReset();
+		return queueResponse(client, header->type, 0, NULL, 0);
+
+	case IPC_COMMAND_START_TRACE:
+		if (startTrace() == -1) {
+			return queueResponse(client, header->type, 1,
+					     "Failed to start tracing",
+					     strlen("Failed to start tracing"));
+		}
+		return queueResponse(client, header->type, 0, NULL, 0);
+
+	case IPC_COMMAND_STOP_TRACE:
+		stopTrace();
+		return queueResponse(client, header->type, 0, NULL, 0);
+
+	case IPC_COMMAND_START_RECORD: {
+		char path[RECORD_PATH_MAX];
+		char message[RECORD_PATH_MAX + 64];
+
+		snprintf(path, sizeof(path), "%.*s", (int)header->length,
+			 payload);
+		int status = startRecord(path, message, sizeof(message)) == -1;
+		return queueResponse(client, header->type, status, message,
+				     strlen(message));
+	}
+
+	case IPC_COMMAND_STOP_RECORD:
+		stopRecord();
+		return queueResponse(client, header->type, 0, NULL, 0);
+
+	case IPC_COMMAND_DUMP_TRACE: {
+		char path[TRACE_PATH_MAX];
+		char message[TRACE_PATH_MAX + 64];
+
+		snprintf(path, sizeof(path), "%.*s", (int)header->length,
+			 payload);
+		int status = dumpTrace(path, message, sizeof(message)) == -1;
+		return queueResponse(client, header->type, status, message,
+				     strlen(message));
+	}
+
+	case IPC_COMMAND_SUBSCRIBE:
+		if (subscribeClient(client, payload, header->length, errMsg,
+				    sizeof(errMsg)) == -1) {
+			return queueResponse(client, header->type, 1, errMsg,
+					     strlen(errMsg));
+		}
+		return queueResponse(client, header->type, 0, NULL, 0);
+
+	default:
+		LOG_WARN("Unknown IPC command: %u\n", header->type);
+		return queueResponse(client, header->type, 1, "Unknown command",
+				     strlen("Unknown command"));
+	}
+}
+
+int ipcReplayCommand(uint32_t type, const char *payload, uint32_t length)
+{
+	SIPCClient client;
+	SIPCHeader header = {type, 0, length};
+
+	memset(&client, 0, sizeof(client));
+	client.fd     = -1;
+	client.passFd = -1;
+
+	int result = processIpcCommand(&client, &header, payload);
+	free(client.out.data);
+	return result;
+}
+
+static int processFrames(SIPCClient *client, int *processed)
+{
+	size_t offset = 0;
+
+	while (client->in.length - offset >= sizeof(SIPCHeader)) {
+		SIPCHeader header;
+		memcpy(&header, client->in.data + offset, sizeof(header));
+
+		if (header.length > IPC_MAX_PAYLOAD) {
+			LOG_WARN("Invalid IPC message (size %u)\n",
+				 header.length);
+			return -1;
+		}
+
+		size_t frame = sizeof(header) + header.length;
+		if (client->in.length - offset < frame) {
+			break;
+		}
+
+		const char *payload = client->in.data + offset + sizeof(header);
+		recordCommand(header.type, payload, header.length);
+
+		uint64_t start	= traceBegin();
+		int	 result = processIpcCommand(client, &header, payload);
+		traceEnd(TRACE_IPC, commandName(header.type), header.length,
+			 start);
+		if (result == -1) {
+			return -1;
+		}
+
+		offset += frame;
+		(*processed)++;
+	}
+
+	bufferConsume(&client->in, offset);
 	return 0;
 }
 
+static int readClient(SIPCClient *client, int *processed)
+{
+	while (1) {
+		if (bufferReserve(&client->in, 4096) == -1) {
+			LOG_WARN("IPC client input buffer full\n");
+			return -1;
+		}
+
+		ssize_t n = read(client->fd,
+				 client->in.data + client->in.length,
+				 client->in.capacity - client->in.length);
+		if (n == 0) {
+			processFrames(client, processed);
+			return -1;
+		}
+		if (n == -1) {
+			if (errno == EINTR) {
+				continue;
+			}
+			if (errno == EAGAIN || errno == EWOULDBLOCK) {
+				return 0;
+			}
+			LOG_ERROR("IPC read error: %s\n", strerror(errno));
+			return -1;
+		}
+
+		client->in.length += n;
+		if (processFrames(client, processed) == -1) {
+			return -1;
+		}
+	}
+}
+
+static void acceptClients(void)
+{
+	while (1) {
+		int clientFd = accept4(serverSocket, NULL, NULL,
+				       SOCK_NONBLOCK | SOCK_CLOEXEC);
+		if (clientFd == -1) {
+			if (errno == EINTR) {
+				continue;
+			}
+			if (errno != EAGAIN && errno != EWOULDBLOCK) {
+				LOG_ERROR("IPC accept error: %s\n",
+					  strerror(errno));
+			}
+			return;
+		}
+
+		if (ipcClientCount >= IPC_MAX_CLIENTS) {
+			LOG_WARN("Too many IPC clients, rejecting\n");
+			close(clientFd);
+			continue;
+		}
+
+		SIPCClient *client = &ipcClients[ipcClientCount++];
+		memset(client, 0, sizeof(SIPCClient));
+		client->fd     = clientFd;
+		client->passFd = -1;
+	}
+}
+
 void ipcCleanup(void)
 {
+	while (ipcClientCount > 0) {
+		closeClient(ipcClientCount - 1);
+	}
+
 	if (serverSocket != -1) {
 		close(serverSocket);
 		serverSocket = -1;
@@ -113,63 +779,120 @@ void ipcCleanup(void)
 	}
 }
 
-static void processIpcCommand(int clientFd, SIPCMessage *msg)
+int ipcPollFds(struct pollfd *fds, int maxFds)
 {
-	SIPCMessage response;
-	response.type	= msg->type;
-	response.status = 0;
-	memset(response.data, 0, sizeof(response.data));
-
-	switch (msg->type) {
-	case IPC_COMMAND_RELOAD:
-		fprintf(stderr, "Processing reload command via IPC\n");
-		strncpy(response.data, "Config reload requested",
-			sizeof(response.data) - 1);
-		break;
+	int count = 0;
 
-	default:
-		fprintf(stderr, "Unknown IPC command: %d\n", msg->type);
-		response.status = 1;
-		strncpy(response.data, "Unknown command",
-			sizeof(response.data) - 1);
-		break;
+	if (serverSocket == -1 || maxFds <= 0) {
+		return 0;
 	}
 
-	if (write(clientFd, &response, sizeof(response)) != sizeof(response)) {
-		fprintf(stderr, "Failed to send IPC response: %s\n",
-			strerror(errno));
+	fds[count].fd	   = serverSocket;
+	fds[count].events  = POLLIN;
+	fds[count].revents = 0;
+	count++;
+
+	for (int i = 0; i < ipcClientCount && count < maxFds; i++) {
+		fds[count].fd	   = ipcClients[i].fd;
+		fds[count].events  = POLLIN;
+		fds[count].revents = 0;
+		if (ipcClients[i].out.length || ipcClients[i].eventCount) {
+			fds[count].events |= POLLOUT;
+		}
+		count++;
 	}
+
+	return count;
 }
 
-int ipcHandleCommands(void)
+int ipcHandleCommands(struct pollfd *fds, int count)
 {
+	int processed = 0;
+
 	if (serverSocket == -1) {
 		return -1;
 	}
 
-	int clientFd = accept(serverSocket, NULL, NULL);
-	if (clientFd == -1) {
-		if (errno != EAGAIN && errno != EWOULDBLOCK) {
-			fprintf(stderr, "IPC accept error: %s\n",
-				strerror(errno));
+	for (int i = 0; i < count; i++) {
+		if (!fds[i].revents || fds[i].fd == serverSocket) {
+			continue;
+		}
+
+		int index = -1;
+		for (int j = 0; j < ipcClientCount; j++) {
+			if (ipcClients[j].fd == fds[i].fd) {
+				index = j;
+				break;
+			}
+		}
+		if (index == -1) {
+			continue;
+		}
+
+		SIPCClient *client = &ipcClients[index];
+		int	    failed = 0;
+
+		if (fds[i].revents & (POLLIN | POLLHUP | POLLERR)) {
+			failed = readClient(client, &processed) == -1;
+		}
+
+		if (!failed && (client->out.length || client->eventCount)) {
+			failed = flushClient(client) == -1;
+		}
+
+		if (failed) {
+			flushClient(client);
+			closeClient(index);
 		}
-		return 0;
 	}
 
-	SIPCMessage msg;
-	ssize_t	    bytesRead = read(clientFd, &msg, sizeof(msg));
+	if (count > 0 && fds[0].fd == serverSocket &&
+	    (fds[0].revents & POLLIN)) {
+		acceptClients();
+	}
 
-	if (bytesRead == sizeof(msg)) {
-		processIpcCommand(clientFd, &msg);
-	} else {
-		fprintf(stderr, "Invalid IPC message (size %zd)\n", bytesRead);
+	return processed;
+}
+
+static int writeAll(int fd, const void *data, size_t length)
+{
+	const char *p = data;
+
+	while (length > 0) {
+		ssize_t n = write(fd, p, length);
+		if (n == -1) {
+			if (errno == EINTR) {
+				continue;
+			}
+			return -1;
+		}
+		p += n;
+		length -= n;
 	}
 
-	close(clientFd);
-	return 1;
+	return 0;
 }
 
-int ipcSendCommand(EIPCCommandType command, const char *data)
+static int readAll(int fd, void *data, size_t length)
+{
+	char *p = data;
+
+	while (length > 0) {
+		ssize_t n = read(fd, p, length);
+		if (n == -1 && errno == EINTR) {
+			continue;
+		}
+		if (n <= 0) {
+			return -1;
+		}
+		p += n;
+		length -= n;
+	}
+
+	return 0;
+}
+
+static int ipcConnect(void)
 {
 	const char *path = getSocketPath();
 
@@ -193,35 +916,148 @@ int ipcSendCommand(EIPCCommandType command, const char *data)
 		return -1;
 	}
 
-	SIPCMessage msg;
-	msg.type   = command;
-	msg.status = 0;
-	memset(msg.data, 0, sizeof(msg.data));
+	return clientFd;
+}
+
+static int ipcRequest(int clientFd, EIPCCommandType command, const char *data,
+		      SIPCHeader *response, char **payload)
+{
+	SIPCHeader header;
+	header.type   = command;
+	header.status = 0;
+	header.length = data ? strlen(data) : 0;
 
-	if (data) {
-		strncpy(msg.data, data, sizeof(msg.data) - 1);
+	if (header.length > IPC_MAX_PAYLOAD) {
+		fprintf(stderr, "IPC message too large\n");
+		return -1;
 	}
 
-	if (write(clientFd, &msg, sizeof(msg)) != sizeof(msg)) {
+	if (writeAll(clientFd, &header, sizeof(header)) == -1 ||
+	    (header.length &&
+	     writeAll(clientFd, data, header.length) == -1)) {
 		fprintf(stderr, "Failed to send command to banana: %s\n",
 			strerror(errno));
-		close(clientFd);
 		return -1;
 	}
 
-	SIPCMessage response;
-	if (read(clientFd, &response, sizeof(response)) != sizeof(response)) {
+	if (readAll(clientFd, response, sizeof(SIPCHeader)) == -1 ||
+	    response->length > IPC_MAX_RESPONSE) {
+		fprintf(stderr, "Failed to read response from banana: %s\n",
+			strerror(errno));
+		return -1;
+	}
+
+	*payload = malloc(response->length + 1);
+	if (!*payload ||
+	    readAll(clientFd, *payload, response->length) == -1) {
 		fprintf(stderr, "Failed to read response from banana: %s\n",
 			strerror(errno));
+		free(*payload);
+		*payload = NULL;
+		return -1;
+	}
+	(*payload)[response->length] = '\0';
+
+	return 0;
+}
+
+int ipcSendCommand(EIPCCommandType command, const char *data)
+{
+	int clientFd = ipcConnect();
+	if (clientFd == -1) {
+		return -1;
+	}
+
+	SIPCHeader response;
+	char	  *payload = NULL;
+	if (ipcRequest(clientFd, command, data, &response, &payload) == -1) {
+		close(clientFd);
+		return -1;
+	}
+
+	close(clientFd);
+
+	if (payload[0]) {
+		fprintf(stderr, "Banana response: %s\n", payload);
+	}
+	free(payload);
+
+	return response.status;
+}
+
+int ipcQuery(EIPCCommandType command)
+{
+	int clientFd = ipcConnect();
+	if (clientFd == -1) {
+		return -1;
+	}
+
+	SIPCHeader response;
+	char	  *payload = NULL;
+	if (ipcRequest(clientFd, command, NULL, &response, &payload) == -1) {
 		close(clientFd);
 		return -1;
 	}
 
 	close(clientFd);
 
-	if (response.data[0]) {
-		fprintf(stderr, "Banana response: %s\n", response.data);
+	if (response.status != 0) {
+		fprintf(stderr, "Banana response: %s\n", payload);
+	} else {
+		printf("%s\n", payload);
 	}
+	free(payload);
 
 	return response.status;
-}
\ No newline at end of file
+}
+
+int ipcSubscribe(const char *events)
+{
+	int clientFd = ipcConnect();
+	if (clientFd == -1) {
+		return -1;
+	}
+
+	SIPCHeader response;
+	char	  *payload = NULL;
+	if (ipcRequest(clientFd, IPC_COMMAND_SUBSCRIBE, events, &response,
+		       &payload) == -1) {
+		close(clientFd);
+		return -1;
+	}
+
+	if (response.status != 0) {
+		fprintf(stderr, "Banana response: %s\n", payload);
+		free(payload);
+		close(clientFd);
+		return -1;
+	}
+	free(payload);
+
+	SIPCHeader header;
+	SIPCEvent  event;
+	while (readAll(clientFd, &header, sizeof(header)) == 0) {
+		if (header.length != sizeof(event) ||
+		    readAll(clientFd, &event, sizeof(event)) == -1) {
+			fprintf(stderr, "Invalid event from banana\n");
+			break;
+		}
+
+		if (event.lagged) {
+			printf("lagged %u\n", event.lagged);
+		}
+
+		if (event.type < IPC_EVENT_FOCUS ||
+		    event.type > IPC_EVENT_MONITOR) {
+			continue;
+		}
+
+		printf("%s window=0x%lx monitor=%d workspace=%d value=%d\n",
+		       eventNames[event.type], (unsigned long)event.window,
+		       event.monitor, event.workspace, event.value);
+		fflush(stdout);
+	}
+
+	close(clientFd);
+	return 0;
+}
@@ -2,25 +2,95 @@
 #define IPC_H
 
 #include <stddef.h>
+#include <stdint.h>
+#include <poll.h>
 
-#define SOCKET_PATH_MAX 108
+#define SOCKET_PATH_MAX	 108
+#define IPC_MAX_CLIENTS	 32
+#define IPC_MAX_PAYLOAD	 65536
+#define IPC_MAX_RESPONSE (1024 * 1024)
+#define IPC_MAX_BUFFER	 (2 * IPC_MAX_RESPONSE)
+
+#define IPC_EVENT_RING_SIZE  256
+#define IPC_EVENT_BATCH	     4096
+#define IPC_EVENT_MASK(type) (1u << (type))
+#define IPC_EVENT_MASK_ALL   0xFFFFFFFFu
 
 typedef enum {
-	IPC_COMMAND_RELOAD = 1
+	IPC_COMMAND_RELOAD = 1,
+	IPC_COMMAND_RUN,
+	IPC_COMMAND_BATCH,
+	IPC_COMMAND_SUBSCRIBE,
+	IPC_COMMAND_GET_SNAPSHOT,
+	IPC_COMMAND_GET_TREE,
+	IPC_COMMAND_GET_WORKSPACES,
+	IPC_COMMAND_GET_CLIENTS,
+	IPC_COMMAND_GET_STATS,
+	IPC_COMMAND_RESET_STATS,
+	IPC_COMMAND_START_TRACE,
+	IPC_COMMAND_STOP_TRACE,
+	IPC_COMMAND_DUMP_TRACE,
+	IPC_COMMAND_START_RECORD,
+	IPC_COMMAND_STOP_RECORD
 } EIPCCommandType;
 
+typedef enum {
+	IPC_EVENT_FOCUS = 1,
+	IPC_EVENT_WORKSPACE,
+	IPC_EVENT_MANAGE,
+	IPC_EVENT_UNMANAGE,
+	IPC_EVENT_LAYOUT,
+	IPC_EVENT_URGENCY,
+	IPC_EVENT_MONITOR
+} EIPCEventType;
+
+/*
+ * every message on the socket is a header followed by length payload bytes,
+ * run takes a single "action [argument]" line and batch takes a newline
+ * separated list of them which is validated up front and arranged once,
+ * the reply to get_snapshot carries the state snapshot memfd as SCM_RIGHTS
+ * and the get_tree, get_workspaces, get_clients and get_stats replies are
+ * json, dump_trace takes an optional absolute path and replies with the path
+ * the trace was written to, start_record takes the absolute path to record
+ * x events and ipc commands to
+ */
+typedef struct {
+	uint32_t type;
+	int32_t	 status;
+	uint32_t length;
+} SIPCHeader;
+
+/*
+ * subscribers get one SIPCEvent per message, events are queued in a ring per
+ * subscriber and the oldest are dropped when it fills up, lagged carries the
+ * number of events dropped right before this one
+ */
 typedef struct {
-	EIPCCommandType type;
-	int		status;
-	char		data[256];
-} SIPCMessage;
+	uint32_t type;
+	uint32_t lagged;
+	uint64_t window;
+	int32_t	 monitor;
+	int32_t	 workspace;
+	int32_t	 value;
+} SIPCEvent;
 
 int  ipcInitServer(void);
 
 void ipcCleanup(void);
 
-int  ipcHandleCommands(void);
+int  ipcPollFds(struct pollfd *fds, int maxFds);
+
+int  ipcHandleCommands(struct pollfd *fds, int count);
 
 int  ipcSendCommand(EIPCCommandType command, const char *data);
 
-#endif /* IPC_H */
\ No newline at end of file
+int  ipcQuery(EIPCCommandType command);
+
+int  ipcSubscribe(const char *events);
+
+int  ipcReplayCommand(uint32_t type, const char *payload, uint32_t length);
+
+void ipcEmitEvent(EIPCEventType type, unsigned long window, int monitor,
+		  int workspace, int value);
+
+#endif /* IPC_H */
@@ -0,0 +1,105 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <fcntl.h>
+#include <spawn.h>
+#include <unistd.h>
+
+#include "launch.h"
+#include "log.h"
+#include "trace.h"
+
+extern char	 **environ;
+
+static const char *shellChars = "|&;<>()$`\\\"'*?[]{}~#=%!";
+
+static int	   needsShell(const char *command)
+{
+	return command[strcspn(command, shellChars)] != '\0';
+}
+
+static pid_t spawnArgv(const char *file, char *const argv[])
+{
+	posix_spawn_file_actions_t actions;
+	posix_spawnattr_t	   attr;
+	sigset_t		   mask;
+	pid_t			   pid = -1;
+
+	posix_spawn_file_actions_init(&actions);
+	posix_spawn_file_actions_addopen(&actions, STDIN_FILENO, "/dev/null",
+					 O_RDWR, 0);
+	posix_spawn_file_actions_adddup2(&actions, STDIN_FILENO, STDOUT_FILENO);
+	posix_spawn_file_actions_adddup2(&actions, STDIN_FILENO, STDERR_FILENO);
+
+	/* banana ignores SIGCHLD to reap children, do not pass that on */
+	posix_spawnattr_init(&attr);
+	sigemptyset(&mask);
+	posix_spawnattr_setsigmask(&attr, &mask);
+	sigaddset(&mask, SIGCHLD);
+	sigaddset(&mask, SIGPIPE);
+	posix_spawnattr_setsigdefault(&attr, &mask);
+
+	short flags = POSIX_SPAWN_SETSIGMASK | POSIX_SPAWN_SETSIGDEF;
+#ifdef POSIX_SPAWN_SETSID
+	flags |= POSIX_SPAWN_SETSID;
+#else
+	flags |= POSIX_SPAWN_SETPGROUP;
+#endif
+	posix_spawnattr_setflags(&attr, flags);
+
+	uint64_t start = traceBegin();
+	int	 err = posix_spawnp(&pid, file, &actions, &attr, argv, environ);
+	traceEnd(TRACE_SPAWN, "spawn", pid > 0 ? pid : 0, start);
+	if (err != 0) {
+		LOG_ERROR("banana: failed to spawn '%s': %s\n", argv[0],
+			  strerror(err));
+		pid = -1;
+	}
+
+	posix_spawnattr_destroy(&attr);
+	posix_spawn_file_actions_destroy(&actions);
+
+	return pid;
+}
+
+pid_t spawnCommand(const char *command)
+{
+	if (!command) {
+		return -1;
+	}
+
+	if (needsShell(command)) {
+		char *argv[] = {"sh", "-c", (char *)command, NULL};
+		return spawnArgv("/bin/sh", argv);
+	}
+
+	char *copy = strdup(command);
+	if (!copy) {
+		return -1;
+	}
+
+	char *argv[LAUNCH_MAX_ARGS + 1];
+	int   argc    = 0;
+	char *saveptr = NULL;
+
+	for (char *tok = strtok_r(copy, " \t\n", &saveptr); tok;
+	     tok       = strtok_r(NULL, " \t\n", &saveptr)) {
+		if (argc == LAUNCH_MAX_ARGS) {
+			free(copy);
+			char *shell[] = {"sh", "-c", (char *)command, NULL};
+			return spawnArgv("/bin/sh", shell);
+		}
+		argv[argc++] = tok;
+	}
+	argv[argc] = NULL;
+
+	pid_t pid = -1;
+	if (argc > 0) {
+		pid = spawnArgv(argv[0], argv);
+	}
+
+	free(copy);
+	return pid;
+}
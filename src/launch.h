@@ -0,0 +1,15 @@
+#ifndef LAUNCH_H
+#define LAUNCH_H
+
+#include <sys/types.h>
+
+#define LAUNCH_MAX_ARGS 64
+
+/*
+ * start command detached in its own session with stdio on /dev/null,
+ * commands without shell syntax are split on whitespace and executed
+ * directly, anything else goes through /bin/sh -c
+ */
+pid_t spawnCommand(const char *command);
+
+#endif /* LAUNCH_H */
@@ -0,0 +1,173 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <stdarg.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "log.h"
+
+ELogLevel	       logLevel = LOG_LEVEL_MAX;
+
+static const char     *levelNames[] = {"error", "warn", "info", "debug"};
+
+static char	       logRing[LOG_RING_SIZE];
+static size_t	       logHead	   = 0;
+static size_t	       logTail	   = 0;
+static unsigned long   logDropped  = 0;
+static int	       logRunning  = 0;
+static int	       logStopping = 0;
+static pthread_t       logThread;
+static pthread_mutex_t logMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  logCond	= PTHREAD_COND_INITIALIZER;
+
+static void	       writeAllStderr(const char *data, size_t length)
+{
+	while (length > 0) {
+		ssize_t n = write(STDERR_FILENO, data, length);
+		if (n <= 0) {
+			return;
+		}
+		data += n;
+		length -= n;
+	}
+}
+
+static void *drainLog(void *arg)
+{
+	static char buffer[LOG_RING_SIZE];
+
+	(void)arg;
+
+	pthread_mutex_lock(&logMutex);
+	while (1) {
+		while (logHead == logTail && !logDropped && !logStopping) {
+			pthread_cond_wait(&logCond, &logMutex);
+		}
+		if (logHead == logTail && !logDropped) {
+			break;
+		}
+
+		size_t length = logHead - logTail;
+		for (size_t i = 0; i < length; i++) {
+			buffer[i] = logRing[(logTail + i) % LOG_RING_SIZE];
+		}
+		logTail = logHead;
+
+		unsigned long dropped = logDropped;
+		logDropped	      = 0;
+		pthread_mutex_unlock(&logMutex);
+
+		writeAllStderr(buffer, length);
+		if (dropped) {
+			char line[64];
+			int  n = snprintf(line, sizeof(line),
+					  "banana: %lu log messages dropped\n",
+					  dropped);
+			writeAllStderr(line, n);
+		}
+
+		pthread_mutex_lock(&logMutex);
+	}
+	pthread_mutex_unlock(&logMutex);
+
+	return NULL;
+}
+
+void logWrite(const char *format, ...)
+{
+	char	line[LOG_LINE_MAX];
+	va_list args;
+
+	va_start(args, format);
+	int n = vsnprintf(line, sizeof(line), format, args);
+	va_end(args);
+
+	if (n < 0) {
+		return;
+	}
+	if ((size_t)n >= sizeof(line)) {
+		n = sizeof(line) - 1;
+	}
+
+	if (!logRunning) {
+		writeAllStderr(line, n);
+		return;
+	}
+
+	pthread_mutex_lock(&logMutex);
+	if (logHead - logTail + n > LOG_RING_SIZE) {
+		logDropped++;
+	} else {
+		for (int i = 0; i < n; i++) {
+			logRing[(logHead + i) % LOG_RING_SIZE] = line[i];
+		}
+		logHead += n;
+	}
+	pthread_cond_signal(&logCond);
+	pthread_mutex_unlock(&logMutex);
+}
+
+int parseLogLevel(const char *name)
+{
+	if (!name) {
+		return -1;
+	}
+
+	for (int i = LOG_LEVEL_ERROR; i <= LOG_LEVEL_DEBUG; i++) {
+		if (strcasecmp(name, levelNames[i]) == 0) {
+			return i;
+		}
+	}
+	return -1;
+}
+
+void setLogLevel(const char *arg)
+{
+	int level = parseLogLevel(arg);
+	if (level == -1) {
+		LOG_WARN("banana: unknown log level '%s'\n", arg ? arg : "");
+		return;
+	}
+
+	if (level > LOG_LEVEL_MAX) {
+		LOG_WARN("banana: log level '%s' is compiled out of this "
+			 "build\n",
+			 arg);
+		level = LOG_LEVEL_MAX;
+	}
+
+	logLevel = level;
+}
+
+void initLog(void)
+{
+	const char *env = getenv("BANANA_LOG");
+	if (env) {
+		setLogLevel(env);
+	}
+
+	if (pthread_create(&logThread, NULL, drainLog, NULL) != 0) {
+		return;
+	}
+
+	logRunning = 1;
+	atexit(cleanupLog);
+}
+
+void cleanupLog(void)
+{
+	if (!logRunning) {
+		return;
+	}
+
+	pthread_mutex_lock(&logMutex);
+	logStopping = 1;
+	pthread_cond_signal(&logCond);
+	pthread_mutex_unlock(&logMutex);
+
+	pthread_join(logThread, NULL);
+	logRunning  = 0;
+	logStopping = 0;
+}
@@ -0,0 +1,47 @@
+#ifndef LOG_H
+#define LOG_H
+
+typedef enum {
+	LOG_LEVEL_ERROR,
+	LOG_LEVEL_WARN,
+	LOG_LEVEL_INFO,
+	LOG_LEVEL_DEBUG
+} ELogLevel;
+
+/*
+ * messages above LOG_LEVEL_MAX are compiled out entirely, release builds set
+ * it to LOG_LEVEL_WARN, messages above logLevel are skipped before any
+ * formatting happens
+ */
+#ifndef LOG_LEVEL_MAX
+#define LOG_LEVEL_MAX LOG_LEVEL_DEBUG
+#endif
+
+#define LOG_RING_SIZE (64 * 1024)
+#define LOG_LINE_MAX  1024
+
+#define LOG(level, ...)                                                        \
+	do {                                                                   \
+		if ((level) <= LOG_LEVEL_MAX && (level) <= logLevel) {         \
+			logWrite(__VA_ARGS__);                                 \
+		}                                                              \
+	} while (0)
+
+#define LOG_ERROR(...) LOG(LOG_LEVEL_ERROR, __VA_ARGS__)
+#define LOG_WARN(...)  LOG(LOG_LEVEL_WARN, __VA_ARGS__)
+#define LOG_INFO(...)  LOG(LOG_LEVEL_INFO, __VA_ARGS__)
+#define LOG_DEBUG(...) LOG(LOG_LEVEL_DEBUG, __VA_ARGS__)
+
+extern ELogLevel logLevel;
+
+void logWrite(const char *format, ...) __attribute__((format(printf, 1, 2)));
+
+int  parseLogLevel(const char *name);
+
+void setLogLevel(const char *arg);
+
+void initLog(void);
+
+void cleanupLog(void);
+
+#endif /* LOG_H */
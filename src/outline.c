@@ -0,0 +1,77 @@
+#include <stdio.h>
+#include <X11/Xlib.h>
+
+#include "outline.h"
+#include "backend.h"
+#include "banana.h"
+#include "config.h"
+#include "log.h"
+
+extern unsigned long getActiveBorderPixel(void);
+
+static Window	     outlineEdges[OUTLINE_EDGES];
+static int	     outlineShown = 0;
+
+/* created per drag, so a reloaded border color is picked up */
+static int createOutline(void)
+{
+	XSetWindowAttributes wa;
+	wa.override_redirect = True;
+	wa.background_pixel  = getActiveBorderPixel();
+
+	for (int i = 0; i < OUTLINE_EDGES; i++) {
+		outlineEdges[i] = XCreateWindow(
+		    display, root, 0, 0, 1, 1, 0, CopyFromParent, InputOutput,
+		    CopyFromParent, CWOverrideRedirect | CWBackPixel, &wa);
+		if (!outlineEdges[i]) {
+			LOG_ERROR("Failed to create outline window\n");
+			hideOutline();
+			return 0;
+		}
+	}
+
+	return 1;
+}
+
+void showOutline(int x, int y, int width, int height)
+{
+	int created = 0;
+	if (!outlineShown) {
+		if (!createOutline()) {
+			return;
+		}
+		outlineShown = 1;
+		created	     = 1;
+	}
+
+	int edge       = MAX(borderWidth, OUTLINE_MIN_WIDTH);
+	int fullWidth  = width + 2 * borderWidth;
+	int fullHeight = height + 2 * borderWidth;
+	int sideHeight = MAX(fullHeight - 2 * edge, 1);
+
+	backend->moveResizeWindow(display, outlineEdges[0], x, y, fullWidth,
+				  edge);
+	backend->moveResizeWindow(display, outlineEdges[1], x,
+				  y + fullHeight - edge, fullWidth, edge);
+	backend->moveResizeWindow(display, outlineEdges[2], x, y + edge, edge,
+				  sideHeight);
+	backend->moveResizeWindow(display, outlineEdges[3],
+				  x + fullWidth - edge, y + edge, edge,
+				  sideHeight);
+
+	/* mapped once they are in place, later motion only moves them */
+	for (int i = 0; created && i < OUTLINE_EDGES; i++) {
+		backend->mapWindow(display, outlineEdges[i]);
+	}
+}
+
+void hideOutline(void)
+{
+	for (int i = 0; i < OUTLINE_EDGES; i++) {
+		if (outlineEdges[i]) {
+			XDestroyWindow(display, outlineEdges[i]);
+			outlineEdges[i] = None;
+		}
+	}
+	outlineShown = 0;
+}
@@ -0,0 +1,17 @@
+#ifndef OUTLINE_H
+#define OUTLINE_H
+
+#define OUTLINE_EDGES	  4
+#define OUTLINE_MIN_WIDTH 2
+
+/*
+ * the frame a window being moved or resized in outline mode would get, drawn
+ * as four override-redirect strips above everything so nothing underneath
+ * has to repaint, x, y, width and height are the client geometry without
+ * the border
+ */
+void showOutline(int x, int y, int width, int height);
+
+void hideOutline(void);
+
+#endif /* OUTLINE_H */
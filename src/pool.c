@@ -0,0 +1,209 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <errno.h>
+
+#include "pool.h"
+#include "banana.h"
+#include "config.h"
+#include "launch.h"
+#include "proc.h"
+#include "log.h"
+
+typedef struct {
+	char  *command;
+	pid_t  pending[MAX_PREWARM_COUNT];
+	int    pendingCount;
+	Window ready[MAX_PREWARM_COUNT];
+	int    readyCount;
+} SPool;
+
+static SPool pools[MAX_PREWARMS];
+static int   poolCount = 0;
+
+static void  removeReady(SPool *pool, int index)
+{
+	memmove(&pool->ready[index], &pool->ready[index + 1],
+		(pool->readyCount - index - 1) * sizeof(Window));
+	pool->readyCount--;
+}
+
+static void removePending(SPool *pool, int index)
+{
+	memmove(&pool->pending[index], &pool->pending[index + 1],
+		(pool->pendingCount - index - 1) * sizeof(pid_t));
+	pool->pendingCount--;
+}
+
+static void trimPool(SPool *pool, int size)
+{
+	while (pool->pendingCount > 0 &&
+	       pool->pendingCount + pool->readyCount > size) {
+		kill(pool->pending[pool->pendingCount - 1], SIGTERM);
+		pool->pendingCount--;
+	}
+
+	while (pool->readyCount > size) {
+		XKillClient(display, pool->ready[pool->readyCount - 1]);
+		pool->readyCount--;
+	}
+}
+
+static void fillPool(SPool *pool)
+{
+	for (int i = pool->pendingCount - 1; i >= 0; i--) {
+		if (kill(pool->pending[i], 0) == -1 && errno == ESRCH) {
+			removePending(pool, i);
+		}
+	}
+
+	while (pool->pendingCount + pool->readyCount < prewarmCount) {
+		pid_t pid = spawnCommand(pool->command);
+		if (pid <= 0) {
+			break;
+		}
+		pool->pending[pool->pendingCount++] = pid;
+	}
+}
+
+static void releasePool(SPool *pool)
+{
+	trimPool(pool, 0);
+	free(pool->command);
+	pool->command = NULL;
+}
+
+void refreshPools(void)
+{
+	SPool next[MAX_PREWARMS];
+	int   nextCount = 0;
+
+	memset(next, 0, sizeof(next));
+
+	for (size_t i = 0; i < prewarmsCount; i++) {
+		char *command = substituteVariables(prewarms[i].command);
+		if (!command) {
+			continue;
+		}
+
+		SPool *pool = &next[nextCount++];
+		for (int j = 0; j < poolCount; j++) {
+			if (pools[j].command &&
+			    strcmp(pools[j].command, command) == 0) {
+				*pool		 = pools[j];
+				pools[j].command = NULL;
+				break;
+			}
+		}
+
+		if (pool->command) {
+			free(command);
+		} else {
+			pool->command = command;
+		}
+	}
+
+	for (int i = 0; i < poolCount; i++) {
+		if (pools[i].command) {
+			releasePool(&pools[i]);
+		}
+	}
+
+	memcpy(pools, next, sizeof(pools));
+	poolCount = nextCount;
+
+	for (int i = 0; i < poolCount; i++) {
+		trimPool(&pools[i], prewarmCount);
+		fillPool(&pools[i]);
+	}
+}
+
+int claimPooledWindow(Window window)
+{
+	int waiting = 0;
+	for (int i = 0; i < poolCount; i++) {
+		waiting += pools[i].pendingCount;
+	}
+	if (!waiting) {
+		return 0;
+	}
+
+	int pid = getWindowPID(window);
+	if (pid <= 0) {
+		return 0;
+	}
+
+	resetProcessCache();
+	for (int i = 0; i < poolCount; i++) {
+		SPool *pool = &pools[i];
+		for (int j = 0; j < pool->pendingCount; j++) {
+			if (pool->pending[j] != pid &&
+			    !isChildProcess(pool->pending[j], pid)) {
+				continue;
+			}
+
+			removePending(pool, j);
+			pool->ready[pool->readyCount++] = window;
+			LOG_INFO("Prewarmed window 0x%lx for '%s'\n", window,
+				 pool->command);
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+int takePooledWindow(const char *command)
+{
+	for (int i = 0; i < poolCount; i++) {
+		SPool *pool = &pools[i];
+		if (strcmp(pool->command, command) != 0) {
+			continue;
+		}
+
+		while (pool->readyCount > 0) {
+			Window		  window = pool->ready[0];
+			XWindowAttributes wa;
+
+			removeReady(pool, 0);
+			if (!XGetWindowAttributes(display, window, &wa)) {
+				continue;
+			}
+
+			XEvent event		 = {0};
+			event.xmaprequest.type	 = MapRequest;
+			event.xmaprequest.parent   = root;
+			event.xmaprequest.window   = window;
+			handleMapRequest(&event);
+
+			fillPool(pool);
+			return 1;
+		}
+
+		fillPool(pool);
+		return 0;
+	}
+
+	return 0;
+}
+
+void forgetPooledWindow(Window window)
+{
+	for (int i = 0; i < poolCount; i++) {
+		for (int j = 0; j < pools[i].readyCount; j++) {
+			if (pools[i].ready[j] == window) {
+				removeReady(&pools[i], j);
+				return;
+			}
+		}
+	}
+}
+
+void cleanupPools(void)
+{
+	for (int i = 0; i < poolCount; i++) {
+		releasePool(&pools[i]);
+	}
+	poolCount = 0;
+}
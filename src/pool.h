@@ -0,0 +1,21 @@
+#ifndef POOL_H
+#define POOL_H
+
+#include <X11/Xlib.h>
+
+/*
+ * programs listed with prewarm are started ahead of time, their first window
+ * is left unmapped when it asks to be mapped and is handed out by the next
+ * spawn of the same command, which starts a replacement right away
+ */
+void refreshPools(void);
+
+int  claimPooledWindow(Window window);
+
+int  takePooledWindow(const char *command);
+
+void forgetPooledWindow(Window window);
+
+void cleanupPools(void);
+
+#endif /* POOL_H */
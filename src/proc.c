@@ -0,0 +1,504 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <dirent.h>
+#include <sys/socket.h>
+#include <linux/netlink.h>
+#include <linux/connector.h>
+#include <linux/cn_proc.h>
+
+#include "proc.h"
+#include "log.h"
+
+typedef struct {
+	int pid;
+	int ppid;
+} SProcEntry;
+
+static SProcEntry processCache[PROC_CACHE_SIZE];
+static int	  processCacheCount = 0;
+
+static SProcEntry processTable[PROC_TABLE_SIZE];
+static int	  processTableCount = 0;
+static int	  trackedRoots[PROC_MAX_ROOTS];
+static int	  trackedRootCount = 0;
+static int	  trackerFd	   = -1;
+
+static int	  readParentPid(int pid)
+{
+	char path[64];
+	char buffer[512];
+
+	snprintf(path, sizeof(path), "/proc/%d/stat", pid);
+
+	int fd = open(path, O_RDONLY | O_CLOEXEC);
+	if (fd == -1) {
+		return -1;
+	}
+
+	ssize_t n = read(fd, buffer, sizeof(buffer) - 1);
+	close(fd);
+	if (n <= 0) {
+		return -1;
+	}
+	buffer[n] = '\0';
+
+	char *p = strrchr(buffer, ')');
+	if (!p) {
+		return -1;
+	}
+
+	int  ppid  = -1;
+	char state = 0;
+	if (sscanf(p + 1, " %c %d", &state, &ppid) != 2) {
+		return -1;
+	}
+
+	return ppid;
+}
+
+int getParentPid(int pid)
+{
+	for (int i = 0; i < processCacheCount; i++) {
+		if (processCache[i].pid == pid) {
+			return processCache[i].ppid;
+		}
+	}
+
+	int ppid = readParentPid(pid);
+
+	if (processCacheCount < PROC_CACHE_SIZE) {
+		processCache[processCacheCount].pid  = pid;
+		processCache[processCacheCount].ppid = ppid;
+		processCacheCount++;
+	}
+
+	return ppid;
+}
+
+static int isTrackedRoot(int pid)
+{
+	for (int i = 0; i < trackedRootCount; i++) {
+		if (trackedRoots[i] == pid) {
+			return 1;
+		}
+	}
+	return 0;
+}
+
+static unsigned int tableSlot(int pid)
+{
+	return ((unsigned int)pid * 2654435761u) & (PROC_TABLE_SIZE - 1);
+}
+
+static int findEntry(int pid)
+{
+	unsigned int i = tableSlot(pid);
+
+	while (processTable[i].pid) {
+		if (processTable[i].pid == pid) {
+			return i;
+		}
+		i = (i + 1) & (PROC_TABLE_SIZE - 1);
+	}
+	return -1;
+}
+
+static void stopTracker(const char *reason)
+{
+	if (trackerFd == -1) {
+		return;
+	}
+
+	LOG_WARN("Process tracker stopped (%s), falling back to /proc\n",
+		 reason);
+	cleanupProcessTracker();
+}
+
+static void insertEntry(int pid, int ppid)
+{
+	int index = findEntry(pid);
+	if (index != -1) {
+		processTable[index].ppid = ppid;
+		return;
+	}
+
+	if (processTableCount >= PROC_TABLE_SIZE * 3 / 4) {
+		stopTracker("process table full");
+		return;
+	}
+
+	unsigned int i = tableSlot(pid);
+	while (processTable[i].pid) {
+		i = (i + 1) & (PROC_TABLE_SIZE - 1);
+	}
+
+	processTable[i].pid  = pid;
+	processTable[i].ppid = ppid;
+	processTableCount++;
+}
+
+static void removeEntry(int index)
+{
+	unsigned int hole = index;
+	unsigned int i	  = hole;
+
+	processTable[hole].pid = 0;
+	processTableCount--;
+
+	while (1) {
+		i = (i + 1) & (PROC_TABLE_SIZE - 1);
+		if (!processTable[i].pid) {
+			break;
+		}
+
+		unsigned int home = tableSlot(processTable[i].pid);
+		if (((i - home) & (PROC_TABLE_SIZE - 1)) >=
+		    ((i - hole) & (PROC_TABLE_SIZE - 1))) {
+			processTable[hole]  = processTable[i];
+			processTable[i].pid = 0;
+			hole		       = i;
+		}
+	}
+}
+
+static int isTracked(int pid)
+{
+	return isTrackedRoot(pid) || findEntry(pid) != -1;
+}
+
+static void forgetProcess(int pid)
+{
+	int index = findEntry(pid);
+	if (index == -1) {
+		return;
+	}
+
+	int ppid = processTable[index].ppid;
+	removeEntry(index);
+
+	/* keep the ancestry of orphans so they can still be swallowed */
+	for (int i = 0; i < PROC_TABLE_SIZE; i++) {
+		if (processTable[i].pid && processTable[i].ppid == pid) {
+			processTable[i].ppid = ppid;
+		}
+	}
+}
+
+/* drops every entry that no longer descends from a tracked root */
+static void pruneDescendants(void)
+{
+	int stale[PROC_TABLE_SIZE];
+	int count = 0;
+
+	for (int i = 0; i < PROC_TABLE_SIZE; i++) {
+		if (!processTable[i].pid) {
+			continue;
+		}
+
+		int pid	  = processTable[i].ppid;
+		int found = 0;
+		for (int depth = 0; depth < PROC_MAX_DEPTH && pid > 0;
+		     depth++) {
+			if (isTrackedRoot(pid)) {
+				found = 1;
+				break;
+			}
+			int index = findEntry(pid);
+			if (index == -1) {
+				break;
+			}
+			pid = processTable[index].ppid;
+		}
+
+		if (!found) {
+			stale[count++] = processTable[i].pid;
+		}
+	}
+
+	for (int i = 0; i < count; i++) {
+		int index = findEntry(stale[i]);
+		if (index != -1) {
+			removeEntry(index);
+		}
+	}
+}
+
+static void seedDescendants(void)
+{
+	DIR *dir = opendir("/proc");
+	if (!dir) {
+		stopTracker("cannot read /proc");
+		return;
+	}
+
+	SProcEntry    *entries	= NULL;
+	int	       count	= 0;
+	int	       capacity = 0;
+	struct dirent *ent;
+
+	while ((ent = readdir(dir))) {
+		int pid = atoi(ent->d_name);
+		if (pid <= 0) {
+			continue;
+		}
+
+		if (count == capacity) {
+			capacity	 = capacity ? capacity * 2 : 256;
+			SProcEntry *grow = realloc(entries, capacity *
+								sizeof(SProcEntry));
+			if (!grow) {
+				break;
+			}
+			entries = grow;
+		}
+
+		entries[count].pid  = pid;
+		entries[count].ppid = readParentPid(pid);
+		count++;
+	}
+	closedir(dir);
+
+	int changed = 1;
+	while (changed && trackerFd != -1) {
+		changed = 0;
+		for (int i = 0; i < count; i++) {
+			if (entries[i].pid && isTracked(entries[i].ppid) &&
+			    findEntry(entries[i].pid) == -1) {
+				insertEntry(entries[i].pid, entries[i].ppid);
+				entries[i].pid = 0;
+				changed	       = 1;
+			}
+		}
+	}
+
+	free(entries);
+}
+
+int initProcessTracker(void)
+{
+	trackerFd = socket(PF_NETLINK,
+			   SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC,
+			   NETLINK_CONNECTOR);
+	if (trackerFd == -1) {
+		LOG_INFO("Process tracker unavailable: %s\n", strerror(errno));
+		return -1;
+	}
+
+	struct sockaddr_nl addr = {0};
+	addr.nl_family		= AF_NETLINK;
+	addr.nl_groups		= CN_IDX_PROC;
+
+	if (bind(trackerFd, (struct sockaddr *)&addr, sizeof(addr)) == -1) {
+		LOG_INFO("Process tracker unavailable: %s\n", strerror(errno));
+		cleanupProcessTracker();
+		return -1;
+	}
+
+	char		      buffer[NLMSG_SPACE(sizeof(struct cn_msg) +
+						 sizeof(enum proc_cn_mcast_op))] = {0};
+	struct nlmsghdr	     *nlh = (struct nlmsghdr *)buffer;
+	struct cn_msg	     *msg = NLMSG_DATA(nlh);
+	enum proc_cn_mcast_op op  = PROC_CN_MCAST_LISTEN;
+
+	nlh->nlmsg_len	= NLMSG_LENGTH(sizeof(struct cn_msg) + sizeof(op));
+	nlh->nlmsg_type = NLMSG_DONE;
+	nlh->nlmsg_pid	= getpid();
+	msg->id.idx	= CN_IDX_PROC;
+	msg->id.val	= CN_VAL_PROC;
+	msg->len	= sizeof(op);
+	memcpy(msg->data, &op, sizeof(op));
+
+	if (send(trackerFd, buffer, nlh->nlmsg_len, 0) == -1) {
+		LOG_INFO("Process tracker unavailable: %s\n", strerror(errno));
+		cleanupProcessTracker();
+		return -1;
+	}
+
+	return 0;
+}
+
+int getProcessTrackerFd(void)
+{
+	return trackerFd;
+}
+
+static void handleProcessEvent(struct proc_event *ev)
+{
+	switch (ev->what) {
+	case PROC_EVENT_NONE:
+		if (ev->event_data.ack.err) {
+			stopTracker(strerror(ev->event_data.ack.err));
+		}
+		break;
+	case PROC_EVENT_FORK:
+		if (ev->event_data.fork.child_pid ==
+			ev->event_data.fork.child_tgid &&
+		    isTracked(ev->event_data.fork.parent_tgid)) {
+			insertEntry(ev->event_data.fork.child_tgid,
+				    ev->event_data.fork.parent_tgid);
+		}
+		break;
+	case PROC_EVENT_EXIT:
+		if (ev->event_data.exit.process_pid ==
+		    ev->event_data.exit.process_tgid) {
+			forgetProcess(ev->event_data.exit.process_tgid);
+			/* its pid can be reused by an unrelated process */
+			untrackProcess(ev->event_data.exit.process_tgid);
+		}
+		break;
+	default:
+		break;
+	}
+}
+
+void handleProcessEvents(void)
+{
+	char buffer[PROC_BUFFER_SIZE]
+	    __attribute__((aligned(NLMSG_ALIGNTO)));
+
+	while (trackerFd != -1) {
+		int len = recv(trackerFd, buffer, sizeof(buffer), 0);
+		if (len == -1) {
+			if (errno == ENOBUFS) {
+				stopTracker("process events were dropped");
+			} else if (errno != EAGAIN && errno != EINTR) {
+				stopTracker(strerror(errno));
+			}
+			return;
+		}
+		if (len == 0) {
+			stopTracker("connector closed");
+			return;
+		}
+
+		for (struct nlmsghdr *nlh = (struct nlmsghdr *)buffer;
+		     NLMSG_OK(nlh, len); nlh = NLMSG_NEXT(nlh, len)) {
+			if (nlh->nlmsg_type == NLMSG_ERROR ||
+			    nlh->nlmsg_type == NLMSG_OVERRUN) {
+				stopTracker("connector error");
+				return;
+			}
+			if (nlh->nlmsg_type == NLMSG_NOOP) {
+				continue;
+			}
+
+			struct cn_msg *msg = NLMSG_DATA(nlh);
+			if (msg->id.idx != CN_IDX_PROC ||
+			    msg->id.val != CN_VAL_PROC) {
+				continue;
+			}
+
+			handleProcessEvent((struct proc_event *)msg->data);
+			if (trackerFd == -1) {
+				return;
+			}
+		}
+	}
+}
+
+void trackProcess(int pid)
+{
+	if (trackerFd == -1 || pid <= 0) {
+		return;
+	}
+
+	if (trackedRootCount >= PROC_MAX_ROOTS) {
+		stopTracker("too many tracked processes");
+		return;
+	}
+
+	int known		       = isTracked(pid);
+	trackedRoots[trackedRootCount++] = pid;
+
+	if (!known) {
+		seedDescendants();
+	}
+}
+
+void untrackProcess(int pid)
+{
+	for (int i = 0; i < trackedRootCount; i++) {
+		if (trackedRoots[i] == pid) {
+			trackedRoots[i] = trackedRoots[--trackedRootCount];
+			pruneDescendants();
+			return;
+		}
+	}
+}
+
+void cleanupProcessTracker(void)
+{
+	if (trackerFd != -1) {
+		close(trackerFd);
+		trackerFd = -1;
+	}
+
+	memset(processTable, 0, sizeof(processTable));
+	processTableCount = 0;
+	trackedRootCount  = 0;
+}
+
+/* -1 when the table does not know childPid, the caller asks /proc then */
+static int trackedChild(int parentPid, int childPid)
+{
+	int pid = childPid;
+	for (int depth = 0; depth < PROC_MAX_DEPTH; depth++) {
+		int index = findEntry(pid);
+		if (index == -1) {
+			return -1;
+		}
+		pid = processTable[index].ppid;
+		if (pid == parentPid) {
+			return 1;
+		}
+		if (isTrackedRoot(pid)) {
+			return 0;
+		}
+	}
+	return 0;
+}
+
+int isChildProcess(int parentPid, int childPid)
+{
+	if (parentPid <= 0 || childPid <= 0) {
+		LOG_WARN("Invalid PIDs for child process check: parent=%d, "
+			 "child=%d\n",
+			 parentPid, childPid);
+		return 0;
+	}
+
+	if (trackerFd != -1 && isTrackedRoot(parentPid)) {
+		int result = trackedChild(parentPid, childPid);
+
+		/* the fork can still be queued behind the map request */
+		if (result == -1) {
+			handleProcessEvents();
+			if (trackerFd != -1 && isTrackedRoot(parentPid)) {
+				result = trackedChild(parentPid, childPid);
+			}
+		}
+
+		if (result != -1) {
+			return result;
+		}
+	}
+
+	int pid = childPid;
+	for (int depth = 0; depth < PROC_MAX_DEPTH && pid > 1; depth++) {
+		pid = getParentPid(pid);
+		if (pid == parentPid) {
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+void resetProcessCache(void)
+{
+	processCacheCount = 0;
+}
@@ -0,0 +1,35 @@
+#ifndef PROC_H
+#define PROC_H
+
+#define PROC_CACHE_SIZE	 64
+#define PROC_MAX_DEPTH	 64
+#define PROC_TABLE_SIZE	 4096
+#define PROC_MAX_ROOTS	 64
+#define PROC_BUFFER_SIZE 8192
+
+int  getParentPid(int pid);
+
+int  isChildProcess(int parentPid, int childPid);
+
+void resetProcessCache(void);
+
+/*
+ * the tracker follows fork and exit events from the netlink proc connector
+ * and keeps the parent of every descendant of a tracked pid in memory, so
+ * isChildProcess does not touch /proc for tracked parents, it needs
+ * CAP_NET_ADMIN and everything falls back to walking /proc without it or
+ * once events have been lost
+ */
+int  initProcessTracker(void);
+
+int  getProcessTrackerFd(void);
+
+void handleProcessEvents(void);
+
+void trackProcess(int pid);
+
+void untrackProcess(int pid);
+
+void cleanupProcessTracker(void);
+
+#endif /* PROC_H */
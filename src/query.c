@@ -0,0 +1,308 @@
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include <limits.h>
+
+#include "query.h"
+#include "banana.h"
+#include "config.h"
+#include "stats.h"
+
+typedef struct {
+	char  *data;
+	size_t size;
+	size_t length;
+} SJson;
+
+static const char *layoutNames[] = {"floating", "tiled", "monocle"};
+
+static void	   jsonAppend(SJson *json, const char *format, ...)
+{
+	if (json->length >= json->size) {
+		return;
+	}
+
+	va_list args;
+	va_start(args, format);
+	int n = vsnprintf(json->data + json->length, json->size - json->length,
+			  format, args);
+	va_end(args);
+
+	if (n < 0) {
+		json->length = json->size;
+		return;
+	}
+	json->length += n;
+}
+
+static void jsonString(SJson *json, const char *str)
+{
+	jsonAppend(json, "\"");
+
+	for (const unsigned char *p = (const unsigned char *)str; *p; p++) {
+		if (json->length + 7 >= json->size) {
+			json->length = json->size;
+			return;
+		}
+
+		if (*p == '"' || *p == '\\') {
+			json->data[json->length++] = '\\';
+			json->data[json->length++] = *p;
+		} else if (*p < 0x20) {
+			json->length += snprintf(json->data + json->length, 7,
+						 "\\u%04x", *p);
+		} else {
+			json->data[json->length++] = *p;
+		}
+	}
+
+	jsonAppend(json, "\"");
+}
+
+static const char *layoutName(ELayout layout)
+{
+	if (layout < LAYOUT_FLOATING || layout > LAYOUT_MONOCLE) {
+		return "unknown";
+	}
+	return layoutNames[layout];
+}
+
+static void writeGeometry(SJson *json, const char *name, int x, int y,
+			  int width, int height)
+{
+	jsonAppend(json,
+		   ",\"%s\":{\"x\":%d,\"y\":%d,\"width\":%d,\"height\":%d}",
+		   name, x, y, width, height);
+}
+
+static void writeClient(SJson *json, SClient *c)
+{
+	jsonAppend(json, "{\"window\":%lu,\"class\":", c->window);
+	jsonString(json, c->className);
+	jsonAppend(json, ",\"instance\":");
+	jsonString(json, c->instanceName);
+	jsonAppend(json, ",\"title\":");
+	jsonString(json, c->title);
+
+	jsonAppend(json,
+		   ",\"pid\":%d,\"monitor\":%d,\"workspace\":%d,"
+		   "\"focused\":%s,\"floating\":%s,\"fullscreen\":%s,"
+		   "\"dock\":%s,\"urgent\":%s,\"swallowing\":%s",
+		   c->pid, c->monitor, c->workspace == INT_MAX ? -2 : c->workspace,
+		   c == focused ? "true" : "false",
+		   c->isFloating ? "true" : "false",
+		   c->isFullscreen ? "true" : "false",
+		   c->isDock ? "true" : "false", c->isUrgent ? "true" : "false",
+		   c->isSwallowing ? "true" : "false");
+
+	writeGeometry(json, "geometry", c->x, c->y, c->width, c->height);
+	if (c->isFullscreen) {
+		writeGeometry(json, "restore_geometry", c->oldx, c->oldy,
+			      c->oldwidth, c->oldheight);
+	}
+
+	jsonAppend(json, ",\"swallowed_by\":%lu,\"swallowed\":%lu",
+		   c->swallowedBy ? c->swallowedBy->window : 0,
+		   c->swallowed ? c->swallowed->window : 0);
+
+	jsonAppend(json, "}");
+}
+
+static void writeWorkspace(SJson *json, SMonitor *m, int ws, int withClients)
+{
+	int count  = 0;
+	int urgent = 0;
+
+	for (SClient *c = clients; c; c = c->next) {
+		if (c->monitor == m->num && c->workspace == ws) {
+			count++;
+			urgent |= c->isUrgent;
+		}
+	}
+
+	jsonAppend(json,
+		   "{\"num\":%d,\"monitor\":%d,\"visible\":%s,\"layout\":\"%s\","
+		   "\"master_factor\":%.3f,\"urgent\":%s,\"count\":%d",
+		   ws, m->num, m->currentWorkspace == ws ? "true" : "false",
+		   layoutName(m->workspaceLayouts[ws]), m->masterFactors[ws],
+		   urgent ? "true" : "false", count);
+
+	if (withClients) {
+		int first = 1;
+
+		jsonAppend(json, ",\"clients\":[");
+		for (SClient *c = clients; c; c = c->next) {
+			if (c->monitor != m->num || c->workspace != ws) {
+				continue;
+			}
+			if (!first) {
+				jsonAppend(json, ",");
+			}
+			writeClient(json, c);
+			first = 0;
+		}
+		jsonAppend(json, "]");
+	}
+
+	jsonAppend(json, "}");
+}
+
+static long finish(SJson *json)
+{
+	if (json->length >= json->size) {
+		return -1;
+	}
+	return json->length;
+}
+
+long queryTree(char *out, size_t size)
+{
+	SJson json = {out, size, 0};
+
+	jsonAppend(&json, "{\"focused\":%lu,\"monitors\":[",
+		   focused ? focused->window : 0);
+
+	for (int i = 0; i < numMonitors; i++) {
+		SMonitor *m = &monitors[i];
+
+		jsonAppend(&json, "%s{\"num\":%d", i ? "," : "", m->num);
+		writeGeometry(&json, "geometry", m->x, m->y, m->width,
+			      m->height);
+		jsonAppend(&json,
+			   ",\"current_workspace\":%d,\"layout\":\"%s\","
+			   "\"workspaces\":[",
+			   m->currentWorkspace, layoutName(m->currentLayout));
+
+		for (int ws = 0; ws < workspaceCount; ws++) {
+			if (ws) {
+				jsonAppend(&json, ",");
+			}
+			writeWorkspace(&json, m, ws, 1);
+		}
+
+		int first = 1;
+		jsonAppend(&json, "],\"docks\":[");
+		for (SClient *c = clients; c; c = c->next) {
+			if (c->monitor != m->num || !c->isDock) {
+				continue;
+			}
+			if (!first) {
+				jsonAppend(&json, ",");
+			}
+			writeClient(&json, c);
+			first = 0;
+		}
+		jsonAppend(&json, "]}");
+	}
+
+	int first = 1;
+	jsonAppend(&json, "],\"hidden\":[");
+	for (SClient *c = clients; c; c = c->next) {
+		if (c->workspace != INT_MAX) {
+			continue;
+		}
+		if (!first) {
+			jsonAppend(&json, ",");
+		}
+		writeClient(&json, c);
+		first = 0;
+	}
+
+	jsonAppend(&json, "]}");
+	return finish(&json);
+}
+
+long queryWorkspaces(char *out, size_t size)
+{
+	SJson json = {out, size, 0};
+
+	jsonAppend(&json, "[");
+	for (int i = 0; i < numMonitors; i++) {
+		for (int ws = 0; ws < workspaceCount; ws++) {
+			if (i || ws) {
+				jsonAppend(&json, ",");
+			}
+			writeWorkspace(&json, &monitors[i], ws, 0);
+		}
+	}
+	jsonAppend(&json, "]");
+
+	return finish(&json);
+}
+
+long queryClients(char *out, size_t size)
+{
+	SJson json = {out, size, 0};
+	int   first = 1;
+
+	jsonAppend(&json, "[");
+	for (SClient *c = clients; c; c = c->next) {
+		if (!first) {
+			jsonAppend(&json, ",");
+		}
+		writeClient(&json, c);
+		first = 0;
+	}
+	jsonAppend(&json, "]");
+
+	return finish(&json);
+}
+
+static void writeHistograms(SJson *json, const SHistogram *histograms,
+			    int count, const char *(*name)(int))
+{
+	int first = 1;
+
+	for (int i = 0; i < count; i++) {
+		const SHistogram *h = &histograms[i];
+
+		if (!h->count || !name(i)) {
+			continue;
+		}
+
+		jsonAppend(json, "%s", first ? "" : ",");
+		jsonString(json, name(i));
+		jsonAppend(json,
+			   ":{\"count\":%llu,\"mean_us\":%.3f,\"p50_us\":%.3f,"
+			   "\"p90_us\":%.3f,\"p99_us\":%.3f,\"max_us\":%.3f}",
+			   (unsigned long long)h->count,
+			   h->sum / 1000.0 / h->count,
+			   statsPercentile(h, 0.5) / 1000.0,
+			   statsPercentile(h, 0.9) / 1000.0,
+			   statsPercentile(h, 0.99) / 1000.0, h->max / 1000.0);
+		first = 0;
+	}
+}
+
+static const char *actionName(int index)
+{
+	for (int i = 0; functionMap[i].name; i++) {
+		if (i == index) {
+			return functionMap[i].name;
+		}
+	}
+	return NULL;
+}
+
+long queryStats(char *out, size_t size)
+{
+	SJson	      json  = {out, size, 0};
+	const SStats *stats = getStats();
+
+	jsonAppend(&json,
+		   "{\"elapsed_ms\":%llu,\"counters\":{\"x_requests\":%llu,"
+		   "\"round_trips\":%llu,\"arranges\":%llu,"
+		   "\"bar_redraws\":%llu},\"events\":{",
+		   (unsigned long long)((statsNow() - stats->since) / 1000000),
+		   (unsigned long long)statsRequests(),
+		   (unsigned long long)stats->counters[STATS_ROUND_TRIPS],
+		   (unsigned long long)stats->counters[STATS_ARRANGES],
+		   (unsigned long long)stats->counters[STATS_BAR_REDRAWS]);
+	writeHistograms(&json, stats->events, STATS_EVENT_TYPES,
+			statsEventName);
+	jsonAppend(&json, "},\"actions\":{");
+	writeHistograms(&json, stats->actions, STATS_MAX_ACTIONS, actionName);
+	jsonAppend(&json, "}}");
+
+	return finish(&json);
+}
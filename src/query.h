@@ -0,0 +1,18 @@
+#ifndef QUERY_H
+#define QUERY_H
+
+#include <stddef.h>
+
+/*
+ * serialize the window manager state as compact json straight into out,
+ * returns the number of bytes written or -1 if it does not fit in size
+ */
+long queryTree(char *out, size_t size);
+
+long queryWorkspaces(char *out, size_t size);
+
+long queryClients(char *out, size_t size);
+
+long queryStats(char *out, size_t size);
+
+#endif /* QUERY_H */
@@ -0,0 +1,815 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <X11/Xlib.h>
+#include <X11/Xatom.h>
+#include <X11/extensions/randr.h>
+
+#include "record.h"
+#include "banana.h"
+#include "ipc.h"
+#include "query.h"
+#include "stats.h"
+#include "log.h"
+
+typedef struct {
+	char  *data;
+	size_t length;
+	size_t capacity;
+	int    failed;
+} SRecordBuffer;
+
+typedef struct {
+	const char *p;
+	const char *end;
+	int	    failed;
+} SRecordCursor;
+
+typedef struct {
+	Window recorded;
+	Window replayed;
+} SWindowPair;
+
+static FILE	    *recordFile = NULL;
+static uint64_t	     recordStart;
+static uint64_t	     lastFlush;
+static SRecordBuffer record;
+
+static Display	    *clientDisplay = NULL;
+static SWindowPair  *windowMap	   = NULL;
+static Window	     recordedRoot;
+static int	     recordedRandrBase;
+
+static size_t	     eventSize(int type)
+{
+	switch (type) {
+	case KeyPress:
+	case KeyRelease:
+		return sizeof(XKeyEvent);
+	case ButtonPress:
+	case ButtonRelease:
+		return sizeof(XButtonEvent);
+	case MotionNotify:
+		return sizeof(XMotionEvent);
+	case EnterNotify:
+	case LeaveNotify:
+		return sizeof(XCrossingEvent);
+	case FocusIn:
+	case FocusOut:
+		return sizeof(XFocusChangeEvent);
+	case Expose:
+		return sizeof(XExposeEvent);
+	case CreateNotify:
+		return sizeof(XCreateWindowEvent);
+	case DestroyNotify:
+		return sizeof(XDestroyWindowEvent);
+	case UnmapNotify:
+		return sizeof(XUnmapEvent);
+	case MapNotify:
+		return sizeof(XMapEvent);
+	case MapRequest:
+		return sizeof(XMapRequestEvent);
+	case ReparentNotify:
+		return sizeof(XReparentEvent);
+	case ConfigureNotify:
+		return sizeof(XConfigureEvent);
+	case ConfigureRequest:
+		return sizeof(XConfigureRequestEvent);
+	case PropertyNotify:
+		return sizeof(XPropertyEvent);
+	case ClientMessage:
+		return sizeof(XClientMessageEvent);
+	default:
+		return sizeof(XEvent);
+	}
+}
+
+static void put(const void *data, size_t length)
+{
+	if (record.length + length > record.capacity) {
+		size_t capacity = record.capacity ? record.capacity : 4096;
+		while (capacity < record.length + length) {
+			capacity *= 2;
+		}
+
+		char *grown = realloc(record.data, capacity);
+		if (!grown) {
+			record.failed = 1;
+			return;
+		}
+		record.data	= grown;
+		record.capacity = capacity;
+	}
+
+	memcpy(record.data + record.length, data, length);
+	record.length += length;
+}
+
+static void putU32(uint32_t value)
+{
+	put(&value, sizeof(value));
+}
+
+static void putString(const char *str)
+{
+	put(str ? str : "", str ? strlen(str) + 1 : 1);
+}
+
+/* one round trip for all names, None is written as an empty name */
+static void putAtoms(const Atom *atoms, int count)
+{
+	Atom  *valid	  = malloc(count * sizeof(Atom) + 1);
+	char **names	  = calloc(count + 1, sizeof(char *));
+	int    validCount = 0;
+
+	if (!valid || !names) {
+		free(valid);
+		free(names);
+		record.failed = 1;
+		return;
+	}
+
+	for (int i = 0; i < count; i++) {
+		if (atoms[i] != None) {
+			valid[validCount++] = atoms[i];
+		}
+	}
+
+	if (validCount && !XGetAtomNames(display, valid, validCount, names)) {
+		memset(names, 0, validCount * sizeof(char *));
+	}
+
+	for (int i = 0, j = 0; i < count; i++) {
+		if (atoms[i] == None) {
+			putString("");
+			continue;
+		}
+		putString(names[j]);
+		if (names[j]) {
+			XFree(names[j]);
+		}
+		j++;
+	}
+
+	free(valid);
+	free(names);
+}
+
+static void putProperty(Window window, Atom property, int deleted)
+{
+	Atom	       type   = None;
+	int	       format = 0;
+	unsigned long  count  = 0, after;
+	unsigned char *data   = NULL;
+
+	putAtoms(&property, 1);
+
+	if (deleted ||
+	    XGetWindowProperty(display, window, property, 0,
+			       RECORD_MAX_PROPERTY / 4, False, AnyPropertyType,
+			       &type, &format, &count, &after,
+			       &data) != Success ||
+	    type == None) {
+		putString("");
+		putU32(0);
+		putU32(0);
+		if (data) {
+			XFree(data);
+		}
+		return;
+	}
+
+	putAtoms(&type, 1);
+	putU32(format);
+	putU32(count);
+
+	if (type == XA_ATOM && format == 32) {
+		putAtoms((Atom *)data, count);
+	} else if (format == 32) {
+		for (unsigned long i = 0; i < count; i++) {
+			putU32(((long *)data)[i]);
+		}
+	} else if (format == 16) {
+		for (unsigned long i = 0; i < count; i++) {
+			uint16_t value = ((short *)data)[i];
+			put(&value, sizeof(value));
+		}
+	} else {
+		put(data, count);
+	}
+
+	XFree(data);
+}
+
+static int eventAtoms(XEvent *event, Atom *atoms)
+{
+	if (event->type == PropertyNotify) {
+		atoms[0] = event->xproperty.atom;
+		return 1;
+	}
+
+	if (event->type != ClientMessage) {
+		return 0;
+	}
+
+	atoms[0] = event->xclient.message_type;
+	if (event->xclient.message_type == NET_WM_STATE &&
+	    event->xclient.format == 32) {
+		atoms[1] = event->xclient.data.l[1];
+		atoms[2] = event->xclient.data.l[2];
+		return 3;
+	}
+	return 1;
+}
+
+static void writeRecord(ERecordType type)
+{
+	SRecordHeader header;
+	uint64_t      now = statsNow();
+
+	if (record.failed) {
+		LOG_ERROR("Out of memory while recording, stopping\n");
+		stopRecord();
+		return;
+	}
+
+	header.type   = type;
+	header.length = record.length;
+	header.time   = now - recordStart;
+
+	if (fwrite(&header, sizeof(header), 1, recordFile) != 1 ||
+	    fwrite(record.data, 1, record.length, recordFile) !=
+		record.length) {
+		LOG_ERROR("Failed to write recording: %s\n", strerror(errno));
+		stopRecord();
+		return;
+	}
+
+	if (now - lastFlush > 1000000000) {
+		fflush(recordFile);
+		lastFlush = now;
+	}
+}
+
+void initRecord(void)
+{
+	char	    message[256];
+
+	const char *env = getenv("BANANA_RECORD");
+	if (env && *env && startRecord(env, message, sizeof(message)) == -1) {
+		LOG_ERROR("banana: %s\n", message);
+	}
+}
+
+int startRecord(const char *path, char *message, size_t size)
+{
+	SRecordFileHeader header;
+
+	stopRecord();
+
+	if (!path || !*path) {
+		snprintf(message, size, "No recording file given");
+		return -1;
+	}
+
+	recordFile = fopen(path, "we");
+	if (!recordFile) {
+		snprintf(message, size, "Failed to open %s: %s", path,
+			 strerror(errno));
+		return -1;
+	}
+
+	memset(&header, 0, sizeof(header));
+	header.magic	      = RECORD_MAGIC;
+	header.version	      = RECORD_VERSION;
+	header.root	      = root;
+	header.randrEventBase = getRandrEventBase();
+
+	if (fwrite(&header, sizeof(header), 1, recordFile) != 1) {
+		snprintf(message, size, "Failed to write %s: %s", path,
+			 strerror(errno));
+		fclose(recordFile);
+		recordFile = NULL;
+		return -1;
+	}
+
+	recordStart = lastFlush = statsNow();
+	LOG_INFO("Recording to %s\n", path);
+	snprintf(message, size, "%s", path);
+	return 0;
+}
+
+void stopRecord(void)
+{
+	if (recordFile) {
+		fclose(recordFile);
+		recordFile = NULL;
+	}
+}
+
+void recordEvent(XEvent *event)
+{
+	if (!recordFile) {
+		return;
+	}
+
+	size_t	size	    = eventSize(event->type);
+	int32_t geometry[4] = {0};
+	Atom	atoms[RECORD_MAX_ATOMS];
+	int	atomCount = eventAtoms(event, atoms);
+	Window	window	  = event->xmaprequest.window;
+
+	if (event->type == MapRequest) {
+		Window	     unused;
+		int	     x, y;
+		unsigned int width, height, border, depth;
+
+		if (XGetGeometry(display, window, &unused, &x, &y, &width,
+				 &height, &border, &depth)) {
+			geometry[0] = x;
+			geometry[1] = y;
+			geometry[2] = width;
+			geometry[3] = height;
+		}
+	}
+
+	record.length = 0;
+	putU32(size);
+	put(event, size);
+	put(geometry, sizeof(geometry));
+	putU32(atomCount);
+	putAtoms(atoms, atomCount);
+
+	if (event->type == MapRequest) {
+		int   count	 = 0;
+		Atom *properties = XListProperties(display, window, &count);
+
+		putU32(count);
+		for (int i = 0; i < count; i++) {
+			putProperty(window, properties[i], 0);
+		}
+		if (properties) {
+			XFree(properties);
+		}
+	} else if (event->type == PropertyNotify) {
+		putU32(1);
+		putProperty(event->xproperty.window, event->xproperty.atom,
+			    event->xproperty.state == PropertyDelete);
+	} else {
+		putU32(0);
+	}
+
+	writeRecord(RECORD_X_EVENT);
+}
+
+void recordCommand(uint32_t type, const char *payload, uint32_t length)
+{
+	if (!recordFile ||
+	    (type != IPC_COMMAND_RUN && type != IPC_COMMAND_BATCH &&
+	     type != IPC_COMMAND_RELOAD)) {
+		return;
+	}
+
+	record.length = 0;
+	putU32(type);
+	put(payload, length);
+	writeRecord(RECORD_IPC);
+}
+
+static const void *get(SRecordCursor *cursor, size_t length)
+{
+	if (cursor->failed || (size_t)(cursor->end - cursor->p) < length) {
+		cursor->failed = 1;
+		return NULL;
+	}
+
+	const void *data = cursor->p;
+	cursor->p += length;
+	return data;
+}
+
+static uint32_t getU32(SRecordCursor *cursor)
+{
+	uint32_t    value = 0;
+	const void *data  = get(cursor, sizeof(value));
+
+	if (data) {
+		memcpy(&value, data, sizeof(value));
+	}
+	return value;
+}
+
+static const char *getString(SRecordCursor *cursor)
+{
+	const char *end = NULL;
+
+	if (!cursor->failed) {
+		end = memchr(cursor->p, '\0', cursor->end - cursor->p);
+	}
+	if (!end) {
+		cursor->failed = 1;
+		return "";
+	}
+
+	const char *str = cursor->p;
+	cursor->p	= end + 1;
+	return str;
+}
+
+static Atom getAtom(SRecordCursor *cursor)
+{
+	const char *name = getString(cursor);
+	return *name ? XInternAtom(display, name, False) : None;
+}
+
+static SWindowPair *findWindow(Window recorded)
+{
+	size_t mask  = RECORD_MAX_WINDOWS * 2 - 1;
+	size_t index = (recorded * 2654435761u) & mask;
+
+	for (size_t i = 0; i <= mask; i++) {
+		SWindowPair *pair = &windowMap[(index + i) & mask];
+		if (pair->recorded == recorded || pair->recorded == None) {
+			return pair;
+		}
+	}
+	return NULL;
+}
+
+static Window translateWindow(Window recorded)
+{
+	if (recorded == None) {
+		return None;
+	}
+	if (recorded == recordedRoot) {
+		return root;
+	}
+
+	SWindowPair *pair = findWindow(recorded);
+	return pair && pair->recorded == recorded ? pair->replayed : None;
+}
+
+/*
+ * windows from the recording are recreated by a second connection that
+ * plays the part of the clients, banana manages them like any other window
+ */
+static Window standIn(Window recorded, const int32_t *geometry)
+{
+	Window replayed = translateWindow(recorded);
+	if (replayed != None || recorded == None) {
+		return replayed;
+	}
+
+	SWindowPair *pair = findWindow(recorded);
+	if (!pair) {
+		LOG_WARN("Too many windows in recording\n");
+		return None;
+	}
+
+	int screen     = DefaultScreen(clientDisplay);
+	pair->recorded = recorded;
+	pair->replayed = XCreateSimpleWindow(
+	    clientDisplay, RootWindow(clientDisplay, screen), geometry[0],
+	    geometry[1], geometry[2] > 0 ? geometry[2] : 100,
+	    geometry[3] > 0 ? geometry[3] : 100, 0,
+	    BlackPixel(clientDisplay, screen),
+	    WhitePixel(clientDisplay, screen));
+	return pair->replayed;
+}
+
+static void applyProperty(SRecordCursor *cursor, Window window)
+{
+	Atom	 property = getAtom(cursor);
+	Atom	 type	  = getAtom(cursor);
+	int	 format	  = getU32(cursor);
+	uint32_t count	  = getU32(cursor);
+
+	if (count > RECORD_MAX_PROPERTY ||
+	    (format == 32 && count > RECORD_MAX_PROPERTY / 4)) {
+		cursor->failed = 1;
+		return;
+	}
+
+	if (type == None) {
+		if (window != None && property != None) {
+			XDeleteProperty(clientDisplay, window, property);
+		}
+		return;
+	}
+
+	static long    values[RECORD_MAX_PROPERTY / 4];
+	unsigned char *data = (unsigned char *)values;
+
+	if (type == XA_ATOM && format == 32) {
+		for (uint32_t i = 0; i < count; i++) {
+			values[i] = getAtom(cursor);
+		}
+	} else if (format == 32) {
+		for (uint32_t i = 0; i < count; i++) {
+			values[i] = getU32(cursor);
+			if (type == XA_WINDOW) {
+				values[i] = translateWindow(values[i]);
+			}
+		}
+	} else if (format == 16) {
+		const uint16_t *items = get(cursor, count * sizeof(uint16_t));
+		for (uint32_t i = 0; items && i < count; i++) {
+			((short *)values)[i] = items[i];
+		}
+	} else {
+		const void *items = get(cursor, count);
+		if (items) {
+			memcpy(values, items, count);
+		}
+	}
+
+	if (!cursor->failed && window != None && property != None) {
+		XChangeProperty(clientDisplay, window, property, type, format,
+				PropModeReplace, data, count);
+	}
+}
+
+static void translateEvent(XEvent *event, const int32_t *geometry)
+{
+	switch (event->type) {
+	case KeyPress:
+	case KeyRelease:
+		event->xkey.window    = translateWindow(event->xkey.window);
+		event->xkey.root      = translateWindow(event->xkey.root);
+		event->xkey.subwindow = translateWindow(event->xkey.subwindow);
+		break;
+	case ButtonPress:
+	case ButtonRelease:
+		event->xbutton.window = translateWindow(event->xbutton.window);
+		event->xbutton.root   = translateWindow(event->xbutton.root);
+		event->xbutton.subwindow =
+		    translateWindow(event->xbutton.subwindow);
+		break;
+	case MotionNotify:
+		event->xmotion.window = translateWindow(event->xmotion.window);
+		event->xmotion.root   = translateWindow(event->xmotion.root);
+		event->xmotion.subwindow =
+		    translateWindow(event->xmotion.subwindow);
+		break;
+	case EnterNotify:
+	case LeaveNotify:
+		event->xcrossing.window =
+		    translateWindow(event->xcrossing.window);
+		event->xcrossing.root = translateWindow(event->xcrossing.root);
+		event->xcrossing.subwindow =
+		    translateWindow(event->xcrossing.subwindow);
+		break;
+	case MapRequest:
+		event->xmaprequest.parent =
+		    translateWindow(event->xmaprequest.parent);
+		event->xmaprequest.window =
+		    standIn(event->xmaprequest.window, geometry);
+		break;
+	case ConfigureRequest: {
+		int32_t requested[4] = {event->xconfigurerequest.x,
+					event->xconfigurerequest.y,
+					event->xconfigurerequest.width,
+					event->xconfigurerequest.height};
+		event->xconfigurerequest.parent =
+		    translateWindow(event->xconfigurerequest.parent);
+		event->xconfigurerequest.window =
+		    standIn(event->xconfigurerequest.window, requested);
+		event->xconfigurerequest.above =
+		    translateWindow(event->xconfigurerequest.above);
+		break;
+	}
+	case ConfigureNotify:
+		event->xconfigure.event =
+		    translateWindow(event->xconfigure.event);
+		event->xconfigure.window =
+		    translateWindow(event->xconfigure.window);
+		event->xconfigure.above =
+		    translateWindow(event->xconfigure.above);
+		break;
+	case CreateNotify:
+		event->xcreatewindow.parent =
+		    translateWindow(event->xcreatewindow.parent);
+		event->xcreatewindow.window =
+		    translateWindow(event->xcreatewindow.window);
+		break;
+	case DestroyNotify:
+		event->xdestroywindow.event =
+		    translateWindow(event->xdestroywindow.event);
+		event->xdestroywindow.window =
+		    translateWindow(event->xdestroywindow.window);
+		break;
+	case UnmapNotify:
+		event->xunmap.event  = translateWindow(event->xunmap.event);
+		event->xunmap.window = translateWindow(event->xunmap.window);
+		break;
+	case MapNotify:
+		event->xmap.event  = translateWindow(event->xmap.event);
+		event->xmap.window = translateWindow(event->xmap.window);
+		break;
+	case ReparentNotify:
+		event->xreparent.event =
+		    translateWindow(event->xreparent.event);
+		event->xreparent.window =
+		    translateWindow(event->xreparent.window);
+		event->xreparent.parent =
+		    translateWindow(event->xreparent.parent);
+		break;
+	default:
+		event->xany.window = translateWindow(event->xany.window);
+		break;
+	}
+}
+
+/*
+ * the client side of an event is redone on the stand in first, then the
+ * events the server generated for banana in response are thrown away so the
+ * recorded event is the only one the handlers see
+ */
+static void replayEvent(SRecordCursor *cursor)
+{
+	XEvent	       event;
+	const int32_t *geometry;
+	Atom	       atoms[RECORD_MAX_ATOMS] = {None};
+
+	uint32_t       size = getU32(cursor);
+	const void    *data = get(cursor, size);
+	geometry	    = get(cursor, 4 * sizeof(int32_t));
+	if (!data || !geometry) {
+		return;
+	}
+
+	memset(&event, 0, sizeof(event));
+	memcpy(&event, data, size < sizeof(event) ? size : sizeof(event));
+	event.xany.display = display;
+
+	uint32_t atomCount = getU32(cursor);
+	for (uint32_t i = 0; i < atomCount && !cursor->failed; i++) {
+		Atom atom = getAtom(cursor);
+		if (i < RECORD_MAX_ATOMS) {
+			atoms[i] = atom;
+		}
+	}
+
+	if (recordedRandrBase &&
+	    event.type == recordedRandrBase + RRScreenChangeNotify) {
+		event.type = getRandrEventBase() + RRScreenChangeNotify;
+	}
+
+	Window recorded = event.xany.window;
+	if (event.type == DestroyNotify) {
+		recorded = event.xdestroywindow.window;
+	} else if (event.type == UnmapNotify) {
+		recorded = event.xunmap.window;
+	}
+
+	translateEvent(&event, geometry);
+
+	Window window = event.xany.window;
+	if (event.type == MapRequest) {
+		window = event.xmaprequest.window;
+	} else if (event.type == DestroyNotify) {
+		window = event.xdestroywindow.window;
+	} else if (event.type == UnmapNotify) {
+		window = event.xunmap.window;
+	}
+
+	uint32_t propertyCount = getU32(cursor);
+	for (uint32_t i = 0; i < propertyCount && !cursor->failed; i++) {
+		applyProperty(cursor, window);
+	}
+	if (cursor->failed) {
+		LOG_WARN("Truncated event in recording\n");
+		return;
+	}
+
+	if (event.type == PropertyNotify) {
+		event.xproperty.atom = atoms[0];
+	} else if (event.type == ClientMessage) {
+		event.xclient.message_type = atoms[0];
+		if (atomCount == RECORD_MAX_ATOMS) {
+			event.xclient.data.l[1] = atoms[1];
+			event.xclient.data.l[2] = atoms[2];
+		}
+	} else if (event.type == UnmapNotify && window != None) {
+		XUnmapWindow(clientDisplay, window);
+	} else if (event.type == DestroyNotify && window != None) {
+		XDestroyWindow(clientDisplay, window);
+
+		SWindowPair *pair = findWindow(recorded);
+		if (pair && pair->recorded == recorded) {
+			pair->replayed = None;
+		}
+	}
+
+	XSync(clientDisplay, False);
+	XSync(display, False);
+	while (XPending(display)) {
+		XEvent discarded;
+		XNextEvent(display, &discarded);
+	}
+
+	dispatchEvent(&event);
+	flushRootProperties();
+}
+
+int replayFile(const char *path)
+{
+	SRecordFileHeader header;
+	SRecordHeader	  recordHeader;
+	char		 *data	   = NULL;
+	size_t		  capacity = 0;
+	unsigned long	  events = 0, commands = 0;
+	int		  result = 0;
+
+	FILE		 *fp = fopen(path, "re");
+	if (!fp) {
+		fprintf(stderr, "banana: cannot open %s: %s\n", path,
+			strerror(errno));
+		return -1;
+	}
+
+	if (fread(&header, sizeof(header), 1, fp) != 1 ||
+	    header.magic != RECORD_MAGIC || header.version != RECORD_VERSION) {
+		fprintf(stderr, "banana: %s is not a banana recording\n", path);
+		fclose(fp);
+		return -1;
+	}
+
+	clientDisplay = XOpenDisplay(NULL);
+	windowMap     = calloc(RECORD_MAX_WINDOWS * 2, sizeof(SWindowPair));
+	if (!clientDisplay || !windowMap) {
+		fprintf(stderr, "banana: cannot set up replay\n");
+		fclose(fp);
+		free(windowMap);
+		return -1;
+	}
+
+	recordedRoot	  = header.root;
+	recordedRandrBase = header.randrEventBase;
+	statsReset();
+
+	uint64_t start = statsNow();
+	while (fread(&recordHeader, sizeof(recordHeader), 1, fp) == 1) {
+		if (recordHeader.length > RECORD_MAX_RECORD) {
+			fprintf(stderr, "banana: corrupt record in %s\n", path);
+			result = -1;
+			break;
+		}
+
+		if (recordHeader.length > capacity) {
+			char *grown = realloc(data, recordHeader.length);
+			if (!grown) {
+				result = -1;
+				break;
+			}
+			data	 = grown;
+			capacity = recordHeader.length;
+		}
+
+		if (fread(data, 1, recordHeader.length, fp) !=
+		    recordHeader.length) {
+			fprintf(stderr, "banana: truncated record in %s\n",
+				path);
+			break;
+		}
+
+		SRecordCursor cursor = {data, data + recordHeader.length, 0};
+		if (recordHeader.type == RECORD_X_EVENT) {
+			replayEvent(&cursor);
+			events++;
+		} else if (recordHeader.type == RECORD_IPC) {
+			uint32_t type = getU32(&cursor);
+			ipcReplayCommand(type, cursor.p, cursor.end - cursor.p);
+			flushRootProperties();
+			commands++;
+		}
+	}
+	uint64_t elapsed = statsNow() - start;
+
+	printf("replayed %lu events and %lu ipc commands in %.1f ms\n", events,
+	       commands, elapsed / 1e6);
+
+	char *stats = malloc(IPC_MAX_RESPONSE);
+	if (stats && queryStats(stats, IPC_MAX_RESPONSE) != -1) {
+		printf("%s\n", stats);
+	}
+
+	free(stats);
+	free(data);
+	free(windowMap);
+	windowMap = NULL;
+	XCloseDisplay(clientDisplay);
+	clientDisplay = NULL;
+	fclose(fp);
+	return result;
+}
+
+void cleanupRecord(void)
+{
+	stopRecord();
+	free(record.data);
+	record.data	= NULL;
+	record.length	= 0;
+	record.capacity = 0;
+}
@@ -0,0 +1,64 @@
+#ifndef RECORD_H
+#define RECORD_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <X11/Xlib.h>
+
+#define RECORD_MAGIC	    0x43524e42
+#define RECORD_VERSION	    1
+#define RECORD_MAX_RECORD   (16 * 1024 * 1024)
+#define RECORD_MAX_PROPERTY 65536
+#define RECORD_MAX_WINDOWS  4096
+#define RECORD_MAX_ATOMS    3
+#define RECORD_PATH_MAX	    4096
+
+typedef enum {
+	RECORD_X_EVENT = 1,
+	RECORD_IPC
+} ERecordType;
+
+typedef struct {
+	uint32_t magic;
+	uint32_t version;
+	uint64_t root;
+	int32_t	 randrEventBase;
+	uint32_t reserved;
+} SRecordFileHeader;
+
+/*
+ * every record is this header followed by length bytes, an ipc record is
+ * the command type as uint32 followed by its payload, an x event record is
+ *
+ *   uint32 size, the XEvent truncated to size bytes
+ *   int32 x, y, width, height of the window for a MapRequest
+ *   uint32 count, count nul terminated names of the atoms in the event
+ *   uint32 count, count properties
+ *
+ * and a property is its nul terminated name and type name, int32 format,
+ * uint32 count and count items of format bits, or count nul terminated names
+ * when the type is ATOM, an empty type name means the property was deleted,
+ * the properties of a window are captured when it is first mapped and when
+ * they change so a replay can recreate them on stand in windows
+ */
+typedef struct {
+	uint32_t type;
+	uint32_t length;
+	uint64_t time;
+} SRecordHeader;
+
+void initRecord(void);
+
+int  startRecord(const char *path, char *message, size_t size);
+
+void stopRecord(void);
+
+void recordEvent(XEvent *event);
+
+void recordCommand(uint32_t type, const char *payload, uint32_t length);
+
+int  replayFile(const char *path);
+
+void cleanupRecord(void);
+
+#endif /* RECORD_H */
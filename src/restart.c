@@ -0,0 +1,409 @@
+#include <errno.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "restart.h"
+#include "banana.h"
+#include "config.h"
+#include "bar.h"
+#include "log.h"
+#include "pool.h"
+#include "proc.h"
+
+#define RESTART_MAX_STATE (16 * 1024 * 1024)
+
+extern int  currentWorkspace;
+extern int  xerrorHandler(Display *dpy, XErrorEvent *ee);
+
+static char restartProgram[RESTART_PATH_MAX] = "banana";
+
+static Atom stateAtom(void)
+{
+	return XInternAtom(display, "_BANANA_STATE", False);
+}
+
+static size_t monitorSize(uint32_t workspaces)
+{
+	return sizeof(SRestartMonitor) +
+	       workspaces *
+		   (sizeof(float) + sizeof(int32_t) + sizeof(uint64_t));
+}
+
+static int saveState(void)
+{
+	uint32_t clientCount = 0;
+	for (SClient *c = clients; c; c = c->next) {
+		clientCount++;
+	}
+
+	size_t size = sizeof(SRestartHeader) +
+		      numMonitors * monitorSize(workspaceCount) +
+		      clientCount * sizeof(SRestartClient);
+	if (size > RESTART_MAX_STATE) {
+		LOG_ERROR("Restart state too large: %zu bytes\n", size);
+		return -1;
+	}
+
+	unsigned char *buffer = calloc(1, size);
+	if (!buffer) {
+		LOG_ERROR("Failed to allocate restart state\n");
+		return -1;
+	}
+
+	SRestartHeader *header	 = (SRestartHeader *)buffer;
+	header->magic		 = RESTART_MAGIC;
+	header->version		 = RESTART_VERSION;
+	header->monitors	 = numMonitors;
+	header->workspaces	 = workspaceCount;
+	header->clients		 = clientCount;
+	header->currentWorkspace = currentWorkspace;
+	header->focused		 = focused ? focused->window : None;
+
+	unsigned char *p = buffer + sizeof(SRestartHeader);
+	for (int i = 0; i < numMonitors; i++) {
+		SMonitor	*monitor = &monitors[i];
+		SRestartMonitor *saved	 = (SRestartMonitor *)p;
+		saved->id		 = monitor->id;
+		saved->currentWorkspace	 = monitor->currentWorkspace;
+		saved->currentLayout	 = monitor->currentLayout;
+		saved->masterCount	 = monitor->masterCount;
+		p += sizeof(SRestartMonitor);
+
+		for (int ws = 0; ws < workspaceCount; ws++) {
+			int32_t	 layout = monitor->workspaceLayouts[ws];
+			uint64_t last	= monitor->lastTiledClient[ws];
+
+			memcpy(p, &monitor->masterFactors[ws], sizeof(float));
+			p += sizeof(float);
+			memcpy(p, &layout, sizeof(layout));
+			p += sizeof(layout);
+			memcpy(p, &last, sizeof(last));
+			p += sizeof(last);
+		}
+	}
+
+	for (SClient *c = clients; c; c = c->next) {
+		SRestartClient *saved = (SRestartClient *)p;
+		saved->window	      = c->window;
+		saved->swallowedBy    = c->swallowedBy ? c->swallowedBy->window
+						       : None;
+		saved->swallowed = c->swallowed ? c->swallowed->window : None;
+		saved->x	 = c->x;
+		saved->y	 = c->y;
+		saved->width	 = c->width;
+		saved->height	 = c->height;
+		saved->oldx	 = c->oldx;
+		saved->oldy	 = c->oldy;
+		saved->oldwidth	 = c->oldwidth;
+		saved->oldheight = c->oldheight;
+		saved->monitor	 = c->monitor;
+		saved->workspace = c->workspace;
+		saved->oldWorkspace = c->oldWorkspace;
+		saved->isFloating   = c->isFloating;
+		saved->isFullscreen = c->isFullscreen;
+		saved->isUrgent	    = c->isUrgent;
+		saved->oldState	    = c->oldState;
+		saved->isSwallowing = c->isSwallowing;
+		saved->noswallow    = c->noswallow;
+		saved->pid	    = c->pid;
+		p += sizeof(SRestartClient);
+	}
+
+	XChangeProperty(display, root, stateAtom(), XA_CARDINAL, 8,
+			PropModeReplace, buffer, size);
+	free(buffer);
+
+	LOG_INFO("Saved restart state: %d monitors, %u clients\n", numMonitors,
+		 clientCount);
+	return 0;
+}
+
+void initRestart(const char *program)
+{
+	if (program && *program) {
+		snprintf(restartProgram, sizeof(restartProgram), "%s", program);
+	}
+}
+
+/*
+ * the x connection and every other descriptor are close on exec, the root
+ * event mask is dropped first so the new process can take over the
+ * redirect as soon as it starts, client windows are left as they are.
+ * only the binary banana was started as is executed, so an ipc client
+ * can't make the window manager run a program of its choosing
+ */
+void restart(const char *arg)
+{
+	if (arg && *arg) {
+		LOG_WARN("Ignoring restart argument '%s'\n", arg);
+	}
+
+	if (saveState() != 0) {
+		return;
+	}
+
+	XWindowAttributes wa;
+	long		  eventMask = XGetWindowAttributes(display, root, &wa)
+					  ? wa.your_event_mask
+					  : NoEventMask;
+
+	cleanupPools();
+	revealHiddenClients();
+
+	XSelectInput(display, root, NoEventMask);
+	XSync(display, False);
+
+	/* exec discards the ring, so the writer drains it and logging is direct */
+	ELogLevel level = logLevel;
+	LOG_INFO("Restarting into %s\n", restartProgram);
+	cleanupLog();
+	execlp(restartProgram, restartProgram, (char *)NULL);
+
+	LOG_ERROR("Failed to restart into %s: %s\n", restartProgram,
+		  strerror(errno));
+	initLog();
+	logLevel = level;
+
+	XDeleteProperty(display, root, stateAtom());
+	XSelectInput(display, root, eventMask);
+	updateClientVisibility();
+	refreshPools();
+}
+
+static int mapMonitor(const SRestartMonitor *saved, int index, int *claimed)
+{
+	for (int i = 0; i < numMonitors; i++) {
+		if (!claimed[i] && monitors[i].id == saved->id) {
+			claimed[i] = 1;
+			return i;
+		}
+	}
+
+	if (index < numMonitors && !claimed[index]) {
+		claimed[index] = 1;
+		return index;
+	}
+
+	return -1;
+}
+
+static void restoreMonitors(const SRestartHeader *header,
+			    const unsigned char **p, int *monitorMap)
+{
+	int claimed[MAX_MONITORS] = {0};
+	int workspaces = MIN((int)header->workspaces, workspaceCount);
+
+	for (uint32_t i = 0; i < header->monitors; i++) {
+		const SRestartMonitor *saved = (const SRestartMonitor *)*p;
+		const unsigned char   *data  = *p + sizeof(SRestartMonitor);
+		*p += monitorSize(header->workspaces);
+
+		int index     = mapMonitor(saved, i, claimed);
+		monitorMap[i] = index;
+		if (index < 0) {
+			continue;
+		}
+
+		SMonitor *monitor = &monitors[index];
+		if (saved->currentWorkspace >= 0 &&
+		    saved->currentWorkspace < workspaceCount) {
+			monitor->currentWorkspace = saved->currentWorkspace;
+		}
+		if (saved->currentLayout >= LAYOUT_FLOATING &&
+		    saved->currentLayout <= LAYOUT_MONOCLE) {
+			monitor->currentLayout = saved->currentLayout;
+		}
+		if (saved->masterCount > 0) {
+			monitor->masterCount = saved->masterCount;
+		}
+
+		for (int ws = 0; ws < workspaces; ws++) {
+			int32_t	 layout;
+			uint64_t last;
+
+			memcpy(&monitor->masterFactors[ws], data,
+			       sizeof(float));
+			data += sizeof(float);
+			memcpy(&layout, data, sizeof(layout));
+			data += sizeof(layout);
+			memcpy(&last, data, sizeof(last));
+			data += sizeof(last);
+
+			if (layout >= LAYOUT_FLOATING &&
+			    layout <= LAYOUT_MONOCLE) {
+				monitor->workspaceLayouts[ws] = layout;
+			}
+			monitor->lastTiledClient[ws] = last;
+		}
+	}
+}
+
+static SClient *restoreClient(const SRestartClient *saved,
+			      const SRestartHeader *header,
+			      const int		   *monitorMap)
+{
+	XWindowAttributes wa;
+	if (!XGetWindowAttributes(display, saved->window, &wa) ||
+	    wa.override_redirect) {
+		return NULL;
+	}
+
+	SClient *client = calloc(1, sizeof(SClient));
+	if (!client) {
+		LOG_ERROR("Failed to allocate memory for client\n");
+		return NULL;
+	}
+
+	int monitor = saved->monitor >= 0 &&
+			      (uint32_t)saved->monitor < header->monitors
+			  ? monitorMap[saved->monitor]
+			  : -1;
+
+	client->window	     = saved->window;
+	client->x	     = saved->x;
+	client->y	     = saved->y;
+	client->width	     = saved->width;
+	client->height	     = saved->height;
+	client->oldx	     = saved->oldx;
+	client->oldy	     = saved->oldy;
+	client->oldwidth     = saved->oldwidth;
+	client->oldheight    = saved->oldheight;
+	client->monitor	     = monitor >= 0 ? monitor : 0;
+	client->oldMonitor   = client->monitor;
+	client->workspace    = saved->workspace;
+	client->oldWorkspace = saved->oldWorkspace;
+	client->isFloating   = saved->isFloating;
+	client->isFullscreen = saved->isFullscreen;
+	client->isUrgent     = saved->isUrgent;
+	client->oldState     = saved->oldState;
+	client->isSwallowing = saved->isSwallowing;
+	client->noswallow    = saved->noswallow;
+	client->pid	     = saved->pid;
+
+	/* swallowed windows are parked on INT_MAX, docks on DOCK_WORKSPACE */
+	if (client->workspace >= workspaceCount &&
+	    client->workspace != INT_MAX) {
+		client->workspace = 0;
+	}
+	if (client->oldWorkspace >= workspaceCount ||
+	    client->oldWorkspace < 0) {
+		client->oldWorkspace = 0;
+	}
+
+	getWindowClass(client->window, client->className, client->instanceName,
+		       sizeof(client->className));
+	updateClientTitle(client);
+	updateSizeHints(client);
+	setupClientWindow(client);
+
+	if (client->isSwallowing) {
+		trackProcess(client->pid);
+	}
+
+	return client;
+}
+
+/*
+ * adopts the windows a restarting banana left behind with their saved
+ * monitor, workspace, geometry and swallow links, nothing is unmapped or
+ * remapped so the desktop looks the same before and after
+ */
+int restoreState(void)
+{
+	Atom	       type;
+	int	       format;
+	unsigned long  count, after;
+	unsigned char *data = NULL;
+
+	if (XGetWindowProperty(display, root, stateAtom(), 0,
+			       RESTART_MAX_STATE / 4, True, XA_CARDINAL, &type,
+			       &format, &count, &after, &data) != Success ||
+	    !data) {
+		return 0;
+	}
+
+	const SRestartHeader *header = (const SRestartHeader *)data;
+	if (format != 8 || count < sizeof(SRestartHeader) ||
+	    header->magic != RESTART_MAGIC ||
+	    header->version != RESTART_VERSION ||
+	    header->monitors > MAX_MONITORS ||
+	    count != sizeof(SRestartHeader) +
+			 header->monitors * monitorSize(header->workspaces) +
+			 header->clients * sizeof(SRestartClient)) {
+		LOG_WARN("Ignoring invalid restart state\n");
+		XFree(data);
+		return 0;
+	}
+
+	int		     monitorMap[MAX_MONITORS];
+	const unsigned char *p = data + sizeof(SRestartHeader);
+	restoreMonitors(header, &p, monitorMap);
+
+	XErrorHandler oldHandler = XSetErrorHandler(xerrorHandler);
+
+	SClient	    **tail     = &clients;
+	int	      restored = 0;
+	for (uint32_t i = 0; i < header->clients; i++) {
+		SClient *client = restoreClient((const SRestartClient *)p,
+						header, monitorMap);
+		p += sizeof(SRestartClient);
+
+		if (client) {
+			*tail = client;
+			tail  = &client->next;
+			attachStack(client);
+			clientListAdd(client->window);
+			restored++;
+		}
+	}
+
+	p = data + sizeof(SRestartHeader) +
+	    header->monitors * monitorSize(header->workspaces);
+	for (uint32_t i = 0; i < header->clients; i++) {
+		const SRestartClient *saved  = (const SRestartClient *)p;
+		SClient		     *client = findClient(saved->window);
+		p += sizeof(SRestartClient);
+
+		if (client) {
+			client->swallowedBy = findClient(saved->swallowedBy);
+			client->swallowed   = findClient(saved->swallowed);
+			if (client->isDock && barVisible) {
+				barVisible = 0;
+				showHideBars(0);
+			}
+		}
+	}
+
+	XSync(display, False);
+	XSetErrorHandler(oldHandler);
+
+	if (header->currentWorkspace < (uint32_t)workspaceCount) {
+		currentWorkspace = header->currentWorkspace;
+		invalidateCurrentDesktop(currentWorkspace);
+	}
+
+	SClient *focusTarget = findClient(header->focused);
+	uint32_t total	     = header->clients;
+	XFree(data);
+
+	updateClientPositionsForBar();
+	for (int i = 0; i < numMonitors; i++) {
+		arrangeClients(&monitors[i]);
+	}
+	updateClientVisibility();
+	updateBorders();
+	restackClients();
+	invalidateRootProperties(ROOT_DESKTOP_VIEWPORT);
+
+	if (focusTarget) {
+		focusClient(focusTarget);
+	}
+
+	updateBars();
+
+	LOG_INFO("Restored %d of %u clients after restart\n", restored, total);
+	return 1;
+}
@@ -0,0 +1,61 @@
+#ifndef RESTART_H
+#define RESTART_H
+
+#include <stdint.h>
+
+#define RESTART_MAGIC	 0x53524e42
+#define RESTART_VERSION	 1
+#define RESTART_PATH_MAX 4096
+
+/*
+ * the state is stored on the root window as _BANANA_STATE, one header, then
+ * per monitor an SRestartMonitor followed by workspaces master factors as
+ * float, layouts as int32 and last tiled windows as uint64, then one
+ * SRestartClient per client in list order, clients refer to monitors by
+ * their index in the saved state and to other clients by window
+ */
+typedef struct {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t monitors;
+	uint32_t workspaces;
+	uint32_t clients;
+	uint32_t currentWorkspace;
+	uint64_t focused;
+} SRestartHeader;
+
+typedef struct {
+	uint64_t id;
+	int32_t	 currentWorkspace;
+	int32_t	 currentLayout;
+	int32_t	 masterCount;
+	int32_t	 reserved;
+} SRestartMonitor;
+
+typedef struct {
+	uint64_t window;
+	uint64_t swallowedBy;
+	uint64_t swallowed;
+	int32_t	 x, y;
+	int32_t	 width, height;
+	int32_t	 oldx, oldy;
+	int32_t	 oldwidth, oldheight;
+	int32_t	 monitor;
+	int32_t	 workspace;
+	int32_t	 oldWorkspace;
+	int32_t	 isFloating;
+	int32_t	 isFullscreen;
+	int32_t	 isUrgent;
+	int32_t	 oldState;
+	int32_t	 isSwallowing;
+	int32_t	 noswallow;
+	int32_t	 pid;
+} SRestartClient;
+
+void initRestart(const char *program);
+
+void restart(const char *arg);
+
+int  restoreState(void);
+
+#endif /* RESTART_H */
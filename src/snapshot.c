@@ -0,0 +1,182 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <sys/mman.h>
+
+#include "snapshot.h"
+#include "banana.h"
+#include "log.h"
+
+#ifndef F_SEAL_FUTURE_WRITE
+#define F_SEAL_FUTURE_WRITE 0x0010
+#endif
+
+static int	  snapshotFd = -1;
+static SSnapshot *snapshot  = NULL;
+
+static int	 createSnapshot(void)
+{
+	snapshotFd =
+	    memfd_create("banana-state", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+	if (snapshotFd == -1) {
+		LOG_ERROR("Failed to create state snapshot: %s\n",
+			  strerror(errno));
+		return -1;
+	}
+
+	if (ftruncate(snapshotFd, sizeof(SSnapshot)) == -1) {
+		LOG_ERROR("Failed to size state snapshot: %s\n",
+			  strerror(errno));
+		close(snapshotFd);
+		snapshotFd = -1;
+		return -1;
+	}
+
+	snapshot = mmap(NULL, sizeof(SSnapshot), PROT_READ | PROT_WRITE,
+			MAP_SHARED, snapshotFd, 0);
+	if (snapshot == MAP_FAILED) {
+		LOG_ERROR("Failed to map state snapshot: %s\n",
+			  strerror(errno));
+		snapshot = NULL;
+		close(snapshotFd);
+		snapshotFd = -1;
+		return -1;
+	}
+
+	if (fcntl(snapshotFd, F_ADD_SEALS,
+		  F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_FUTURE_WRITE |
+		      F_SEAL_SEAL) == -1) {
+		LOG_ERROR("Failed to seal state snapshot: %s\n",
+			  strerror(errno));
+	}
+
+	snapshot->magic	  = SNAPSHOT_MAGIC;
+	snapshot->version = SNAPSHOT_VERSION;
+	snapshot->size	  = sizeof(SSnapshot);
+
+	return 0;
+}
+
+static void copyMonitor(SSnapshotMonitor *dst, SMonitor *src)
+{
+	dst->x		      = src->x;
+	dst->y		      = src->y;
+	dst->width	      = src->width;
+	dst->height	      = src->height;
+	dst->currentWorkspace = src->currentWorkspace;
+	dst->currentLayout    = src->currentLayout;
+
+	for (int ws = 0; ws < SNAPSHOT_MAX_WORKSPACES; ws++) {
+		if (ws < workspaceCount) {
+			dst->workspaceLayouts[ws] = src->workspaceLayouts[ws];
+			dst->masterFactors[ws]	  = src->masterFactors[ws];
+		} else {
+			dst->workspaceLayouts[ws] = 0;
+			dst->masterFactors[ws]	  = 0;
+		}
+	}
+}
+
+static void copyClient(SSnapshotClient *dst, SClient *src)
+{
+	dst->window	 = src->window;
+	dst->swallowedBy = src->swallowedBy ? src->swallowedBy->window : 0;
+	dst->x		 = src->x;
+	dst->y		 = src->y;
+	dst->width	 = src->width;
+	dst->height	 = src->height;
+	dst->monitor	 = src->monitor;
+	dst->workspace	 = src->workspace == INT_MAX ? -2 : src->workspace;
+	dst->pid	 = src->pid;
+
+	dst->flags = 0;
+	if (src->isFloating) {
+		dst->flags |= SNAPSHOT_FLAG_FLOATING;
+	}
+	if (src->isFullscreen) {
+		dst->flags |= SNAPSHOT_FLAG_FULLSCREEN;
+	}
+	if (src->isDock) {
+		dst->flags |= SNAPSHOT_FLAG_DOCK;
+	}
+	if (src->isUrgent) {
+		dst->flags |= SNAPSHOT_FLAG_URGENT;
+	}
+	if (src->swallowedBy) {
+		dst->flags |= SNAPSHOT_FLAG_SWALLOWED;
+	}
+	if (src->workspace == INT_MAX ||
+	    (src->workspace >= 0 &&
+	     src->workspace != monitors[src->monitor].currentWorkspace)) {
+		dst->flags |= SNAPSHOT_FLAG_HIDDEN;
+	}
+
+	snprintf(dst->className, sizeof(dst->className), "%s", src->className);
+	snprintf(dst->instanceName, sizeof(dst->instanceName), "%s",
+		 src->instanceName);
+	snprintf(dst->title, sizeof(dst->title), "%s", src->title);
+}
+
+int snapshotGetFd(void)
+{
+	if (!snapshot && createSnapshot() == -1) {
+		return -1;
+	}
+
+	snapshotPublish();
+	return snapshotFd;
+}
+
+void snapshotPublish(void)
+{
+	if (!snapshot) {
+		return;
+	}
+
+	uint32_t sequence = snapshot->sequence;
+	__atomic_store_n(&snapshot->sequence, sequence + 1, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+
+	snapshot->generation++;
+	snapshot->focusedWindow	 = focused ? focused->window : 0;
+	snapshot->focusedMonitor = focused ? focused->monitor : -1;
+	snapshot->workspaceCount = workspaceCount;
+
+	int monitorCount = 0;
+	for (int i = 0; i < numMonitors && i < SNAPSHOT_MAX_MONITORS; i++) {
+		copyMonitor(&snapshot->monitors[monitorCount++], &monitors[i]);
+	}
+	snapshot->monitorCount = monitorCount;
+	snapshot->monitorTotal = numMonitors;
+
+	int clientCount = 0;
+	int clientTotal = 0;
+	for (SClient *c = clients; c; c = c->next) {
+		if (clientCount < SNAPSHOT_MAX_CLIENTS) {
+			copyClient(&snapshot->clients[clientCount++], c);
+		}
+		clientTotal++;
+	}
+	snapshot->clientCount = clientCount;
+	snapshot->clientTotal = clientTotal;
+
+	__atomic_store_n(&snapshot->sequence, sequence + 2, __ATOMIC_RELEASE);
+}
+
+void snapshotCleanup(void)
+{
+	if (snapshot) {
+		munmap(snapshot, sizeof(SSnapshot));
+		snapshot = NULL;
+	}
+
+	if (snapshotFd != -1) {
+		close(snapshotFd);
+		snapshotFd = -1;
+	}
+}
@@ -0,0 +1,76 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <stdint.h>
+
+#define SNAPSHOT_MAGIC		0x414e4142
+#define SNAPSHOT_VERSION	2
+#define SNAPSHOT_MAX_MONITORS	16
+#define SNAPSHOT_MAX_WORKSPACES 9
+#define SNAPSHOT_MAX_CLIENTS	256
+#define SNAPSHOT_CLASS_MAX	64
+#define SNAPSHOT_TITLE_MAX	256
+
+#define SNAPSHOT_FLAG_FLOATING	 (1u << 0)
+#define SNAPSHOT_FLAG_FULLSCREEN (1u << 1)
+#define SNAPSHOT_FLAG_DOCK	 (1u << 2)
+#define SNAPSHOT_FLAG_URGENT	 (1u << 3)
+#define SNAPSHOT_FLAG_SWALLOWED	 (1u << 4)
+#define SNAPSHOT_FLAG_HIDDEN	 (1u << 5)
+
+typedef struct {
+	int32_t x, y;
+	int32_t width, height;
+	int32_t currentWorkspace;
+	int32_t currentLayout;
+	int32_t workspaceLayouts[SNAPSHOT_MAX_WORKSPACES];
+	float	masterFactors[SNAPSHOT_MAX_WORKSPACES];
+} SSnapshotMonitor;
+
+typedef struct {
+	uint64_t window;
+	uint64_t swallowedBy;
+	int32_t	 x, y;
+	int32_t	 width, height;
+	int32_t	 monitor;
+	int32_t	 workspace;
+	int32_t	 pid;
+	uint32_t flags;
+	char	 className[SNAPSHOT_CLASS_MAX];
+	char	 instanceName[SNAPSHOT_CLASS_MAX];
+	char	 title[SNAPSHOT_TITLE_MAX];
+} SSnapshotClient;
+
+/*
+ * the region handed out by IPC_COMMAND_GET_SNAPSHOT, sequence is a seqlock
+ * that is odd while banana is writing, readers load it with acquire
+ * semantics, copy what they need, issue an acquire fence and retry if the
+ * sequence is odd or changed, the region can only be mapped read only.
+ * monitorTotal and clientTotal count everything banana manages, when they
+ * are above monitorCount or clientCount the arrays were cut short and the
+ * reader should fall back to IPC_COMMAND_GET_TREE
+ */
+typedef struct {
+	uint32_t	 magic;
+	uint32_t	 version;
+	uint32_t	 sequence;
+	uint32_t	 size;
+	uint64_t	 generation;
+	uint64_t	 focusedWindow;
+	int32_t		 focusedMonitor;
+	int32_t		 workspaceCount;
+	int32_t		 monitorCount;
+	int32_t		 clientCount;
+	int32_t		 monitorTotal;
+	int32_t		 clientTotal;
+	SSnapshotMonitor monitors[SNAPSHOT_MAX_MONITORS];
+	SSnapshotClient	 clients[SNAPSHOT_MAX_CLIENTS];
+} SSnapshot;
+
+int  snapshotGetFd(void);
+
+void snapshotPublish(void);
+
+void snapshotCleanup(void);
+
+#endif /* SNAPSHOT_H */
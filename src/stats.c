@@ -0,0 +1,197 @@
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "stats.h"
+#include "config.h"
+
+static SStats	   stats;
+static Display	  *statsDisplay = NULL;
+
+static const char *eventNames[STATS_EVENT_TYPES] = {
+    [KeyPress]			= "KeyPress",
+    [KeyRelease]		= "KeyRelease",
+    [ButtonPress]		= "ButtonPress",
+    [ButtonRelease]		= "ButtonRelease",
+    [MotionNotify]		= "MotionNotify",
+    [EnterNotify]		= "EnterNotify",
+    [LeaveNotify]		= "LeaveNotify",
+    [FocusIn]			= "FocusIn",
+    [FocusOut]			= "FocusOut",
+    [KeymapNotify]		= "KeymapNotify",
+    [Expose]			= "Expose",
+    [GraphicsExpose]		= "GraphicsExpose",
+    [NoExpose]			= "NoExpose",
+    [VisibilityNotify]		= "VisibilityNotify",
+    [CreateNotify]		= "CreateNotify",
+    [DestroyNotify]		= "DestroyNotify",
+    [UnmapNotify]		= "UnmapNotify",
+    [MapNotify]			= "MapNotify",
+    [MapRequest]		= "MapRequest",
+    [ReparentNotify]		= "ReparentNotify",
+    [ConfigureNotify]		= "ConfigureNotify",
+    [ConfigureRequest]		= "ConfigureRequest",
+    [GravityNotify]		= "GravityNotify",
+    [ResizeRequest]		= "ResizeRequest",
+    [CirculateNotify]		= "CirculateNotify",
+    [CirculateRequest]		= "CirculateRequest",
+    [PropertyNotify]		= "PropertyNotify",
+    [SelectionClear]		= "SelectionClear",
+    [SelectionRequest]		= "SelectionRequest",
+    [SelectionNotify]		= "SelectionNotify",
+    [ColormapNotify]		= "ColormapNotify",
+    [ClientMessage]		= "ClientMessage",
+    [MappingNotify]		= "MappingNotify",
+    [GenericEvent]		= "GenericEvent",
+    [STATS_EVENT_SCREEN_CHANGE] = "RRScreenChangeNotify",
+    [STATS_EVENT_SYNC_ALARM]	= "XSyncAlarmNotify"};
+
+static void	add(uint64_t *value, uint64_t amount)
+{
+	__atomic_store_n(value, *value + amount, __ATOMIC_RELAXED);
+}
+
+static int bucketIndex(uint64_t value)
+{
+	if (value < STATS_SUB_BUCKETS) {
+		return value;
+	}
+
+	int msb = 63 - __builtin_clzll(value);
+	if (msb >= STATS_MAX_BITS) {
+		return STATS_BUCKETS - 1;
+	}
+
+	int shift = msb - STATS_SUB_BITS;
+	return (shift + 1) * STATS_SUB_BUCKETS +
+	       ((value >> shift) & (STATS_SUB_BUCKETS - 1));
+}
+
+static uint64_t bucketValue(int index)
+{
+	if (index < STATS_SUB_BUCKETS) {
+		return index;
+	}
+
+	int	 shift = index / STATS_SUB_BUCKETS - 1;
+	uint64_t base =
+	    (uint64_t)(STATS_SUB_BUCKETS + index % STATS_SUB_BUCKETS) << shift;
+	return base + (((uint64_t)1 << shift) - 1);
+}
+
+static void record(SHistogram *histogram, uint64_t ns)
+{
+	uint32_t *bucket = &histogram->buckets[bucketIndex(ns)];
+
+	__atomic_store_n(bucket, *bucket + 1, __ATOMIC_RELAXED);
+	add(&histogram->count, 1);
+	add(&histogram->sum, ns);
+	if (ns > histogram->max) {
+		__atomic_store_n(&histogram->max, ns, __ATOMIC_RELAXED);
+	}
+}
+
+/*
+ * called by xlib after every request, the last reply or event read from the
+ * server only covers the request just issued when xlib had to wait for it
+ */
+static int afterRequest(Display *dpy)
+{
+	if (LastKnownRequestProcessed(dpy) == NextRequest(dpy) - 1) {
+		add(&stats.counters[STATS_ROUND_TRIPS], 1);
+	}
+	return 0;
+}
+
+uint64_t statsNow(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+void initStats(Display *dpy)
+{
+	statsDisplay = dpy;
+	XSetAfterFunction(dpy, afterRequest);
+	statsReset();
+}
+
+void statsRecordEvent(int type, uint64_t ns)
+{
+	if (type < 0 || type >= STATS_EVENT_TYPES) {
+		return;
+	}
+	record(&stats.events[type], ns);
+}
+
+void statsRunAction(void (*func)(const char *), const char *arg)
+{
+	uint64_t start = statsNow();
+
+	func(arg);
+
+	for (int i = 0; functionMap[i].name && i < STATS_MAX_ACTIONS; i++) {
+		if (functionMap[i].func == func) {
+			record(&stats.actions[i], statsNow() - start);
+			break;
+		}
+	}
+}
+
+void statsCount(EStatsCounter counter)
+{
+	add(&stats.counters[counter], 1);
+}
+
+void statsReset(void)
+{
+	memset(&stats, 0, sizeof(stats));
+	stats.since	  = statsNow();
+	stats.requestBase = statsDisplay ? NextRequest(statsDisplay) : 0;
+}
+
+uint64_t statsRequests(void)
+{
+	if (!statsDisplay) {
+		return 0;
+	}
+	return NextRequest(statsDisplay) - stats.requestBase;
+}
+
+uint64_t statsPercentile(const SHistogram *histogram, double quantile)
+{
+	if (!histogram->count) {
+		return 0;
+	}
+
+	uint64_t rank = quantile * histogram->count;
+	if (rank >= histogram->count) {
+		rank = histogram->count - 1;
+	}
+
+	uint64_t seen = 0;
+	for (int i = 0; i < STATS_BUCKETS; i++) {
+		seen += histogram->buckets[i];
+		if (seen > rank) {
+			uint64_t value = bucketValue(i);
+			return value < histogram->max ? value : histogram->max;
+		}
+	}
+
+	return histogram->max;
+}
+
+const char *statsEventName(int type)
+{
+	if (type < 0 || type >= STATS_EVENT_TYPES) {
+		return NULL;
+	}
+	return eventNames[type];
+}
+
+const SStats *getStats(void)
+{
+	return &stats;
+}
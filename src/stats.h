@@ -0,0 +1,71 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include <stdint.h>
+#include <X11/Xlib.h>
+
+#define STATS_SUB_BITS	  4
+#define STATS_SUB_BUCKETS (1 << STATS_SUB_BITS)
+#define STATS_MAX_BITS	  40
+#define STATS_BUCKETS                                                          \
+	((STATS_MAX_BITS - STATS_SUB_BITS + 1) * STATS_SUB_BUCKETS)
+#define STATS_MAX_ACTIONS 32
+
+#define STATS_EVENT_SCREEN_CHANGE LASTEvent
+#define STATS_EVENT_SYNC_ALARM	  (LASTEvent + 1)
+#define STATS_EVENT_TYPES	  (LASTEvent + 2)
+
+typedef enum {
+	STATS_ROUND_TRIPS,
+	STATS_ARRANGES,
+	STATS_BAR_REDRAWS,
+	STATS_COUNTERS
+} EStatsCounter;
+
+/*
+ * log linear histogram of durations in nanoseconds, values below
+ * STATS_SUB_BUCKETS are exact and every power of two above that is split in
+ * STATS_SUB_BUCKETS linear buckets so the relative error stays below 1/16,
+ * anything past 2^STATS_MAX_BITS lands in the last bucket
+ */
+typedef struct {
+	uint64_t count;
+	uint64_t sum;
+	uint64_t max;
+	uint32_t buckets[STATS_BUCKETS];
+} SHistogram;
+
+/*
+ * only the main thread records, every store is a relaxed atomic so a reader
+ * never sees a torn value and recording never takes a lock, events are
+ * indexed by X event type and actions by their functionMap index
+ */
+typedef struct {
+	uint64_t   since;
+	uint64_t   requestBase;
+	uint64_t   counters[STATS_COUNTERS];
+	SHistogram events[STATS_EVENT_TYPES];
+	SHistogram actions[STATS_MAX_ACTIONS];
+} SStats;
+
+uint64_t      statsNow(void);
+
+void	      initStats(Display *dpy);
+
+void	      statsRecordEvent(int type, uint64_t ns);
+
+void	      statsRunAction(void (*func)(const char *), const char *arg);
+
+void	      statsCount(EStatsCounter counter);
+
+void	      statsReset(void);
+
+uint64_t      statsRequests(void);
+
+uint64_t      statsPercentile(const SHistogram *histogram, double quantile);
+
+const char   *statsEventName(int type);
+
+const SStats *getStats(void);
+
+#endif /* STATS_H */
@@ -0,0 +1,211 @@
+#include <stdio.h>
+#include <string.h>
+#include <X11/Xlib.h>
+#include <X11/extensions/sync.h>
+
+#include "syncrequest.h"
+#include "backend.h"
+#include "banana.h"
+#include "log.h"
+#include "stats.h"
+
+static int syncAvailable = 0;
+static int syncEventBase = 0;
+
+int	   initSyncRequest(void)
+{
+	int errorBase, major, minor;
+
+	if (!XSyncQueryExtension(display, &syncEventBase, &errorBase) ||
+	    !XSyncInitialize(display, &major, &minor)) {
+		LOG_WARN("banana: XSync extension not available, resizes "
+			 "will not wait for clients to repaint\n");
+		return 0;
+	}
+
+	syncAvailable = 1;
+	return 1;
+}
+
+int syncRequestAvailable(void)
+{
+	return syncAvailable;
+}
+
+static uint64_t syncValueToInt(XSyncValue value)
+{
+	return ((uint64_t)(uint32_t)XSyncValueHigh32(value) << 32) |
+	       XSyncValueLow32(value);
+}
+
+static int clientSupportsSync(SClient *client)
+{
+	int   n;
+	Atom *protocols;
+	int   exists = 0;
+
+	if (backend->getWMProtocols(display, client->window, &protocols, &n)) {
+		while (!exists && n--) {
+			exists = protocols[n] == NET_WM_SYNC_REQUEST;
+		}
+		XFree(protocols);
+	}
+
+	return exists;
+}
+
+/* the first counter is the basic one, a second is for extended sync */
+static XSyncCounter getSyncCounter(SClient *client)
+{
+	Atom	       actualType;
+	int	       actualFormat;
+	unsigned long  nitems, bytesAfter;
+	unsigned char *data    = NULL;
+	XSyncCounter   counter = None;
+
+	if (backend->getWindowProperty(
+		display, client->window, NET_WM_SYNC_REQUEST_COUNTER, 0, 2,
+		False, XA_CARDINAL, &actualType, &actualFormat, &nitems,
+		&bytesAfter, &data) == Success &&
+	    data) {
+		if (actualFormat == 32 && nitems > 0) {
+			counter = ((unsigned long *)data)[0];
+		}
+		XFree(data);
+	}
+
+	return counter;
+}
+
+/*
+ * done once per resize, the alarm starts at the counter's current value so
+ * only the values asked for from here on trigger it
+ */
+static int prepareSyncRequest(SClient *client)
+{
+	if (client->syncState != SYNC_REQUEST_UNCHECKED) {
+		return client->syncState == SYNC_REQUEST_READY;
+	}
+
+	client->syncState = SYNC_REQUEST_UNSUPPORTED;
+
+	if (!clientSupportsSync(client)) {
+		return 0;
+	}
+
+	XSyncCounter counter = getSyncCounter(client);
+	XSyncValue   value;
+	if (!counter || !XSyncQueryCounter(display, counter, &value)) {
+		return 0;
+	}
+
+	XSyncAlarmAttributes attrs;
+	attrs.trigger.counter	 = counter;
+	attrs.trigger.value_type = XSyncAbsolute;
+	attrs.trigger.wait_value = value;
+	attrs.trigger.test_type	 = XSyncPositiveComparison;
+	attrs.events		 = True;
+	XSyncIntToValue(&attrs.delta, 0);
+
+	client->syncAlarm =
+	    XSyncCreateAlarm(display,
+			     XSyncCACounter | XSyncCAValueType | XSyncCAValue |
+				 XSyncCATestType | XSyncCADelta | XSyncCAEvents,
+			     &attrs);
+	if (!client->syncAlarm) {
+		return 0;
+	}
+
+	client->syncValue = syncValueToInt(value);
+	client->syncState = SYNC_REQUEST_READY;
+
+	LOG_DEBUG("Using sync counter 0x%lx for window 0x%lx\n", counter,
+		  client->window);
+	return 1;
+}
+
+void sendSyncRequest(SClient *client)
+{
+	if (!syncAvailable || !prepareSyncRequest(client)) {
+		return;
+	}
+
+	client->syncValue++;
+
+	XSyncValue value;
+	XSyncIntsToValue(&value, (unsigned int)client->syncValue,
+			 (int)(client->syncValue >> 32));
+
+	/* changed first, the client can only answer after the message */
+	XSyncAlarmAttributes attrs;
+	attrs.trigger.wait_value = value;
+	XSyncChangeAlarm(display, client->syncAlarm, XSyncCAValue, &attrs);
+
+	XEvent ev;
+	memset(&ev, 0, sizeof(ev));
+	ev.type			= ClientMessage;
+	ev.xclient.window	= client->window;
+	ev.xclient.message_type = WM_PROTOCOLS;
+	ev.xclient.format	= 32;
+	ev.xclient.data.l[0]	= NET_WM_SYNC_REQUEST;
+	ev.xclient.data.l[1]	= CurrentTime;
+	ev.xclient.data.l[2]	= XSyncValueLow32(value);
+	ev.xclient.data.l[3]	= XSyncValueHigh32(value);
+	backend->sendEvent(display, client->window, False, NoEventMask, &ev);
+
+	client->syncWaiting = 1;
+	client->syncSent    = statsNow();
+}
+
+int syncRequestWait(SClient *client)
+{
+	if (!client->syncWaiting) {
+		return 0;
+	}
+
+	uint64_t elapsed = (statsNow() - client->syncSent) / 1000000;
+	if (elapsed >= SYNC_REQUEST_TIMEOUT_MS) {
+		LOG_DEBUG("Window 0x%lx did not answer a sync request in "
+			  "time\n",
+			  client->window);
+		client->syncWaiting = 0;
+		return 0;
+	}
+
+	return SYNC_REQUEST_TIMEOUT_MS - (int)elapsed;
+}
+
+int handleSyncAlarm(XEvent *event)
+{
+	if (!syncAvailable || event->type != syncEventBase + XSyncAlarmNotify) {
+		return 0;
+	}
+
+	XSyncAlarmNotifyEvent *ev = (XSyncAlarmNotifyEvent *)event;
+
+	uint64_t	       value = syncValueToInt(ev->counter_value);
+
+	/* the alarm also fires for values reached before the last request */
+	for (SClient *client = clients; client; client = client->next) {
+		if (client->syncAlarm == ev->alarm) {
+			if (value >= client->syncValue) {
+				client->syncWaiting = 0;
+			}
+			break;
+		}
+	}
+
+	return 1;
+}
+
+void endSyncRequest(SClient *client)
+{
+	if (client->syncAlarm) {
+		XSyncDestroyAlarm(display, client->syncAlarm);
+	}
+
+	client->syncAlarm   = None;
+	client->syncValue   = 0;
+	client->syncWaiting = 0;
+	client->syncState   = SYNC_REQUEST_UNCHECKED;
+}
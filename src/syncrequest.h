@@ -0,0 +1,36 @@
+#ifndef SYNCREQUEST_H
+#define SYNCREQUEST_H
+
+#include <X11/Xlib.h>
+
+#include "banana.h"
+
+#define SYNC_REQUEST_TIMEOUT_MS 100
+
+typedef enum {
+	SYNC_REQUEST_UNCHECKED,
+	SYNC_REQUEST_UNSUPPORTED,
+	SYNC_REQUEST_READY
+} ESyncRequestState;
+
+/*
+ * _NET_WM_SYNC_REQUEST, every configure of an interactive resize is preceded
+ * by a request to raise the client's XSync counter to the next value once
+ * it has repainted, an alarm on that counter reports when it did and until
+ * then or SYNC_REQUEST_TIMEOUT_MS the next configure is held back
+ */
+int  initSyncRequest(void);
+
+int  syncRequestAvailable(void);
+
+void sendSyncRequest(SClient *client);
+
+/* milliseconds left until the client has answered or timed out, or 0 */
+int syncRequestWait(SClient *client);
+
+/* returns 0 when the event is not an alarm notify */
+int  handleSyncAlarm(XEvent *event);
+
+void endSyncRequest(SClient *client);
+
+#endif /* SYNCREQUEST_H */
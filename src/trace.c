@@ -0,0 +1,193 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+
+#include "trace.h"
+#include "stats.h"
+#include "log.h"
+
+static STraceSpan	    *ring	   = NULL;
+static uint64_t		     ringHead	   = 0;
+static unsigned		     dumpCount	   = 0;
+static volatile sig_atomic_t dumpRequested = 0;
+
+static const char *categoryNames[] = {"x11", "ipc", "arrange", "bar", "spawn"};
+
+static void	   requestDump(int sig)
+{
+	(void)sig;
+	dumpRequested = 1;
+}
+
+static void defaultPath(char *path, size_t size)
+{
+	const char *dir = getenv("XDG_RUNTIME_DIR");
+	if (!dir || !*dir) {
+		dir = "/tmp";
+	}
+
+	snprintf(path, size, "%s/banana-trace-%d-%u.json", dir, (int)getpid(),
+		 dumpCount);
+}
+
+static void writeSpans(FILE *fp)
+{
+	int	 pid   = getpid();
+	uint64_t first = ringHead > TRACE_RING_SIZE ? ringHead - TRACE_RING_SIZE
+						    : 0;
+
+	fprintf(fp,
+		"{\"displayTimeUnit\":\"ms\",\"traceEvents\":[{\"name\":"
+		"\"process_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%d,"
+		"\"args\":{\"name\":\"banana\"}}",
+		pid, pid);
+
+	for (uint64_t i = first; i < ringHead; i++) {
+		STraceSpan *span = &ring[i % TRACE_RING_SIZE];
+
+		fprintf(fp,
+			",\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\","
+			"\"ts\":%llu.%03llu,\"dur\":%llu.%03llu,\"pid\":%d,"
+			"\"tid\":%d,\"args\":{\"arg\":%llu}}",
+			span->name ? span->name : "unknown",
+			categoryNames[span->category],
+			(unsigned long long)(span->start / 1000),
+			(unsigned long long)(span->start % 1000),
+			(unsigned long long)((span->end - span->start) / 1000),
+			(unsigned long long)((span->end - span->start) % 1000),
+			pid, pid, (unsigned long long)span->arg);
+	}
+
+	fprintf(fp, "]}\n");
+}
+
+void initTrace(void)
+{
+	struct sigaction sa;
+
+	memset(&sa, 0, sizeof(sa));
+	sa.sa_handler = requestDump;
+	sigemptyset(&sa.sa_mask);
+	sigaction(SIGUSR1, &sa, NULL);
+
+	const char *env = getenv("BANANA_TRACE");
+	if (env && *env && strcmp(env, "0") != 0) {
+		startTrace();
+	}
+}
+
+int startTrace(void)
+{
+	if (!ring) {
+		ring = malloc(TRACE_RING_SIZE * sizeof(STraceSpan));
+		if (!ring) {
+			LOG_ERROR("Failed to allocate trace buffer\n");
+			return -1;
+		}
+	}
+
+	ringHead = 0;
+	LOG_INFO("Tracing started\n");
+	return 0;
+}
+
+void stopTrace(void)
+{
+	free(ring);
+	ring	 = NULL;
+	ringHead = 0;
+}
+
+uint64_t traceBegin(void)
+{
+	return ring ? statsNow() : 0;
+}
+
+void traceEnd(ETraceCategory category, const char *name, uint64_t arg,
+	      uint64_t start)
+{
+	if (start) {
+		traceSpan(category, name, arg, start, statsNow());
+	}
+}
+
+void traceSpan(ETraceCategory category, const char *name, uint64_t arg,
+	       uint64_t start, uint64_t end)
+{
+	if (!ring) {
+		return;
+	}
+
+	STraceSpan *span = &ring[ringHead++ % TRACE_RING_SIZE];
+	span->name	 = name;
+	span->start	 = start;
+	span->end	 = end;
+	span->arg	 = arg;
+	span->category	 = category;
+}
+
+int dumpTrace(const char *path, char *written, size_t size)
+{
+	char fallback[TRACE_PATH_MAX];
+
+	if (!ring) {
+		snprintf(written, size, "Tracing is not running");
+		return -1;
+	}
+
+	if (!path || !*path) {
+		defaultPath(fallback, sizeof(fallback));
+		path = fallback;
+	}
+
+	int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+	if (fd == -1) {
+		snprintf(written, size, "Failed to open %s: %s", path,
+			 strerror(errno));
+		return -1;
+	}
+
+	FILE *fp = fdopen(fd, "w");
+	if (!fp) {
+		snprintf(written, size, "Failed to open %s: %s", path,
+			 strerror(errno));
+		close(fd);
+		return -1;
+	}
+
+	writeSpans(fp);
+	if (fclose(fp) != 0) {
+		snprintf(written, size, "Failed to write %s: %s", path,
+			 strerror(errno));
+		return -1;
+	}
+
+	dumpCount++;
+	snprintf(written, size, "%s", path);
+	return 0;
+}
+
+void handleTraceSignal(void)
+{
+	char message[TRACE_PATH_MAX + 64];
+
+	if (!dumpRequested) {
+		return;
+	}
+	dumpRequested = 0;
+
+	if (dumpTrace(NULL, message, sizeof(message)) == -1) {
+		LOG_WARN("banana: %s\n", message);
+		return;
+	}
+	LOG_INFO("Trace written to %s\n", message);
+}
+
+void cleanupTrace(void)
+{
+	stopTrace();
+}
@@ -0,0 +1,55 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define TRACE_RING_SIZE 65536
+#define TRACE_PATH_MAX	4096
+
+typedef enum {
+	TRACE_X11,
+	TRACE_IPC,
+	TRACE_ARRANGE,
+	TRACE_BAR,
+	TRACE_SPAWN
+} ETraceCategory;
+
+/*
+ * a finished span, name must point at a string that outlives the ring since
+ * it is only formatted when the trace is written out
+ */
+typedef struct {
+	const char *name;
+	uint64_t    start;
+	uint64_t    end;
+	uint64_t    arg;
+	uint32_t    category;
+} STraceSpan;
+
+/*
+ * tracing is off unless BANANA_TRACE is set or it is started over ipc, the
+ * ring holds the last TRACE_RING_SIZE spans and is written as chrome trace
+ * event json on demand or when banana receives SIGUSR1
+ */
+void	 initTrace(void);
+
+int	 startTrace(void);
+
+void	 stopTrace(void);
+
+uint64_t traceBegin(void);
+
+void	 traceEnd(ETraceCategory category, const char *name, uint64_t arg,
+		  uint64_t start);
+
+void	 traceSpan(ETraceCategory category, const char *name, uint64_t arg,
+		   uint64_t start, uint64_t end);
+
+int	 dumpTrace(const char *path, char *written, size_t size);
+
+void	 handleTraceSignal(void);
+
+void	 cleanupTrace(void);
+
+#endif /* TRACE_H */